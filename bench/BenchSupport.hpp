@@ -0,0 +1,115 @@
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Trading
+{
+class SplitMix64;
+class LatencyStats;
+}  // namespace Trading
+
+// Small seeded generator whose sequence is fixed by its definition rather
+// than by the standard library, so a seed produces the same workload on
+// every compiler and commit.
+class Trading::SplitMix64 final
+{
+   public:
+    explicit SplitMix64(const std::uint64_t seed) noexcept : m_state(seed) {}
+
+    std::uint64_t Next() noexcept
+    {
+        std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [low, high]; the modulo bias is irrelevant here.
+    std::uint64_t Between(const std::uint64_t low,
+                          const std::uint64_t high) noexcept
+    {
+        return low + Next() % (high - low + 1);
+    }
+
+    // True with the given probability in percent.
+    bool Percent(const std::uint64_t percent) noexcept
+    {
+        return Next() % 100 < percent;
+    }
+
+   private:
+    std::uint64_t m_state;
+};
+
+// Collects per-operation latencies in nanoseconds and prints throughput and
+// tail percentiles. Samples are stored raw and sorted once when reporting.
+class Trading::LatencyStats final
+{
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit LatencyStats(const std::size_t expected = 0)
+    {
+        m_samples.reserve(expected);
+    }
+
+    void Add(const Clock::time_point start, const Clock::time_point end)
+    {
+        m_sorted = false;
+        m_samples.push_back(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                .count()));
+    }
+
+    [[nodiscard]] std::size_t Count() const noexcept
+    {
+        return m_samples.size();
+    }
+
+    // Latency below which the given fraction of samples fall.
+    [[nodiscard]] std::uint64_t Percentile(const double fraction)
+    {
+        if (m_samples.empty())
+        {
+            return 0;
+        }
+        Sort();
+        const auto rank = static_cast<std::size_t>(
+            fraction * static_cast<double>(m_samples.size() - 1));
+        return m_samples[rank];
+    }
+
+    // Prints one line: throughput from the untimed run's wall time, then
+    // the percentiles of the timed run.
+    void Report(const std::string& name, const std::size_t operations,
+                const double seconds)
+    {
+        std::cout << name << ": " << operations / seconds / 1e6
+                  << " M ops/s, p50 " << Percentile(0.5) << " ns, p99 "
+                  << Percentile(0.99) << " ns, p99.9 " << Percentile(0.999)
+                  << " ns, max " << Percentile(1.0) << " ns\n";
+    }
+
+   private:
+    void Sort()
+    {
+        if (!m_sorted)
+        {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+    }
+
+   private:
+    std::vector<std::uint64_t> m_samples;
+    bool m_sorted = false;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchSupport.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::uint64_t kMidPrice = 100000;
+
+// Orders from 1000 traders within 20 ticks of the mid, half of them
+// crossing the spread, so the book stays shallow and the fixed per-call
+// cost is a visible share of each order.
+std::vector<TradeOrder> Orders(const std::size_t count,
+                               const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    std::vector<TradeOrder> orders;
+    orders.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const bool buy = rng.Next() & 1;
+        const std::uint64_t offset = rng.Between(1, 20);
+        const bool cross = rng.Percent(50);
+        orders.push_back(
+            TradeOrder{"T" + std::to_string(rng.Between(1, 1000)),
+                       buy ? 'B' : 'S', rng.Between(1, 100),
+                       buy == cross ? kMidPrice + offset : kMidPrice - offset});
+    }
+    return orders;
+}
+
+// Orders per second through a fresh locked engine, one ProcessOrders call
+// per batch, or one ProcessOrder call per order when batch is 0.
+double Throughput(const std::vector<TradeOrder>& orders,
+                  const BookType bookType, const std::size_t batch)
+{
+    TradeEngine engine(bookType);
+    engine.SetTradeHistory(false);
+    engine.SetTradeSink([](std::string_view) {});
+    engine.Preallocate(orders.size(), 1024);
+    std::vector<OrderResult> results(std::max<std::size_t>(batch, 1));
+
+    const auto start = LatencyStats::Clock::now();
+    if (batch == 0)
+    {
+        for (const TradeOrder& order : orders)
+        {
+            engine.ProcessOrder(order);
+        }
+    }
+    else
+    {
+        const Span<const TradeOrder> all(orders);
+        for (std::size_t offset = 0; offset < orders.size(); offset += batch)
+        {
+            const std::size_t count =
+                std::min(batch, orders.size() - offset);
+            engine.ProcessOrders(all.subspan(offset, count), results);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(
+                               LatencyStats::Clock::now() - start)
+                               .count();
+    return orders.size() / seconds;
+}
+}  // namespace
+
+// Usage: BatchBenchmark [orders] [seed]
+int main(int argc, char* argv[])
+{
+    const std::size_t count =
+        argc > 1 ? std::stoull(argv[1]) : std::size_t{1000000};
+    const std::uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 42;
+    const std::vector<TradeOrder> orders = Orders(count, seed);
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        const char* const name =
+            bookType == BookType::Tree ? "tree" : "ladder";
+        const double single = Throughput(orders, bookType, 0);
+        std::cout << name << " ProcessOrder: " << single / 1e6
+                  << " M orders/s\n";
+        for (std::size_t batch = 1; batch <= 1024; batch *= 4)
+        {
+            const double batched = Throughput(orders, bookType, batch);
+            std::cout << name << " ProcessOrders batch " << batch << ": "
+                      << batched / 1e6 << " M orders/s ("
+                      << (batched / single - 1) * 100 << "%)\n";
+        }
+    }
+    return 0;
+}
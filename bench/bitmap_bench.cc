@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BenchSupport.hpp"
+#include "OccupancyBitmap.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::size_t kTicks = std::size_t{1} << 20;
+constexpr int kRounds = 20;
+
+// Same size as a PriceLadder level, so the scan touches as much memory as
+// the ladder did before it had a bitmap.
+struct Tick
+{
+    std::uint32_t head = 0;
+    std::uint32_t tail = 0;
+    std::uint32_t orders = 0;
+    std::uint64_t quantity = 0;
+};
+
+// Sorted distinct tick positions.
+std::vector<std::size_t> Positions(const std::size_t levels,
+                                   const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    std::vector<std::size_t> positions;
+    positions.reserve(levels * 2);
+    while (positions.size() < levels * 2)
+    {
+        positions.push_back(rng.Next() % kTicks);
+    }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()),
+                    positions.end());
+    positions.resize(std::min(positions.size(), levels));
+    return positions;
+}
+
+double NanosSince(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Each Drain function empties the side best (lowest) level first, finding
+// the next best level after every removal, and returns the time per level.
+double DrainBitmap(const std::vector<std::size_t>& positions,
+                   std::size_t& checksum)
+{
+    double total = 0;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        OccupancyBitmap bitmap(kTicks);
+        for (const std::size_t position : positions)
+        {
+            bitmap.Set(position);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t best = bitmap.First(); best != OccupancyBitmap::kNone;
+             best = bitmap.NextFrom(best))
+        {
+            checksum += best;
+            bitmap.Clear(best);
+        }
+        total += NanosSince(start);
+    }
+    return total / kRounds / positions.size();
+}
+
+double DrainScan(const std::vector<std::size_t>& positions,
+                 std::size_t& checksum)
+{
+    double total = 0;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        std::vector<Tick> ticks(kTicks);
+        for (const std::size_t position : positions)
+        {
+            ticks[position].orders = 1;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t best = positions.front();
+        for (std::size_t left = positions.size(); left > 0; --left)
+        {
+            checksum += best;
+            ticks[best].orders = 0;
+            if (left > 1)
+            {
+                while (ticks[++best].orders == 0)
+                {
+                }
+            }
+        }
+        total += NanosSince(start);
+    }
+    return total / kRounds / positions.size();
+}
+
+double DrainMap(const std::vector<std::size_t>& positions,
+                std::size_t& checksum)
+{
+    double total = 0;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        std::map<std::uint64_t, Tick> levels;
+        for (const std::size_t position : positions)
+        {
+            levels.emplace(position, Tick{});
+        }
+        const auto start = std::chrono::steady_clock::now();
+        while (!levels.empty())
+        {
+            checksum += levels.begin()->first;
+            levels.erase(levels.begin());
+        }
+        total += NanosSince(start);
+    }
+    return total / kRounds / positions.size();
+}
+
+// Each Walk function visits every level in price order without changing
+// anything, as depth export does, and returns the time per level.
+double WalkBitmap(const std::vector<std::size_t>& positions,
+                  std::size_t& checksum)
+{
+    OccupancyBitmap bitmap(kTicks);
+    for (const std::size_t position : positions)
+    {
+        bitmap.Set(position);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round)
+    {
+        for (std::size_t position = bitmap.First();
+             position != OccupancyBitmap::kNone;
+             position = bitmap.NextFrom(position + 1))
+        {
+            checksum += position;
+        }
+    }
+    return NanosSince(start) / kRounds / positions.size();
+}
+
+double WalkScan(const std::vector<std::size_t>& positions,
+                std::size_t& checksum)
+{
+    std::vector<Tick> ticks(kTicks);
+    for (const std::size_t position : positions)
+    {
+        ticks[position].orders = 1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round)
+    {
+        for (std::size_t position = 0; position < kTicks; ++position)
+        {
+            if (ticks[position].orders != 0)
+            {
+                checksum += position;
+            }
+        }
+    }
+    return NanosSince(start) / kRounds / positions.size();
+}
+
+double WalkMap(const std::vector<std::size_t>& positions,
+               std::size_t& checksum)
+{
+    std::map<std::uint64_t, Tick> levels;
+    for (const std::size_t position : positions)
+    {
+        levels.emplace(position, Tick{});
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round)
+    {
+        for (const auto& level : levels)
+        {
+            checksum += level.first;
+        }
+    }
+    return NanosSince(start) / kRounds / positions.size();
+}
+}  // namespace
+
+// Usage: BitmapBenchmark [seed]
+// Compares finding the next non-empty level with OccupancyBitmap, with a
+// linear scan over ladder ticks and with std::map navigation, for books of
+// increasing density spread over 2^20 ticks.
+int main(int argc, char* argv[])
+{
+    const std::uint64_t seed = argc > 1 ? std::stoull(argv[1]) : 1;
+    std::size_t checksum = 0;
+
+    std::cout << "ns per level over " << kTicks << " ticks, " << kRounds
+              << " rounds; drain removes the best level and finds the next, "
+                 "walk visits every level in order\n";
+    for (const std::size_t levels : {100, 1000, 10000, 100000})
+    {
+        const std::vector<std::size_t> positions = Positions(levels, seed);
+        std::cout << "levels " << positions.size() << ": drain bitmap "
+                  << DrainBitmap(positions, checksum) << ", tick scan "
+                  << DrainScan(positions, checksum) << ", std::map "
+                  << DrainMap(positions, checksum) << "; walk bitmap "
+                  << WalkBitmap(positions, checksum) << ", tick scan "
+                  << WalkScan(positions, checksum) << ", std::map "
+                  << WalkMap(positions, checksum) << "\n";
+    }
+    // Keeps the loops from being optimised away.
+    return checksum == 0 ? 1 : 0;
+}
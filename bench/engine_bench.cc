@@ -0,0 +1,379 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BenchSupport.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::uint64_t kMidPrice = 100000;
+
+struct Operation
+{
+    enum class Kind
+    {
+        Order,
+        Cancel
+    };
+
+    Kind kind;
+    TradeOrder order;
+    // For Cancel, the index of the operation that entered the order.
+    std::size_t target;
+};
+
+using Workload = std::vector<Operation>;
+
+TradeOrder MakeOrder(const std::uint64_t trader, const char side,
+                     const std::uint64_t quantity, const std::uint64_t price)
+{
+    return TradeOrder{"T" + std::to_string(trader), side, quantity, price};
+}
+
+// Passive orders spread over 500 ticks either side of the mid, with one
+// order in a hundred crossing the spread. The book keeps growing.
+Workload DeepBook(const std::size_t count, const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    Workload workload;
+    workload.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const bool buy = rng.Next() & 1;
+        const std::uint64_t offset = rng.Between(1, 500);
+        const bool cross = rng.Percent(1);
+        const std::uint64_t price =
+            buy == cross ? kMidPrice + offset : kMidPrice - offset;
+        workload.push_back({Operation::Kind::Order,
+                            MakeOrder(rng.Between(1, 1000), buy ? 'B' : 'S',
+                                      rng.Between(1, 100), price),
+                            0});
+    }
+    return workload;
+}
+
+// Rounds of 200 resting sells over 200 ticks, each round cleared by one
+// buy that sweeps every level.
+Workload Sweeps(const std::size_t count, const std::uint64_t seed)
+{
+    constexpr std::size_t kRestingPerRound = 200;
+    SplitMix64 rng(seed);
+    Workload workload;
+    workload.reserve(count);
+    while (workload.size() < count)
+    {
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < kRestingPerRound; ++i)
+        {
+            const std::uint64_t quantity = rng.Between(1, 100);
+            total += quantity;
+            workload.push_back(
+                {Operation::Kind::Order,
+                 MakeOrder(rng.Between(1, 64), 'S', quantity,
+                           kMidPrice + rng.Between(1, kRestingPerRound)),
+                 0});
+        }
+        workload.push_back({Operation::Kind::Order,
+                            MakeOrder(rng.Between(65, 128), 'B', total,
+                                      kMidPrice + kRestingPerRound),
+                            0});
+    }
+    workload.resize(count);
+    return workload;
+}
+
+// Sixty percent of operations cancel a random live order, the rest add
+// non-crossing orders, so the book stays at a steady size.
+Workload CancelHeavy(const std::size_t count, const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    Workload workload;
+    workload.reserve(count);
+    std::vector<std::size_t> live;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!live.empty() && rng.Percent(60))
+        {
+            const std::size_t pick = rng.Next() % live.size();
+            workload.push_back({Operation::Kind::Cancel, {}, live[pick]});
+            live[pick] = live.back();
+            live.pop_back();
+            continue;
+        }
+        const bool buy = rng.Next() & 1;
+        const std::uint64_t offset = rng.Between(1, 200);
+        live.push_back(i);
+        workload.push_back(
+            {Operation::Kind::Order,
+             MakeOrder(rng.Between(1, 1000), buy ? 'B' : 'S',
+                       rng.Between(1, 100),
+                       buy ? kMidPrice - offset : kMidPrice + offset),
+             0});
+    }
+    return workload;
+}
+
+// Crossing flow from 100000 distinct traders around a narrow spread.
+Workload ManyTraders(const std::size_t count, const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    Workload workload;
+    workload.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        workload.push_back(
+            {Operation::Kind::Order,
+             MakeOrder(rng.Between(1, 100000), rng.Next() & 1 ? 'B' : 'S',
+                       rng.Between(1, 100),
+                       rng.Between(kMidPrice - 50, kMidPrice + 50)),
+             0});
+    }
+    return workload;
+}
+
+std::vector<std::string> ToLines(const Workload& workload)
+{
+    std::vector<std::string> lines;
+    lines.reserve(workload.size());
+    for (const Operation& operation : workload)
+    {
+        const TradeOrder& order = operation.order;
+        lines.push_back(order.identifier + ' ' + order.side + ' ' +
+                        std::to_string(order.quantity) + ' ' +
+                        std::to_string(order.price));
+    }
+    return lines;
+}
+
+// Limits no benchmark order reaches, so that every order pays for the checks
+// without being rejected.
+constexpr RiskLimits kLooseLimits{std::uint64_t{1} << 32,
+                                  std::uint64_t{1} << 48,
+                                  std::uint64_t{1} << 62};
+
+// How an engine workload is run: with trades formatted for a trade sink,
+// the same plus self-trade prevention and the per-trader risk checks, or
+// with only the unformatted fills going to a fill sink.
+enum class Variant
+{
+    Text,
+    Risk,
+    Fills
+};
+
+// Replays the workload on a fresh engine, timing each operation when stats
+// is given. Returns the wall time of the whole replay.
+double Replay(const BookType bookType, const Workload& workload,
+              const Variant variant, LatencyStats* stats)
+{
+    TradeEngine engine(bookType);
+    engine.SetTradeHistory(false);
+    if (variant == Variant::Risk)
+    {
+        engine.SetSelfTradePrevention(SelfTradePrevention::CancelResting);
+        engine.SetRiskLimits(kLooseLimits);
+    }
+    std::size_t output = 0;
+    if (variant == Variant::Fills)
+    {
+        engine.SetFillSink([&output](const Fill*, const std::size_t count)
+                           { output += count; });
+    }
+    else
+    {
+        engine.SetTradeSink([&output](const std::string_view trades)
+                            { output += trades.size(); });
+    }
+    std::vector<OrderId> ids(workload.size());
+
+    const auto start = LatencyStats::Clock::now();
+    for (std::size_t i = 0; i < workload.size(); ++i)
+    {
+        const Operation& operation = workload[i];
+        const auto before = stats ? LatencyStats::Clock::now()
+                                  : LatencyStats::Clock::time_point{};
+        if (operation.kind == Operation::Kind::Order)
+        {
+            ids[i] = engine.ProcessOrder(operation.order);
+        }
+        else
+        {
+            engine.Cancel(ids[operation.target]);
+        }
+        if (stats)
+        {
+            stats->Add(before, LatencyStats::Clock::now());
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+        LatencyStats::Clock::now() - start;
+    return elapsed.count();
+}
+
+void RunEngine(const char* name, const Workload& workload,
+               const std::vector<Variant>& variants)
+{
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        for (const Variant variant : variants)
+        {
+            const double seconds = Replay(bookType, workload, variant, nullptr);
+            LatencyStats stats(workload.size());
+            Replay(bookType, workload, variant, &stats);
+            const char* const book =
+                bookType == BookType::Tree ? " tree" : " ladder";
+            const char* const suffix = variant == Variant::Risk    ? "+risk"
+                                       : variant == Variant::Fills ? "+fills"
+                                                                   : "";
+            stats.Report(std::string(name) + book + suffix, workload.size(),
+                         seconds);
+        }
+    }
+}
+
+// Deals the workload's orders round robin to books single-writer engines
+// on this thread, as a ShardedEngine shard serving several instruments
+// does. Returns the wall time of the whole replay.
+double ReplayBooks(const Workload& workload, const std::size_t books,
+                   LatencyStats* stats)
+{
+    std::vector<std::unique_ptr<TradeEngine>> engines;
+    std::size_t output = 0;
+    for (std::size_t book = 0; book < books; ++book)
+    {
+        engines.push_back(std::make_unique<TradeEngine>(
+            BookType::Tree, ConcurrencyMode::SingleWriter));
+        engines.back()->SetTradeHistory(false);
+        engines.back()->SetTradeSink([&output](const std::string_view trades)
+                                     { output += trades.size(); });
+    }
+
+    const auto start = LatencyStats::Clock::now();
+    for (std::size_t i = 0; i < workload.size(); ++i)
+    {
+        const auto before = stats ? LatencyStats::Clock::now()
+                                  : LatencyStats::Clock::time_point{};
+        engines[i % books]->ProcessOrder(workload[i].order);
+        if (stats)
+        {
+            stats->Add(before, LatencyStats::Clock::now());
+        }
+    }
+    const std::chrono::duration<double> elapsed =
+        LatencyStats::Clock::now() - start;
+    return elapsed.count();
+}
+
+void RunBooks(const Workload& workload)
+{
+    for (const std::size_t books : {1, 2, 16})
+    {
+        const double seconds = ReplayBooks(workload, books, nullptr);
+        LatencyStats stats(workload.size());
+        ReplayBooks(workload, books, &stats);
+        stats.Report("deep book over " + std::to_string(books) +
+                         " books, one thread",
+                     workload.size(), seconds);
+    }
+}
+
+void RunParser(const Workload& workload)
+{
+    const std::vector<std::string> lines = ToLines(workload);
+    TradeEngine engine;
+
+    auto start = LatencyStats::Clock::now();
+    for (const std::string& line : lines)
+    {
+        static_cast<void>(engine.ParseInput(line));
+    }
+    const std::chrono::duration<double> elapsed =
+        LatencyStats::Clock::now() - start;
+
+    LatencyStats stats(lines.size());
+    for (const std::string& line : lines)
+    {
+        start = LatencyStats::Clock::now();
+        static_cast<void>(engine.ParseInput(line));
+        stats.Add(start, LatencyStats::Clock::now());
+    }
+    stats.Report("ParseInput", lines.size(), elapsed.count());
+}
+
+bool Selected(const int argc, char* argv[], const char* name)
+{
+    if (argc <= 3)
+    {
+        return true;
+    }
+    for (int i = 3; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+// Usage: EngineBenchmark [operations] [seed] [workload...]
+// Workloads: deep sweep cancel traders books parse. All run when none is
+// named; books interleaves the deep book over several engines.
+// Naming risk as well repeats each engine workload with self-trade
+// prevention and risk checks on; naming fills repeats it with a fill sink
+// in place of the formatted trades.
+int main(int argc, char* argv[])
+{
+    const std::size_t count =
+        argc > 1 ? std::stoull(argv[1]) : std::size_t{1000000};
+    const std::uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+    std::vector<Variant> variants{Variant::Text};
+    if (Selected(argc, argv, "risk"))
+    {
+        variants.push_back(Variant::Risk);
+    }
+    if (Selected(argc, argv, "fills"))
+    {
+        variants.push_back(Variant::Fills);
+    }
+
+    std::cout << count << " operations per workload, seed " << seed
+              << "; throughput from an untimed run, latency per operation "
+                 "including clock overhead\n";
+    if (Selected(argc, argv, "deep"))
+    {
+        RunEngine("deep book", DeepBook(count, seed), variants);
+    }
+    if (Selected(argc, argv, "sweep"))
+    {
+        RunEngine("sweeps", Sweeps(count, seed), variants);
+    }
+    if (Selected(argc, argv, "cancel"))
+    {
+        RunEngine("cancel heavy", CancelHeavy(count, seed), variants);
+    }
+    if (Selected(argc, argv, "traders"))
+    {
+        RunEngine("many traders", ManyTraders(count, seed), variants);
+    }
+    if (Selected(argc, argv, "books"))
+    {
+        RunBooks(DeepBook(count, seed));
+    }
+    if (Selected(argc, argv, "parse"))
+    {
+        RunParser(DeepBook(count, seed));
+    }
+    return 0;
+}
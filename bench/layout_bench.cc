@@ -0,0 +1,316 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "BenchSupport.hpp"
+#include "PriceLadder.hpp"
+#include "TradeOrder.hpp"
+#include "TreeBook.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::uint64_t kBasePrice = 100000;
+constexpr std::size_t kTraders = 1000;
+
+// Heap bytes in use, including allocator overhead, or 0 where the C
+// library cannot tell.
+std::size_t HeapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    const struct mallinfo2 info = ::mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// L1 data and last-level cache read misses of the calling thread, counted
+// by the PMU between Start and Stop. Unavailable without a PMU or when
+// perf_event_paranoid forbids it, in which case Stop reports nothing.
+class CacheMisses final
+{
+   public:
+    struct Counts
+    {
+        bool valid;
+        std::uint64_t l1;
+        std::uint64_t llc;
+    };
+
+    CacheMisses()
+    {
+#ifdef __linux__
+        m_l1 = Open(PERF_COUNT_HW_CACHE_L1D);
+        m_llc = Open(PERF_COUNT_HW_CACHE_LL);
+#endif
+    }
+
+    CacheMisses(const CacheMisses&) = delete;
+    CacheMisses& operator=(const CacheMisses&) = delete;
+
+    ~CacheMisses()
+    {
+#ifdef __linux__
+        for (const int fd : {m_l1, m_llc})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] bool Available() const noexcept
+    {
+        return m_l1 >= 0 && m_llc >= 0;
+    }
+
+    void Start() noexcept
+    {
+#ifdef __linux__
+        if (Available())
+        {
+            for (const int fd : {m_l1, m_llc})
+            {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] Counts Stop() noexcept
+    {
+        Counts counts{false, 0, 0};
+#ifdef __linux__
+        if (Available())
+        {
+            ::ioctl(m_l1, PERF_EVENT_IOC_DISABLE, 0);
+            ::ioctl(m_llc, PERF_EVENT_IOC_DISABLE, 0);
+            counts.valid =
+                ::read(m_l1, &counts.l1, sizeof(counts.l1)) ==
+                    sizeof(counts.l1) &&
+                ::read(m_llc, &counts.llc, sizeof(counts.llc)) ==
+                    sizeof(counts.llc);
+        }
+#endif
+        return counts;
+    }
+
+   private:
+#ifdef __linux__
+    static int Open(const std::uint64_t cache) noexcept
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(
+            ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+   private:
+    int m_l1 = -1;
+    int m_llc = -1;
+};
+
+struct Order
+{
+    std::uint64_t price;
+    std::uint64_t quantity;
+    TraderId trader;
+};
+
+std::vector<Order> Orders(const std::size_t count, const std::size_t levels,
+                          const std::uint64_t seed)
+{
+    SplitMix64 rng(seed);
+    std::vector<Order> orders(count);
+    for (Order& order : orders)
+    {
+        order = {kBasePrice + rng.Next() % levels, rng.Between(1, 100),
+                 static_cast<TraderId>(rng.Next() % kTraders)};
+    }
+    return orders;
+}
+
+// Times fn over count orders and prints it with the misses it caused.
+template <typename Fn>
+void Measure(const char* phase, const std::size_t count,
+             CacheMisses& misses, Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    misses.Start();
+    fn();
+    const CacheMisses::Counts counts = misses.Stop();
+    const double nanos = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+    const auto perOrder = [count](const std::uint64_t value)
+    { return static_cast<double>(value) / static_cast<double>(count); };
+    std::cout << "  " << phase << ": " << nanos / count << " ns/order";
+    if (counts.valid)
+    {
+        std::cout << ", L1D misses " << perOrder(counts.l1)
+                  << "/order, LLC misses " << perOrder(counts.llc)
+                  << "/order";
+    }
+    std::cout << '\n';
+}
+
+void ReportBytes(const char* name, const std::size_t bytes,
+                 const std::size_t count)
+{
+    std::cout << name << ": ";
+    if (bytes == 0)
+    {
+        std::cout << "heap usage unknown\n";
+        return;
+    }
+    std::cout << static_cast<double>(bytes) / static_cast<double>(count)
+              << " heap bytes per resting order\n";
+}
+
+// The depth getters' layout, which is also how the engine kept resting
+// orders originally: a TradeOrder with its trader name, side and price in
+// a std::list per level.
+void RunOrdersMap(const std::vector<Order>& orders,
+                  const std::vector<std::string>& names, CacheMisses& misses,
+                  std::uint64_t& checksum)
+{
+    const std::size_t before = HeapInUse();
+    ordersMap book;
+    for (const Order& order : orders)
+    {
+        book[order.price].push_back(
+            {names[order.trader], 'S', order.quantity, order.price});
+    }
+    ReportBytes("ordersMap", HeapInUse() - before, orders.size());
+
+    Measure("walk", orders.size(), misses,
+            [&]()
+            {
+                for (const auto& [price, level] : book)
+                {
+                    for (const TradeOrder& order : level)
+                    {
+                        checksum += order.quantity + price;
+                    }
+                }
+            });
+    Measure("drain", orders.size(), misses,
+            [&]()
+            {
+                while (!book.empty())
+                {
+                    auto level = book.begin();
+                    checksum += level->second.front().quantity;
+                    level->second.pop_front();
+                    if (level->second.empty())
+                    {
+                        book.erase(level);
+                    }
+                }
+            });
+}
+
+template <typename Book>
+void RunBook(const char* name, const std::vector<Order>& orders,
+             CacheMisses& misses, std::uint64_t& checksum)
+{
+    const std::size_t before = HeapInUse();
+    Book book('S');
+    OrderId orderId = 0;
+    for (const Order& order : orders)
+    {
+        static_cast<void>(
+            book.Push(order.price, order.trader, order.quantity, ++orderId));
+    }
+    ReportBytes(name, HeapInUse() - before, orders.size());
+
+    Measure("walk", orders.size(), misses,
+            [&]()
+            {
+                book.VisitOrders(
+                    [&checksum](const std::uint64_t price, const auto& order)
+                    { checksum += order.quantity + price; });
+            });
+    Measure("drain", orders.size(), misses,
+            [&]()
+            {
+                while (!book.Empty())
+                {
+                    checksum += book.Front().quantity;
+                    book.PopFront();
+                }
+            });
+}
+}  // namespace
+
+// Rests orders at random prices over a number of levels in each book
+// layout, then reports the heap each resting order costs and the time and
+// cache misses per order of visiting every order in price-time priority
+// (walk) and of matching them all away front first (drain). The engine's
+// books hold trader ids, whose names live once in the TraderRegistry;
+// ordersMap copies the name into every order.
+// Usage: LayoutBenchmark [orders] [levels] [seed]
+int main(int argc, char* argv[])
+{
+    const std::size_t count =
+        argc > 1 ? std::stoull(argv[1]) : std::size_t{1000000};
+    const std::size_t levels =
+        argc > 2 ? std::stoull(argv[2]) : std::size_t{1000};
+    const std::uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 1;
+    if (count == 0 || levels == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [orders] [levels] [seed]"
+                  << std::endl;
+        return 2;
+    }
+
+    const std::vector<Order> orders = Orders(count, levels, seed);
+    std::vector<std::string> names;
+    for (std::size_t trader = 0; trader < kTraders; ++trader)
+    {
+        names.push_back("Trader" + std::to_string(trader));
+    }
+
+    CacheMisses misses;
+    std::cout << std::fixed << std::setprecision(2) << count
+              << " resting orders on " << levels << " levels, seed " << seed
+              << "; RestingOrder is " << sizeof(RestingOrder) << " bytes, "
+              << (misses.Available() ? "cache misses from the PMU"
+                                     : "no PMU access for cache misses")
+              << '\n';
+    std::uint64_t checksum = 0;
+    RunOrdersMap(orders, names, misses, checksum);
+    RunBook<TreeBook>("tree", orders, misses, checksum);
+    RunBook<PriceLadder>("ladder", orders, misses, checksum);
+    std::cout << "checksum " << checksum << '\n';
+    return 0;
+}
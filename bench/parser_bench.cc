@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "OrderParser.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+// The istringstream based parser the engine used before ParseOrder, kept
+// here as the baseline.
+TradeOrder LegacyParseInput(const std::string& input)
+{
+    if (input.empty())
+    {
+        throw std::invalid_argument("Input for parseInput is empty");
+    }
+
+    std::istringstream iss(input);
+    std::string identifier;
+    char side{};
+    std::string quantity_str;
+    std::string price_str;
+    std::uint64_t quantity{};
+    std::uint64_t price{};
+
+    iss >> identifier >> side >> quantity_str >> price_str;
+
+    if (!std::all_of(identifier.begin(), identifier.end(),
+                     [](const char c) { return std::isalnum(c); }))
+    {
+        throw std::invalid_argument("Invalid identifier passed to parseInput");
+    }
+    if (!std::isalpha(side))
+    {
+        throw std::invalid_argument("Invalid side passed to parseInput");
+    }
+    if (std::all_of(quantity_str.begin(), quantity_str.end(),
+                    [](const char c) { return std::isdigit(c); }))
+    {
+        quantity = std::stoull(quantity_str);
+    }
+    if (std::all_of(price_str.begin(), price_str.end(),
+                    [](const char c) { return std::isdigit(c); }))
+    {
+        price = std::stoull(price_str);
+    }
+    return TradeOrder{identifier, side, quantity, price};
+}
+
+std::vector<std::string> MakeLines(const std::size_t count)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> trader(1, 5000);
+    std::uniform_int_distribution<std::uint64_t> quantity(1, 100000);
+    std::uniform_int_distribution<std::uint64_t> price(1, 100000000);
+
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        lines.push_back("T" + std::to_string(trader(rng)) +
+                        (rng() & 1 ? " B " : " S ") +
+                        std::to_string(quantity(rng)) + " " +
+                        std::to_string(price(rng)));
+    }
+    return lines;
+}
+
+template <typename Parse>
+void Run(const char* name, const std::vector<std::string>& lines,
+         const int rounds, Parse&& parse)
+{
+    std::uint64_t checksum = 0;
+    double best = 0;
+    for (int round = 0; round < rounds; ++round)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (const std::string& line : lines)
+        {
+            checksum += parse(line);
+        }
+        const std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        const double perLine = elapsed.count() / lines.size();
+        best = round == 0 ? perLine : std::min(best, perLine);
+    }
+    std::cout << name << ": " << best << " ns/line, " << 1e3 / best
+              << " M lines/s (checksum " << checksum << ")\n";
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t count =
+        argc > 1 ? std::stoull(argv[1]) : std::size_t{1000000};
+    const int rounds = 5;
+    const std::vector<std::string> lines = MakeLines(count);
+
+    std::cout << "Parsing " << count << " lines, best of " << rounds
+              << " rounds\n";
+    Run("istringstream ParseInput", lines, rounds,
+        [](const std::string& line)
+        {
+            const TradeOrder order = LegacyParseInput(line);
+            return order.quantity + order.price;
+        });
+    Run("ParseOrder", lines, rounds,
+        [](const std::string& line)
+        {
+            OrderView order{};
+            if (ParseOrder(line, order) != ParseStatus::Ok)
+            {
+                return std::uint64_t{0};
+            }
+            return order.quantity + order.price;
+        });
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "BenchSupport.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::uint64_t kMidPrice = 500000;
+
+double Seconds(const LatencyStats::Clock::time_point start)
+{
+    return std::chrono::duration<double>(LatencyStats::Clock::now() - start)
+        .count();
+}
+
+// Rests count orders from 1000 traders over 200000 ticks without any of
+// them crossing.
+void FillBook(TradeEngine& engine, const std::size_t count)
+{
+    SplitMix64 rng(7);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const bool buy = rng.Next() & 1;
+        const std::uint64_t offset = rng.Between(1, 100000);
+        engine.ProcessOrder(
+            TradeOrder{"T" + std::to_string(rng.Between(1, 1000)),
+                       buy ? 'B' : 'S', rng.Between(1, 100),
+                       buy ? kMidPrice - offset : kMidPrice + offset});
+    }
+}
+
+// Throughput of journaled order entry for one durability setting.
+void JournalThroughput(const std::string& path, const std::size_t count,
+                       const JournalOptions options)
+{
+    std::filesystem::remove(path);
+    TradeEngine engine(BookType::Ladder);
+    engine.SetTradeHistory(false);
+    engine.OpenJournal(path, options);
+    const auto start = LatencyStats::Clock::now();
+    FillBook(engine, count);
+    const double seconds = Seconds(start);
+    std::cout << "journal group " << options.groupSize
+              << (options.sync ? ", fsync" : ", no fsync") << ": "
+              << count / seconds << " orders/s\n";
+}
+}  // namespace
+
+// Usage: RestoreBenchmark [resting orders] [directory]
+int main(int argc, char* argv[])
+{
+    const std::size_t count =
+        argc > 1 ? std::stoull(argv[1]) : std::size_t{10000000};
+    const std::filesystem::path directory =
+        argc > 2 ? argv[2] : std::filesystem::temp_directory_path();
+    const std::string journal = (directory / "restore_bench.log").string();
+    const std::string snapshot = (directory / "restore_bench.snap").string();
+
+    for (const std::size_t group : {1, 64, 4096})
+    {
+        JournalThroughput(journal, 20000, JournalOptions{group, true});
+    }
+    JournalThroughput(journal, 20000, JournalOptions{4096, false});
+
+    std::filesystem::remove(journal);
+    {
+        TradeEngine engine(BookType::Ladder);
+        engine.SetTradeHistory(false);
+        engine.OpenJournal(journal, JournalOptions{4096, false});
+        auto start = LatencyStats::Clock::now();
+        FillBook(engine, count);
+        std::cout << "built " << count << " resting orders in "
+                  << Seconds(start) << " s\n";
+
+        start = LatencyStats::Clock::now();
+        engine.WriteSnapshot(snapshot);
+        std::cout << "snapshot written in " << Seconds(start) << " s, "
+                  << std::filesystem::file_size(snapshot) / 1e6
+                  << " MB; journal " << std::filesystem::file_size(journal) / 1e6
+                  << " MB\n";
+    }
+
+    {
+        TradeEngine engine(BookType::Ladder);
+        const auto start = LatencyStats::Clock::now();
+        engine.Restore(snapshot, journal);
+        std::cout << "restart from snapshot: " << Seconds(start) << " s\n";
+    }
+    {
+        TradeEngine engine(BookType::Ladder);
+        const auto start = LatencyStats::Clock::now();
+        engine.Restore("", journal);
+        std::cout << "restart from journal alone: " << Seconds(start)
+                  << " s\n";
+    }
+
+    std::filesystem::remove(journal);
+    std::filesystem::remove(snapshot);
+    return 0;
+}
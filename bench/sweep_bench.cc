@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr int kOrdersPerLevel = 4;
+constexpr int kRounds = 200;
+
+struct LegacyFill
+{
+    std::string trader;
+    char sign;
+    std::uint64_t price;
+    std::uint64_t quantity;
+};
+
+// The map and string sort based aggregation CollectTrades used before,
+// kept here as the baseline.
+std::string LegacyCollectTrades(const std::vector<LegacyFill>& fills)
+{
+    std::map<std::pair<std::string, char>, std::map<int, int>> tradeInfo;
+    for (const LegacyFill& fill : fills)
+    {
+        tradeInfo[{fill.trader, fill.sign}][fill.price] += fill.quantity;
+    }
+
+    std::vector<std::string> tradeOutput;
+    for (const auto& [identifier, sign] : tradeInfo)
+    {
+        for (const auto& [price, quantity] : sign)
+        {
+            tradeOutput.emplace_back(identifier.first + identifier.second +
+                                     std::to_string(quantity) + "@" +
+                                     std::to_string(price));
+        }
+    }
+    std::sort(tradeOutput.begin(), tradeOutput.end());
+    std::stringstream ss;
+    for (const std::string& trade : tradeOutput)
+    {
+        ss << trade << " ";
+    }
+    return ss.str();
+}
+
+std::string Trader(const int level, const int slot)
+{
+    return "T" + std::to_string(level * kOrdersPerLevel + slot);
+}
+
+// Average cost of one buy order sweeping every level of a freshly built
+// book, excluding the cost of building the book.
+double SweepNanos(const BookType bookType, const int levels)
+{
+    double total = 0;
+    for (int round = 0; round < kRounds; ++round)
+    {
+        TradeEngine engine(bookType);
+        engine.SetTradeHistory(false);
+        for (int level = 0; level < levels; ++level)
+        {
+            for (int slot = 0; slot < kOrdersPerLevel; ++slot)
+            {
+                engine.ProcessOrder(TradeOrder{Trader(level, slot), 'S', 10,
+                                               std::uint64_t(1000 + level)});
+            }
+        }
+
+        const TradeOrder sweep{"AGGRESSOR", 'B',
+                               std::uint64_t(levels) * kOrdersPerLevel * 10,
+                               std::uint64_t(1000 + levels)};
+        const auto start = std::chrono::steady_clock::now();
+        engine.ProcessOrder(sweep);
+        total += std::chrono::duration<double, std::nano>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    }
+    return total / kRounds;
+}
+
+double LegacyCollectNanos(const int levels)
+{
+    std::vector<LegacyFill> fills;
+    for (int level = 0; level < levels; ++level)
+    {
+        for (int slot = 0; slot < kOrdersPerLevel; ++slot)
+        {
+            const auto price = std::uint64_t(1000 + level);
+            fills.push_back({"AGGRESSOR", '+', price, 10});
+            fills.push_back({Trader(level, slot), '-', price, 10});
+        }
+    }
+
+    std::size_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round)
+    {
+        checksum += LegacyCollectTrades(fills).size();
+    }
+    const double total = std::chrono::duration<double, std::nano>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    return checksum == 0 ? 0 : total / kRounds;
+}
+}  // namespace
+
+int main()
+{
+    std::cout << "Cost of one order sweeping N levels of " << kOrdersPerLevel
+              << " orders each, averaged over " << kRounds << " rounds\n";
+    for (const int levels : {1, 10, 100, 1000})
+    {
+        const double tree = SweepNanos(BookType::Tree, levels);
+        const double ladder = SweepNanos(BookType::Ladder, levels);
+        const double legacy = LegacyCollectNanos(levels);
+        std::cout << "levels " << levels << ": tree ProcessOrder " << tree
+                  << " ns, ladder ProcessOrder " << ladder
+                  << " ns, legacy CollectTrades alone " << legacy << " ns\n";
+    }
+    return 0;
+}
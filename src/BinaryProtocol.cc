@@ -0,0 +1,79 @@
+#include "BinaryProtocol.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+constexpr char kOrderFileMagic[4] = {'T', 'M', 'E', 'O'};
+constexpr std::uint32_t kOrderFileVersion = 1;
+// Bounds on what a header may claim, so that a corrupt one is rejected
+// before its counts are allocated.
+constexpr std::uint32_t kMaxOrderFileTraders = 1u << 24;
+constexpr std::uint32_t kMaxTraderNameLength = 4096;
+
+void WriteWord(std::ostream& out, const std::uint32_t value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::uint32_t ReadWord(std::istream& in)
+{
+    std::uint32_t value = 0;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value)))
+    {
+        throw std::invalid_argument("ERROR: Truncated order file header.");
+    }
+    return value;
+}
+}  // namespace
+
+void Trading::WriteOrderFileHeader(std::ostream& out,
+                                   const std::vector<std::string>& traders)
+{
+    out.write(kOrderFileMagic, sizeof(kOrderFileMagic));
+    WriteWord(out, kOrderFileVersion);
+    WriteWord(out, static_cast<std::uint32_t>(traders.size()));
+    for (const std::string& trader : traders)
+    {
+        WriteWord(out, static_cast<std::uint32_t>(trader.size()));
+        out.write(trader.data(), static_cast<std::streamsize>(trader.size()));
+    }
+}
+
+std::vector<std::string> Trading::ReadOrderFileHeader(std::istream& in)
+{
+    char magic[sizeof(kOrderFileMagic)];
+    if (!in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, kOrderFileMagic, sizeof(magic)) != 0)
+    {
+        throw std::invalid_argument("ERROR: Not a binary order file.");
+    }
+    if (ReadWord(in) != kOrderFileVersion)
+    {
+        throw std::invalid_argument("ERROR: Unsupported order file version.");
+    }
+
+    const std::uint32_t count = ReadWord(in);
+    if (count > kMaxOrderFileTraders)
+    {
+        throw std::invalid_argument("ERROR: Too many traders in order file.");
+    }
+    // Grown name by name, so a truncated file fails before a large count
+    // is allocated.
+    std::vector<std::string> traders;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        const std::uint32_t length = ReadWord(in);
+        if (length > kMaxTraderNameLength)
+        {
+            throw std::invalid_argument(
+                "ERROR: Trader name too long in order file.");
+        }
+        std::string& trader = traders.emplace_back(length, '\0');
+        if (!in.read(trader.data(), static_cast<std::streamsize>(length)))
+        {
+            throw std::invalid_argument("ERROR: Truncated order file header.");
+        }
+    }
+    return traders;
+}
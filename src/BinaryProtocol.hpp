@@ -0,0 +1,99 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+// Fixed-size order message. Messages are exchanged in host byte order,
+// which is little-endian on every platform the engine is built for, and
+// trader is an id previously returned by TradeEngine::RegisterTrader.
+// orderId is informational on input: the engine assigns its own ids in
+// arrival order, which the converter tool writes out as the expected id.
+struct OrderMessage
+{
+    OrderId orderId;
+    std::uint64_t price;
+    std::uint64_t quantity;
+    TraderId trader;
+    char side;
+    // Zero, a limit order, in messages that predate order types.
+    OrderType type;
+    std::uint8_t reserved[2];
+};
+
+// One side of a fill. Every fill produces two reports, the incoming order's
+// first, in the order the fills happened.
+struct ExecutionReport
+{
+    OrderId orderId;
+    std::uint64_t price;
+    std::uint64_t quantity;
+    TraderId trader;
+    char side;
+    // 'A' for the incoming order that took liquidity, 'P' for the resting
+    // order that provided it.
+    char liquidity;
+    std::uint8_t reserved[2];
+};
+
+inline constexpr std::size_t kOrderMessageSize = 32;
+inline constexpr std::size_t kExecutionReportSize = 32;
+
+static_assert(sizeof(OrderMessage) == kOrderMessageSize &&
+                  std::is_trivially_copyable_v<OrderMessage>,
+              "OrderMessage is copied to and from buffers as raw bytes");
+static_assert(sizeof(ExecutionReport) == kExecutionReportSize &&
+                  std::is_trivially_copyable_v<ExecutionReport>,
+              "ExecutionReport is copied to and from buffers as raw bytes");
+
+// The buffers need no particular alignment.
+inline OrderMessage DecodeOrder(const char* data) noexcept
+{
+    OrderMessage message;
+    std::memcpy(&message, data, sizeof(message));
+    return message;
+}
+
+inline void EncodeOrder(const OrderMessage& message, char* data) noexcept
+{
+    std::memcpy(data, &message, sizeof(message));
+}
+
+inline ExecutionReport DecodeReport(const char* data) noexcept
+{
+    ExecutionReport report;
+    std::memcpy(&report, data, sizeof(report));
+    return report;
+}
+
+inline void EncodeReport(const ExecutionReport& report, char* data) noexcept
+{
+    std::memcpy(data, &report, sizeof(report));
+}
+
+// A binary order file starts with a header naming its traders, so the ids
+// in its messages can be registered with any engine, followed by the
+// messages back to back:
+//   "TMEO" | uint32 version | uint32 trader count
+//   per trader: uint32 length | name bytes
+//   OrderMessage...
+void WriteOrderFileHeader(std::ostream& out,
+                          const std::vector<std::string>& traders);
+
+// Throws std::invalid_argument if the stream does not start with a valid
+// header, including one claiming more than 2^24 traders or a name longer
+// than 4096 bytes. The stream is left at the first message.
+[[nodiscard]] std::vector<std::string> ReadOrderFileHeader(std::istream& in);
+}  // namespace Trading
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef BOOK_SNAPSHOT_H
+#define BOOK_SNAPSHOT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Trading
+{
+// Aggregated view of one price level. An empty level has zero quantity.
+struct DepthLevel
+{
+    std::uint64_t price;
+    std::uint64_t quantity;
+    std::uint64_t orders;
+};
+
+struct TopOfBook
+{
+    // Number of orders the engine had processed when this was published.
+    std::uint64_t sequence;
+    DepthLevel bid;
+    DepthLevel ask;
+};
+
+inline constexpr std::size_t kMaxSnapshotDepth = 16;
+
+// Best levels of both sides, best price first.
+struct BookSnapshot
+{
+    std::uint64_t sequence;
+    std::uint64_t bidLevels;
+    std::uint64_t askLevels;
+    std::array<DepthLevel, kMaxSnapshotDepth> bids;
+    std::array<DepthLevel, kMaxSnapshotDepth> asks;
+};
+}  // namespace Trading
+
+#endif
@@ -0,0 +1,146 @@
+#include "EngineStats.hpp"
+
+#include <iomanip>
+#include <iterator>
+#include <utility>
+
+
+const char* Trading::ToString(const Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case Stage::Parse:
+            return "parse";
+        case Stage::ProcessOrder:
+            return "process order";
+        case Stage::Match:
+            return "match";
+        case Stage::CollectTrades:
+            return "collect trades";
+        default:
+            return "unknown";
+    }
+}
+
+double Trading::TicksPerNanosecond()
+{
+#ifdef TRADING_RDTSC
+    // Spin for a few milliseconds against steady_clock.
+    static const double ratio = []()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t startTicks = ReadTicks();
+        auto now = start;
+        while (now - start < std::chrono::milliseconds(5))
+        {
+            now = std::chrono::steady_clock::now();
+        }
+        const std::uint64_t ticks = ReadTicks() - startTicks;
+        return static_cast<double>(ticks) /
+               std::chrono::duration<double, std::nano>(now - start).count();
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+std::uint64_t Trading::LatencyHistogram::HighestInBucket(
+    const std::size_t bucket) noexcept
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    const std::size_t group = bucket >> kSubBucketBits;
+    const std::uint64_t sub = bucket & (kSubBuckets - 1);
+    const unsigned shift = static_cast<unsigned>(group - 1);
+    const std::uint64_t lowest = (kSubBuckets + sub) << shift;
+    return lowest + ((std::uint64_t{1} << shift) - 1);
+}
+
+Trading::LatencySummary Trading::LatencyHistogram::Summarize(
+    const Counts& counts, const double scale) noexcept
+{
+    LatencySummary summary{};
+    for (const std::uint64_t count : counts)
+    {
+        summary.count += count;
+    }
+    if (summary.count == 0)
+    {
+        return summary;
+    }
+
+    const auto scaled = [scale](const std::size_t bucket)
+    {
+        return static_cast<std::uint64_t>(
+            static_cast<double>(HighestInBucket(bucket)) / scale);
+    };
+    const std::pair<double, std::uint64_t*> targets[] = {
+        {0.5, &summary.p50},
+        {0.9, &summary.p90},
+        {0.99, &summary.p99},
+        {0.999, &summary.p999}};
+
+    std::uint64_t seen = 0;
+    std::size_t target = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket)
+    {
+        if (counts[bucket] == 0)
+        {
+            continue;
+        }
+        seen += counts[bucket];
+        while (target < std::size(targets) &&
+               seen >= targets[target].first * summary.count)
+        {
+            *targets[target++].second = scaled(bucket);
+        }
+        summary.max = scaled(bucket);
+    }
+    return summary;
+}
+
+void Trading::PrintStats(std::ostream& out, const EngineStats& stats)
+{
+    out << "orders " << stats.orders << ", fills " << stats.fills
+        << ", levels swept " << stats.levelsSwept << ", rejects "
+        << stats.rejects << ", resting " << stats.restingOrders
+        << " orders on " << stats.bidLevels << " bid / " << stats.askLevels
+        << " ask levels\n";
+    for (std::size_t stage = 0; stage < kStageCount; ++stage)
+    {
+        const LatencySummary& summary = stats.stages[stage];
+        out << std::setw(16) << ToString(static_cast<Stage>(stage)) << ": "
+            << summary.count << " samples, p50 " << summary.p50 << " ns, p90 "
+            << summary.p90 << " ns, p99 " << summary.p99 << " ns, p99.9 "
+            << summary.p999 << " ns, max " << summary.max << " ns\n";
+    }
+}
+
+Trading::StatsDumper::StatsDumper(const std::chrono::milliseconds period,
+                                  std::function<void()> task)
+    : m_thread(
+          [this, period, task = std::move(task)]()
+          {
+              std::unique_lock lock(m_mutex);
+              while (!m_wake.wait_for(lock, period, [this] { return m_stop; }))
+              {
+                  lock.unlock();
+                  task();
+                  lock.lock();
+              }
+          })
+{
+}
+
+Trading::StatsDumper::~StatsDumper()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
@@ -0,0 +1,237 @@
+#ifndef ENGINE_STATS_H
+#define ENGINE_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRADING_RDTSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define TRADING_RDTSC 1
+#endif
+
+namespace Trading
+{
+class LatencyHistogram;
+class ScopedProbe;
+class StatsDumper;
+
+// Building without TRADING_ENABLE_STATS (CMake option TRADE_ENGINE_STATS)
+// compiles every probe and counter out of the engine; GetStats then
+// reports nothing.
+#ifdef TRADING_ENABLE_STATS
+inline constexpr bool kStatsEnabled = true;
+#else
+inline constexpr bool kStatsEnabled = false;
+#endif
+
+enum class Stage : std::uint8_t
+{
+    Parse,
+    ProcessOrder,
+    Match,
+    CollectTrades,
+    Count
+};
+
+inline constexpr std::size_t kStageCount =
+    static_cast<std::size_t>(Stage::Count);
+
+[[nodiscard]] const char* ToString(Stage stage) noexcept;
+
+// Cheapest available monotonic tick counter: the time stamp counter on x86,
+// steady_clock nanoseconds elsewhere. Assumes an invariant TSC.
+[[nodiscard]] inline std::uint64_t ReadTicks() noexcept
+{
+#ifdef TRADING_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+// Measured once, on first use.
+[[nodiscard]] double TicksPerNanosecond();
+
+struct LatencySummary
+{
+    std::uint64_t count;
+    std::uint64_t p50;
+    std::uint64_t p90;
+    std::uint64_t p99;
+    std::uint64_t p999;
+    std::uint64_t max;
+};
+
+// Latencies are in nanoseconds.
+struct EngineStats
+{
+    std::array<LatencySummary, kStageCount> stages;
+    std::uint64_t orders;
+    std::uint64_t fills;
+    std::uint64_t levelsSwept;
+    std::uint64_t rejects;
+    std::uint64_t restingOrders;
+    std::uint64_t bidLevels;
+    std::uint64_t askLevels;
+};
+
+void PrintStats(std::ostream& out, const EngineStats& stats);
+
+// Per-thread counters of one engine. Each is written by its owning thread
+// only and may be read from any thread.
+struct ThreadStats;
+}  // namespace Trading
+
+// Log-linear histogram in the style of HdrHistogram: every power of two is
+// split into 16 linear sub-buckets, so any recorded value is reported
+// within 1/16 of itself, over the whole 64-bit range, in a fixed 8 KB.
+// Recording is meant for a single thread; buckets are relaxed atomics so
+// that other threads can read them while it records.
+class Trading::LatencyHistogram final
+{
+   public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kSubBuckets = std::size_t{1}
+                                               << kSubBucketBits;
+    static constexpr std::size_t kBuckets =
+        (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    using Counts = std::array<std::uint64_t, kBuckets>;
+
+    void Record(const std::uint64_t value) noexcept
+    {
+        auto& bucket = m_counts[BucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    }
+
+    void AddTo(Counts& counts) const noexcept
+    {
+        for (std::size_t i = 0; i < kBuckets; ++i)
+        {
+            counts[i] += m_counts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] static std::size_t BucketOf(
+        const std::uint64_t value) noexcept
+    {
+        if (value < kSubBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+#if defined(__GNUC__)
+        const auto magnitude =
+            static_cast<unsigned>(63 - __builtin_clzll(value));
+#else
+        unsigned magnitude = 0;
+        for (std::uint64_t rest = value; rest > 1; rest >>= 1)
+        {
+            ++magnitude;
+        }
+#endif
+        const unsigned shift = magnitude - kSubBucketBits;
+        return ((magnitude - kSubBucketBits + 1) << kSubBucketBits) +
+               static_cast<std::size_t>((value >> shift) & (kSubBuckets - 1));
+    }
+
+    // Largest value that falls into bucket.
+    [[nodiscard]] static std::uint64_t HighestInBucket(
+        std::size_t bucket) noexcept;
+
+    // Percentiles and maximum of counts, each scaled by scale.
+    [[nodiscard]] static LatencySummary Summarize(const Counts& counts,
+                                                  double scale) noexcept;
+
+   private:
+    std::array<std::atomic<std::uint64_t>, kBuckets> m_counts{};
+};
+
+struct Trading::ThreadStats
+{
+    explicit ThreadStats(const std::thread::id thread) noexcept
+        : owner(thread)
+    {
+    }
+
+    static void Add(std::atomic<std::uint64_t>& counter,
+                    const std::uint64_t amount) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount,
+                      std::memory_order_relaxed);
+    }
+
+    const std::thread::id owner;
+    std::array<LatencyHistogram, kStageCount> stages;
+    std::atomic<std::uint64_t> orders{0};
+    std::atomic<std::uint64_t> fills{0};
+    std::atomic<std::uint64_t> levelsSwept{0};
+    std::atomic<std::uint64_t> rejects{0};
+};
+
+// Records the ticks spent in its scope; does nothing when stats are
+// compiled out or histogram is null.
+class Trading::ScopedProbe final
+{
+   public:
+    explicit ScopedProbe(LatencyHistogram* const histogram) noexcept
+        : m_histogram(histogram)
+    {
+        if constexpr (kStatsEnabled)
+        {
+            m_start = ReadTicks();
+        }
+    }
+
+    ScopedProbe(const ScopedProbe&) = delete;
+    ScopedProbe& operator=(const ScopedProbe&) = delete;
+
+    ~ScopedProbe()
+    {
+        if constexpr (kStatsEnabled)
+        {
+            if (m_histogram != nullptr)
+            {
+                m_histogram->Record(ReadTicks() - m_start);
+            }
+        }
+    }
+
+   private:
+    LatencyHistogram* const m_histogram;
+    std::uint64_t m_start = 0;
+};
+
+// Calls task every period on its own thread until destroyed.
+class Trading::StatsDumper final
+{
+   public:
+    StatsDumper(std::chrono::milliseconds period, std::function<void()> task);
+
+    StatsDumper(const StatsDumper&) = delete;
+    StatsDumper& operator=(const StatsDumper&) = delete;
+
+    ~StatsDumper();
+
+   private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+#endif
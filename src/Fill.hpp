@@ -0,0 +1,36 @@
+#ifndef FILL_H
+#define FILL_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+// One trade between an incoming order and a resting order, as the engine
+// matched it. Fills are numbered by sequence, which starts at 1 in a fresh
+// engine, grows by one per fill and carries over through snapshots, so a
+// consumer can tell a gap or a duplicate from the number alone.
+struct Fill
+{
+    std::uint64_t sequence;
+    OrderId aggressorOrderId;
+    OrderId restingOrderId;
+    std::uint64_t price;
+    std::uint64_t quantity;
+    // Open quantity of the resting order after this fill; 0 once it has
+    // left the book.
+    std::uint64_t restingRemaining;
+    TraderId aggressorTrader;
+    TraderId restingTrader;
+    // 'B' or 'S'; the resting order is on the other side.
+    char aggressorSide;
+    std::uint8_t reserved[7];
+};
+
+static_assert(sizeof(Fill) == 64 && std::is_trivially_copyable_v<Fill>,
+              "A Fill is one cache line that can be copied as raw bytes");
+}  // namespace Trading
+
+#endif
@@ -0,0 +1,705 @@
+#include "Gateway.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#define TRADING_EPOLL 1
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace
+{
+// epoll user data of the descriptors that are not sessions.
+constexpr std::uint64_t kWakeupId = 0;
+constexpr std::uint64_t kTcpId = 1;
+constexpr std::uint64_t kUnixId = 2;
+constexpr std::uint64_t kFirstSessionId = 3;
+
+constexpr int kMaxEvents = 256;
+// Longer trader names or text lines end the session.
+constexpr std::uint32_t kMaxNameLength = 256;
+constexpr std::size_t kMaxLineLength = 4096;
+// Owners tracked before the first sweep for orders no longer resting.
+constexpr std::size_t kMinOwnerSweep = 1024;
+// Magic plus name length.
+constexpr std::size_t kHandshakeSize = sizeof(Trading::kGatewayBinaryMagic) +
+                                       sizeof(std::uint32_t);
+
+void AppendDecimal(std::string& out, const std::uint64_t value)
+{
+    char digits[20];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+bool MayRest(const Trading::OrderType type) noexcept
+{
+    return type == Trading::OrderType::Limit ||
+           type == Trading::OrderType::PostOnly;
+}
+}  // namespace
+
+struct Trading::OrderGateway::Session
+{
+    enum class Mode : std::uint8_t
+    {
+        // Nothing read yet that tells text from binary.
+        Unknown,
+        Text,
+        Binary
+    };
+
+    std::uint64_t id;
+    int fd;
+    Mode mode = Mode::Unknown;
+    // Binary sessions only.
+    std::string trader;
+    TraderId traderId = 0;
+
+    // input[0, size) has been read; input[0, framed) belongs to the batch.
+    // The vector only grows, so reading does not clear memory every time.
+    std::vector<char> input;
+    std::size_t size = 0;
+    std::size_t framed = 0;
+
+    std::string output;
+    std::size_t written = 0;
+    bool dirty = false;
+    bool watchingOutput = false;
+    bool closing = false;
+};
+
+#ifdef TRADING_EPOLL
+
+Trading::OrderGateway::OrderGateway(TradeEngine& engine,
+                                    const GatewayOptions& options)
+    : m_engine(engine),
+      m_options(options),
+      m_nextSession(kFirstSessionId),
+      m_sweepOwnersAt(kMinOwnerSweep)
+{
+    m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wakeup < 0)
+    {
+        CloseDescriptors();
+        throw std::runtime_error("Cannot create the gateway event loop");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeupId;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event);
+
+    try
+    {
+        if (options.tcpPort >= 0)
+        {
+            if (options.tcpPort > 65535)
+            {
+                throw std::invalid_argument("ERROR: Invalid TCP port.");
+            }
+            m_tcpListener = ::socket(
+                AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            const int reuse = 1;
+            ::setsockopt(m_tcpListener, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                         sizeof(reuse));
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port =
+                htons(static_cast<std::uint16_t>(options.tcpPort));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            Listen(m_tcpListener, &address, sizeof(address), kTcpId);
+
+            socklen_t length = sizeof(address);
+            ::getsockname(m_tcpListener, reinterpret_cast<sockaddr*>(&address),
+                          &length);
+            m_tcpPort = ntohs(address.sin_port);
+        }
+        if (!options.unixPath.empty())
+        {
+            sockaddr_un address{};
+            if (options.unixPath.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument(
+                    "ERROR: Unix socket path too long.");
+            }
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, options.unixPath.c_str(),
+                        options.unixPath.size() + 1);
+            ::unlink(options.unixPath.c_str());
+            m_unixListener = ::socket(
+                AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            Listen(m_unixListener, &address, sizeof(address), kUnixId);
+        }
+    }
+    catch (...)
+    {
+        CloseDescriptors();
+        throw;
+    }
+
+    m_engine.SetReportSink(
+        [this](const ExecutionReport* reports, const std::size_t count)
+        { m_reports.insert(m_reports.end(), reports, reports + count); });
+}
+
+Trading::OrderGateway::~OrderGateway()
+{
+    m_engine.SetReportSink(nullptr);
+    CloseDescriptors();
+}
+
+void Trading::OrderGateway::CloseDescriptors() noexcept
+{
+    for (const auto& [id, session] : m_sessions)
+    {
+        ::close(session->fd);
+    }
+    m_sessions.clear();
+    for (int* const fd : {&m_tcpListener, &m_unixListener, &m_wakeup, &m_epoll})
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    if (!m_options.unixPath.empty())
+    {
+        ::unlink(m_options.unixPath.c_str());
+    }
+}
+
+void Trading::OrderGateway::Listen(const int fd, const void* const address,
+                                   const std::size_t length,
+                                   const std::uint64_t id)
+{
+    if (fd < 0 ||
+        ::bind(fd, static_cast<const sockaddr*>(address),
+               static_cast<socklen_t>(length)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        throw std::runtime_error(std::string("Cannot listen for orders: ") +
+                                 std::strerror(errno));
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = id;
+    ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+}
+
+void Trading::OrderGateway::Stop() noexcept
+{
+    const std::uint64_t one = 1;
+    // Only fails if the counter would overflow, when a wakeup is pending
+    // anyway.
+    static_cast<void>(::write(m_wakeup, &one, sizeof(one)));
+}
+
+void Trading::OrderGateway::Run()
+{
+    epoll_event events[kMaxEvents];
+    m_stopped = false;
+    while (!m_stopped)
+    {
+        const int ready = ::epoll_wait(m_epoll, events, kMaxEvents, -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error(std::string("Gateway event loop: ") +
+                                     std::strerror(errno));
+        }
+
+        for (int i = 0; i < ready; ++i)
+        {
+            const std::uint64_t id = events[i].data.u64;
+            if (id == kWakeupId)
+            {
+                std::uint64_t count = 0;
+                static_cast<void>(::read(m_wakeup, &count, sizeof(count)));
+                m_stopped = true;
+                continue;
+            }
+            if (id == kTcpId || id == kUnixId)
+            {
+                Accept(id == kTcpId ? m_tcpListener : m_unixListener,
+                       id == kTcpId);
+                continue;
+            }
+
+            Session* const session = Find(id);
+            if (session == nullptr || session->closing)
+            {
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) != 0)
+            {
+                Flush(*session);
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0)
+            {
+                // Whatever arrived before the peer left is still matched.
+                const bool open = Read(*session);
+                if (!Frame(*session) || !open)
+                {
+                    session->closing = true;
+                    m_closing.push_back(id);
+                }
+            }
+        }
+
+        SubmitBatch();
+        for (const std::uint64_t id : m_dirty)
+        {
+            if (Session* const session = Find(id))
+            {
+                session->dirty = false;
+                Flush(*session);
+            }
+        }
+        m_dirty.clear();
+        for (const std::uint64_t id : m_closing)
+        {
+            Close(id);
+        }
+        m_closing.clear();
+    }
+}
+
+void Trading::OrderGateway::Accept(const int listener, const bool tcp)
+{
+    for (;;)
+    {
+        const int fd =
+            ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            // EAGAIN once the backlog is empty; a connection that failed
+            // before it was accepted is simply dropped.
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            return;
+        }
+        if (tcp)
+        {
+            const int noDelay = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay,
+                         sizeof(noDelay));
+        }
+
+        auto session = std::make_unique<Session>();
+        session->id = m_nextSession++;
+        session->fd = fd;
+        session->input.resize(m_options.readChunk);
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = session->id;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+        m_sessions.emplace(session->id, std::move(session));
+    }
+}
+
+bool Trading::OrderGateway::Read(Session& session)
+{
+    // The previous batch has been answered, so what it pointed into can go.
+    if (session.framed != 0)
+    {
+        std::memmove(session.input.data(),
+                     session.input.data() + session.framed,
+                     session.size - session.framed);
+        session.size -= session.framed;
+        session.framed = 0;
+    }
+    if (session.input.size() - session.size < m_options.readChunk)
+    {
+        session.input.resize(session.size + m_options.readChunk);
+    }
+    for (;;)
+    {
+        const ssize_t received =
+            ::recv(session.fd, session.input.data() + session.size,
+                   m_options.readChunk, 0);
+        if (received > 0)
+        {
+            session.size += static_cast<std::size_t>(received);
+            return true;
+        }
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+bool Trading::OrderGateway::Frame(Session& session)
+{
+    const char* const data = session.input.data();
+    if (session.mode == Session::Mode::Unknown)
+    {
+        const std::size_t compared =
+            std::min(session.size, sizeof(kGatewayBinaryMagic));
+        if (std::memcmp(data, kGatewayBinaryMagic, compared) != 0)
+        {
+            session.mode = Session::Mode::Text;
+        }
+        else if (session.size >= kHandshakeSize)
+        {
+            std::uint32_t length = 0;
+            std::memcpy(&length, data + sizeof(kGatewayBinaryMagic),
+                        sizeof(length));
+            if (length == 0 || length > kMaxNameLength)
+            {
+                return false;
+            }
+            if (session.size < kHandshakeSize + length)
+            {
+                return true;
+            }
+            session.trader.assign(data + kHandshakeSize, length);
+            session.traderId = m_engine.RegisterTrader(session.trader);
+            session.mode = Session::Mode::Binary;
+            session.framed = kHandshakeSize + length;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    if (session.mode == Session::Mode::Binary)
+    {
+        for (; session.size - session.framed >= kOrderMessageSize;
+             session.framed += kOrderMessageSize)
+        {
+            const OrderMessage message = DecodeOrder(data + session.framed);
+            m_orders.push_back(OrderView{session.trader, message.side,
+                                         message.quantity, message.price,
+                                         message.type});
+            m_pending.push_back({session.id, nullptr});
+        }
+        return true;
+    }
+
+    for (;;)
+    {
+        const char* const begin = data + session.framed;
+        const char* const end = static_cast<const char*>(
+            std::memchr(begin, '\n', session.size - session.framed));
+        if (end == nullptr)
+        {
+            return session.size - session.framed <= kMaxLineLength;
+        }
+        session.framed = static_cast<std::size_t>(end - data) + 1;
+
+        std::string_view line(begin, static_cast<std::size_t>(end - begin));
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        OrderView order{};
+        const ParseStatus status = ParseOrder(line, order);
+        if (status == ParseStatus::Ok)
+        {
+            m_orders.push_back(order);
+            m_pending.push_back({session.id, nullptr});
+        }
+        else if (status != ParseStatus::Empty)
+        {
+            m_pending.push_back({session.id, ToString(status)});
+        }
+    }
+}
+
+void Trading::OrderGateway::SubmitBatch()
+{
+    if (m_pending.empty())
+    {
+        return;
+    }
+
+    m_results.resize(m_orders.size());
+    m_reports.clear();
+    bool failed = false;
+    if (!m_orders.empty())
+    {
+        try
+        {
+            m_engine.ProcessOrders(Span<const OrderView>(m_orders),
+                                   Span<OrderResult>(m_results));
+        }
+        catch (const std::runtime_error&)
+        {
+            // The journal could not record the batch, so none of it is
+            // acknowledged; later batches still run.
+            failed = true;
+            m_reports.clear();
+        }
+    }
+
+    // Reports come in pairs, the incoming order's first, grouped by order
+    // in batch order.
+    std::size_t next = 0;
+    std::size_t report = 0;
+    for (const Pending& pending : m_pending)
+    {
+        Session* const session = Find(pending.session);
+        if (pending.parseError != nullptr)
+        {
+            Reject(*session, nullptr, pending.parseError);
+            continue;
+        }
+        const OrderView& order = m_orders[next];
+        const OrderResult& result = m_results[next];
+        ++next;
+        if (failed)
+        {
+            Reject(*session, &order, "engine failure");
+            continue;
+        }
+        if (result.rejected)
+        {
+            Reject(*session, &order, ToString(result.reason));
+            continue;
+        }
+
+        for (; report + 1 < m_reports.size() &&
+               m_reports[report].orderId == result.orderId;
+             report += 2)
+        {
+            Send(*session, m_reports[report]);
+            const ExecutionReport& resting = m_reports[report + 1];
+            const auto owner = m_owners.find(resting.orderId);
+            if (owner == m_owners.end())
+            {
+                // Entered before the gateway, or by a session since closed.
+                continue;
+            }
+            if (Session* const restingSession = Find(owner->second.session))
+            {
+                Send(*restingSession, resting);
+            }
+            if (!m_engine.IsResting(resting.orderId))
+            {
+                m_owners.erase(owner);
+            }
+        }
+
+        if (session->mode == Session::Mode::Binary)
+        {
+            Send(*session, ExecutionReport{result.orderId,
+                                           order.price,
+                                           result.filledQuantity,
+                                           session->traderId,
+                                           order.side,
+                                           kReportAccepted,
+                                           {}});
+        }
+        else
+        {
+            session->output.append("OK ");
+            AppendDecimal(session->output, result.orderId);
+            session->output.push_back(' ');
+            AppendDecimal(session->output, result.filledQuantity);
+            session->output.push_back('\n');
+            MarkDirty(*session);
+        }
+        if (result.filledQuantity < order.quantity && MayRest(order.type) &&
+            m_engine.IsResting(result.orderId))
+        {
+            m_owners[result.orderId] = {pending.session};
+        }
+    }
+
+    m_orders.clear();
+    m_pending.clear();
+    if (m_owners.size() >= m_sweepOwnersAt)
+    {
+        SweepOwners();
+    }
+}
+
+void Trading::OrderGateway::SweepOwners()
+{
+    for (auto owner = m_owners.begin(); owner != m_owners.end();)
+    {
+        owner = m_engine.IsResting(owner->first) ? std::next(owner)
+                                                 : m_owners.erase(owner);
+    }
+    // Twice what is left keeps the cost of sweeping constant per order.
+    m_sweepOwnersAt = std::max(kMinOwnerSweep, m_owners.size() * 2);
+}
+
+Trading::OrderGateway::Session* Trading::OrderGateway::Find(
+    const std::uint64_t id) noexcept
+{
+    const auto found = m_sessions.find(id);
+    return found == m_sessions.end() ? nullptr : found->second.get();
+}
+
+void Trading::OrderGateway::Send(Session& session,
+                                 const ExecutionReport& report)
+{
+    if (session.mode == Session::Mode::Binary)
+    {
+        char data[kExecutionReportSize];
+        EncodeReport(report, data);
+        session.output.append(data, sizeof(data));
+    }
+    else
+    {
+        std::string& out = session.output;
+        out.append("FILL ");
+        AppendDecimal(out, report.orderId);
+        out.push_back(' ');
+        out.push_back(report.side);
+        out.push_back(' ');
+        AppendDecimal(out, report.quantity);
+        out.push_back('@');
+        AppendDecimal(out, report.price);
+        out.push_back(' ');
+        out.push_back(report.liquidity);
+        out.push_back('\n');
+    }
+    MarkDirty(session);
+}
+
+void Trading::OrderGateway::Reject(Session& session,
+                                   const OrderView* const order,
+                                   const char* const reason)
+{
+    if (session.mode == Session::Mode::Binary)
+    {
+        Send(session, ExecutionReport{0,
+                                      order->price,
+                                      order->quantity,
+                                      session.traderId,
+                                      order->side,
+                                      kReportRejected,
+                                      {}});
+        return;
+    }
+    session.output.append("REJ ");
+    session.output.append(reason);
+    session.output.push_back('\n');
+    MarkDirty(session);
+}
+
+void Trading::OrderGateway::MarkDirty(Session& session)
+{
+    if (!session.dirty)
+    {
+        session.dirty = true;
+        m_dirty.push_back(session.id);
+    }
+}
+
+void Trading::OrderGateway::Flush(Session& session)
+{
+    while (session.written < session.output.size())
+    {
+        const ssize_t sent =
+            ::send(session.fd, session.output.data() + session.written,
+                   session.output.size() - session.written, MSG_NOSIGNAL);
+        if (sent >= 0)
+        {
+            session.written += static_cast<std::size_t>(sent);
+            continue;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            session.output.clear();
+            session.written = 0;
+            if (!session.closing)
+            {
+                session.closing = true;
+                m_closing.push_back(session.id);
+            }
+            return;
+        }
+        break;
+    }
+
+    const bool pending = session.written < session.output.size();
+    if (!pending)
+    {
+        session.output.clear();
+        session.written = 0;
+    }
+    else if (session.output.size() - session.written >
+                 m_options.maxPendingOutput &&
+             !session.closing)
+    {
+        // A client that never reads would otherwise grow this forever.
+        session.closing = true;
+        m_closing.push_back(session.id);
+    }
+    if (pending != session.watchingOutput)
+    {
+        session.watchingOutput = pending;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP | (pending ? EPOLLOUT : 0u);
+        event.data.u64 = session.id;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, session.fd, &event);
+    }
+}
+
+void Trading::OrderGateway::Close(const std::uint64_t id)
+{
+    const auto found = m_sessions.find(id);
+    if (found == m_sessions.end())
+    {
+        return;
+    }
+    ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, found->second->fd, nullptr);
+    ::close(found->second->fd);
+    m_sessions.erase(found);
+
+    // Later fills of its resting orders have nowhere to go.
+    for (auto owner = m_owners.begin(); owner != m_owners.end();)
+    {
+        owner = owner->second.session == id ? m_owners.erase(owner)
+                                            : std::next(owner);
+    }
+}
+
+#else
+
+Trading::OrderGateway::OrderGateway(TradeEngine& engine,
+                                    const GatewayOptions& options)
+    : m_engine(engine), m_options(options), m_nextSession(kFirstSessionId)
+{
+    throw std::runtime_error("The order gateway is not supported on this "
+                             "platform");
+}
+
+Trading::OrderGateway::~OrderGateway() = default;
+
+void Trading::OrderGateway::CloseDescriptors() noexcept {}
+
+void Trading::OrderGateway::Run() {}
+
+void Trading::OrderGateway::Stop() noexcept {}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryProtocol.hpp"
+#include "OrderParser.hpp"
+#include "TradeEngine.hpp"
+
+namespace Trading
+{
+class OrderGateway;
+
+// A session is a text session unless its first bytes are
+// kGatewayBinaryMagic, followed by a uint32 name length and the trader
+// name all its orders are entered for. It then sends OrderMessages, whose
+// trader field is ignored, and receives ExecutionReports.
+inline constexpr char kGatewayBinaryMagic[4] = {'T', 'M', 'E', 'B'};
+
+// Liquidity codes of the reports the gateway adds to the engine's 'A' and
+// 'P' fills. Each binary order gets exactly one of them, after its own
+// fills: 'N' carries the engine's order id and, as quantity, what traded
+// on entry; 'R' means the order was rejected and has no id.
+inline constexpr char kReportAccepted = 'N';
+inline constexpr char kReportRejected = 'R';
+
+struct GatewayOptions
+{
+    // Loopback TCP port to listen on, 0 for any free one, -1 for none.
+    int tcpPort = -1;
+    // Unix domain socket path to listen on, empty for none. A stale socket
+    // file at the path is replaced.
+    std::string unixPath;
+    // Bytes read from one session per wakeup, so that one busy session
+    // cannot starve the others.
+    std::size_t readChunk = 64 * 1024;
+    // A session whose unsent responses grow past this is disconnected.
+    std::size_t maxPendingOutput = 64 * 1024 * 1024;
+};
+}  // namespace Trading
+
+// Single-threaded order gateway. One epoll loop accepts sessions on
+// loopback TCP and a Unix domain socket, reads whatever each ready session
+// has sent, cuts it into text lines or binary messages, and submits every
+// order read in that wakeup to the engine as one ProcessOrders batch.
+// Responses are queued per session and written once the batch is matched.
+//
+// Text sessions send order lines as accepted by ParseOrder and receive,
+// for each line, its own fills followed by one status line:
+//   FILL <order id> <B|S> <quantity>@<price> <A|P>
+//   OK <order id> <quantity traded on entry>
+//   REJ <reason>
+// Fills of resting orders go to the session that entered them, as soon as
+// they happen.
+class Trading::OrderGateway final
+{
+   public:
+    // Throws std::runtime_error if a listener cannot be set up.
+    OrderGateway(TradeEngine& engine, const GatewayOptions& options);
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    ~OrderGateway();
+
+    // Runs the event loop until Stop is called.
+    void Run();
+
+    // Makes Run return after the current wakeup. Safe to call from any
+    // thread and from a signal handler.
+    void Stop() noexcept;
+
+    // The TCP port listened on, also when the kernel picked it; 0 without
+    // a TCP listener.
+    [[nodiscard]] std::uint16_t TcpPort() const noexcept { return m_tcpPort; }
+
+   private:
+    struct Session;
+
+    // Where an order that rests in the book came from.
+    struct Owner
+    {
+        std::uint64_t session;
+    };
+
+    // A frame of the current batch and the session that sent it. Frames
+    // that failed to parse are answered in turn but never submitted.
+    struct Pending
+    {
+        std::uint64_t session;
+        // Null for an order, which is the next one in m_orders.
+        const char* parseError;
+    };
+
+    void CloseDescriptors() noexcept;
+    void Listen(int fd, const void* address, std::size_t length,
+                std::uint64_t id);
+    void Accept(int listener, bool tcp);
+    // Reads one chunk; false once the peer is gone.
+    bool Read(Session& session);
+    // Cuts the complete frames out of the session's input into the batch.
+    // False if the input is malformed beyond recovery.
+    bool Frame(Session& session);
+    void SubmitBatch();
+    // Drops the owners of orders that no longer rest in the book.
+    void SweepOwners();
+    [[nodiscard]] Session* Find(std::uint64_t id) noexcept;
+    void Send(Session& session, const ExecutionReport& report);
+    void Reject(Session& session, const OrderView* order, const char* reason);
+    // Queues the session for the flush after the batch.
+    void MarkDirty(Session& session);
+    void Flush(Session& session);
+    void Close(std::uint64_t id);
+
+   private:
+    TradeEngine& m_engine;
+    const GatewayOptions m_options;
+
+    int m_epoll = -1;
+    int m_wakeup = -1;
+    int m_tcpListener = -1;
+    int m_unixListener = -1;
+    std::uint16_t m_tcpPort = 0;
+
+    bool m_stopped = false;
+    std::uint64_t m_nextSession;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Session>> m_sessions;
+    std::unordered_map<OrderId, Owner> m_owners;
+    // Self-trade prevention takes resting orders off the book without a
+    // report, so m_owners is swept whenever it grows to this size.
+    std::size_t m_sweepOwnersAt;
+
+    // The current batch; views point into the sessions' input buffers.
+    std::vector<OrderView> m_orders;
+    std::vector<Pending> m_pending;
+    std::vector<OrderResult> m_results;
+    std::vector<ExecutionReport> m_reports;
+    // Sessions with output to flush and sessions to close once the batch
+    // no longer points into them.
+    std::vector<std::uint64_t> m_dirty;
+    std::vector<std::uint64_t> m_closing;
+};
+
+#endif
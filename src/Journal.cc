@@ -0,0 +1,144 @@
+#include "Journal.hpp"
+
+#include <cerrno>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Trading::Journal::Journal(const std::string& path, const JournalOptions options)
+    : m_options(options)
+{
+    m_buffer.reserve(m_options.groupSize * sizeof(JournalRecord) * 2);
+#if defined(__unix__) || defined(__APPLE__)
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    struct stat info{};
+    if (m_fd < 0 || ::fstat(m_fd, &info) != 0)
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+        throw std::runtime_error("Cannot open journal " + path);
+    }
+    m_written = static_cast<std::uint64_t>(info.st_size);
+#else
+    m_file = std::fopen(path.c_str(), "ab");
+    if (m_file == nullptr)
+    {
+        throw std::runtime_error("Cannot open journal " + path);
+    }
+    std::fseek(m_file, 0, SEEK_END);
+    m_written = static_cast<std::uint64_t>(std::ftell(m_file));
+#endif
+}
+
+Trading::Journal::~Journal()
+{
+    try
+    {
+        Flush();
+    }
+    catch (const std::exception&)
+    {
+        // Nothing more can be done about a failing disk from a destructor.
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    ::close(m_fd);
+#else
+    std::fclose(m_file);
+#endif
+}
+
+void Trading::Journal::AppendTrader(const TraderId trader,
+                                    const std::string_view name)
+{
+    JournalRecord record{};
+    record.trader = trader;
+    record.kind = JournalRecordKind::Trader;
+    record.quantity = name.size();
+    Append(record, name);
+}
+
+void Trading::Journal::Append(const JournalRecordKind kind,
+                              const OrderId orderId, const TraderId trader,
+                              const char side, const std::uint64_t quantity,
+                              const std::uint64_t price, const OrderType type)
+{
+    Append(JournalRecord{orderId, quantity, price, trader, kind, side, type, 0},
+           {});
+}
+
+void Trading::Journal::Append(const JournalRecord& record,
+                              const std::string_view name)
+{
+    m_buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_buffer.append(name);
+    if (++m_buffered >= m_options.groupSize)
+    {
+        Flush();
+    }
+}
+
+void Trading::Journal::Flush()
+{
+    if (m_buffer.empty())
+    {
+        return;
+    }
+
+    // Bytes leave the buffer as soon as they reach the file, so a flush
+    // retried after an error does not write them a second time.
+    const auto consume = [this](const std::size_t written)
+    {
+        m_written += written;
+        m_buffer.erase(0, written);
+    };
+#if defined(__unix__) || defined(__APPLE__)
+    while (!m_buffer.empty())
+    {
+        const ::ssize_t result =
+            ::write(m_fd, m_buffer.data(), m_buffer.size());
+        if (result < 0)
+        {
+            // Interrupted by a signal before anything was written.
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("Journal write failed");
+        }
+        consume(static_cast<std::size_t>(result));
+    }
+    m_buffered = 0;
+    if (m_options.sync)
+    {
+        int result = 0;
+        do
+        {
+#ifdef __linux__
+            result = ::fdatasync(m_fd);
+#else
+            result = ::fsync(m_fd);
+#endif
+        } while (result != 0 && errno == EINTR);
+        if (result != 0)
+        {
+            throw std::runtime_error("Journal sync failed");
+        }
+    }
+#else
+    const std::size_t written =
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+    const bool complete = written == m_buffer.size();
+    consume(written);
+    if (!complete || std::fflush(m_file) != 0)
+    {
+        throw std::runtime_error("Journal write failed");
+    }
+    m_buffered = 0;
+#endif
+}
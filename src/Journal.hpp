@@ -0,0 +1,142 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+class Journal;
+
+enum class JournalRecordKind : std::uint8_t
+{
+    // A trader was interned; quantity holds the length of the name that
+    // follows the record.
+    Trader = 1,
+    Order,
+    Cancel,
+    Amend,
+    // The engine's settings, written when the journal is opened, whenever
+    // they change and at every snapshot, so that a replay matches like the
+    // engine did. SelfTrade holds the SelfTradePrevention mode in
+    // quantity. RiskLimits holds maxOrderQuantity, maxPosition and
+    // maxOpenNotional in quantity, price and orderId; side is 'T' for the
+    // limits of trader, 0 for the defaults. Position holds the trader's
+    // net position in quantity.
+    SelfTrade,
+    RiskLimits,
+    Position
+};
+
+// Fixed part of every journal record, written in host byte order.
+struct JournalRecord
+{
+    OrderId orderId;
+    std::uint64_t quantity;
+    std::uint64_t price;
+    TraderId trader;
+    JournalRecordKind kind;
+    char side;
+    OrderType type;
+    std::uint8_t reserved;
+};
+
+static_assert(sizeof(JournalRecord) == 32 &&
+                  std::is_trivially_copyable_v<JournalRecord>,
+              "JournalRecord is written to and read from files as raw bytes");
+
+struct JournalOptions
+{
+    // Records buffered before they are written out together. 1 writes
+    // every record as soon as it is appended. Sinks see an order's fills
+    // as soon as it is matched, when up to groupSize - 1 records may still
+    // be buffered. Everything ProcessOrders and ProcessMessages return and
+    // every block Start() writes out is on disk first, and
+    // TradeEngine::FlushJournal writes the rest on demand.
+    std::size_t groupSize = 64;
+    // Whether every group write is followed by an fsync. Without it a group
+    // survives a process crash but not necessarily a power loss.
+    bool sync = true;
+};
+
+// Calls fn(record, name) for every complete record in data, in order, and
+// returns the length of the complete prefix. A record torn by a crash ends
+// the scan.
+template <typename Fn>
+std::size_t ReadJournal(std::string_view data, Fn&& fn);
+}  // namespace Trading
+
+// Append-only log of everything that changed the books. Records are
+// buffered and written, and optionally synced, a group at a time so the
+// cost of a sync is shared by every record in the group.
+class Trading::Journal final
+{
+   public:
+    // Opens path for appending, creating it if needed. Throws
+    // std::runtime_error if it cannot be opened.
+    Journal(const std::string& path, JournalOptions options);
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Writes and syncs whatever is still buffered.
+    ~Journal();
+
+    void AppendTrader(TraderId trader, std::string_view name);
+
+    void Append(JournalRecordKind kind, OrderId orderId, TraderId trader,
+                char side, std::uint64_t quantity, std::uint64_t price,
+                OrderType type = OrderType::Limit);
+
+    // name follows the record; only Trader records have one.
+    void Append(const JournalRecord& record, std::string_view name = {});
+
+    // Writes the buffered records and syncs them if configured to.
+    void Flush();
+
+    // Length of the journal file once everything appended is written.
+    [[nodiscard]] std::uint64_t Size() const noexcept
+    {
+        return m_written + m_buffer.size();
+    }
+
+   private:
+    const JournalOptions m_options;
+    std::string m_buffer;
+    std::size_t m_buffered = 0;
+    std::uint64_t m_written = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    int m_fd = -1;
+#else
+    std::FILE* m_file = nullptr;
+#endif
+};
+
+template <typename Fn>
+std::size_t Trading::ReadJournal(const std::string_view data, Fn&& fn)
+{
+    std::size_t offset = 0;
+    while (data.size() - offset >= sizeof(JournalRecord))
+    {
+        JournalRecord record;
+        std::memcpy(&record, data.data() + offset, sizeof(record));
+        const std::uint64_t nameLength =
+            record.kind == JournalRecordKind::Trader ? record.quantity : 0;
+        if (data.size() - offset - sizeof(record) < nameLength)
+        {
+            break;
+        }
+        fn(record, data.substr(offset + sizeof(record), nameLength));
+        offset += sizeof(record) + nameLength;
+    }
+    return offset;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRADING_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Trading::MappedFile::MappedFile(const std::string& path)
+{
+#ifdef TRADING_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size > 0)
+    {
+        void* const data =
+            ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        ::madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    m_copy.assign(std::istreambuf_iterator<char>(in), {});
+    m_data = m_copy.data();
+    m_size = m_copy.size();
+#endif
+}
+
+Trading::MappedFile::~MappedFile()
+{
+#ifdef TRADING_MMAP
+    if (m_data != nullptr)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+}
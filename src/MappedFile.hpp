@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Trading
+{
+class MappedFile;
+}
+
+// Read-only view of a whole file. On POSIX systems the file is memory
+// mapped and read ahead sequentially; elsewhere it is read into memory once.
+class Trading::MappedFile final
+{
+   public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    [[nodiscard]] std::string_view Data() const noexcept
+    {
+        return {m_data, m_size};
+    }
+
+   private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    // Holds the contents when the file could not be mapped.
+    std::string m_copy;
+};
+
+#endif
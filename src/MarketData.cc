@@ -0,0 +1,476 @@
+#include "MarketData.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRADING_SHM 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+// Every field of the region is an atomic word, so that readers racing the
+// writer are well defined, including across processes.
+using Word = std::atomic<std::uint64_t>;
+
+static_assert(Word::is_always_lock_free,
+              "Shared memory words must not need a process-local lock");
+
+constexpr std::uint64_t kMagic = 0x31444545464d5454;  // "TTMFEED1"
+constexpr std::uint64_t kVersion = 1;
+
+// Header words.
+enum : std::size_t
+{
+    kMagicWord,
+    kVersionWord,
+    kCapacityWord,
+    kLevelsWord,
+    // Index plus one of the newest complete snapshot.
+    kLatestSnapshotWord,
+    // Sequence of the last update written to the ring.
+    kPublishedWord,
+    kHeaderWords = 8
+};
+
+// A snapshot starts with a guard that is odd while it is written, then the
+// sequence it covers and the number of bid and ask levels, followed by
+// room for levels bids and then levels asks of three words each. A ring
+// slot is four words, the first holding the sequence of the update in it
+// or 0 while it is rewritten.
+constexpr std::size_t kSnapshotHeaderWords = 4;
+constexpr std::size_t kLevelWords = 3;
+constexpr std::size_t kSlotWords = sizeof(Trading::MarketDataUpdate) /
+                                   sizeof(std::uint64_t);
+
+struct Layout
+{
+    std::size_t capacity;
+    std::size_t levels;
+
+    [[nodiscard]] std::size_t SnapshotWords() const noexcept
+    {
+        return kSnapshotHeaderWords + 2 * levels * kLevelWords;
+    }
+
+    [[nodiscard]] std::size_t Snapshot(const std::size_t index) const noexcept
+    {
+        return kHeaderWords + index * SnapshotWords();
+    }
+
+    [[nodiscard]] std::size_t Slot(const std::uint64_t sequence) const noexcept
+    {
+        return kHeaderWords + 2 * SnapshotWords() +
+               static_cast<std::size_t>(sequence & (capacity - 1)) *
+                   kSlotWords;
+    }
+
+    [[nodiscard]] std::size_t Bytes() const noexcept
+    {
+        return (kHeaderWords + 2 * SnapshotWords() + capacity * kSlotWords) *
+               sizeof(Word);
+    }
+};
+
+Word* Words(void* const region) noexcept
+{
+    return static_cast<Word*>(region);
+}
+
+Layout LayoutOf(const Word* const words) noexcept
+{
+    return Layout{
+        static_cast<std::size_t>(
+            words[kCapacityWord].load(std::memory_order_relaxed)),
+        static_cast<std::size_t>(
+            words[kLevelsWord].load(std::memory_order_relaxed))};
+}
+
+// shm_open wants a single leading slash.
+std::string RegionName(const std::string& name)
+{
+    return name.empty() || name.front() != '/' ? '/' + name : name;
+}
+
+void StoreLevel(Word* const words, const Trading::DepthLevel& level) noexcept
+{
+    words[0].store(level.price, std::memory_order_relaxed);
+    words[1].store(level.quantity, std::memory_order_relaxed);
+    words[2].store(level.orders, std::memory_order_relaxed);
+}
+
+Trading::DepthLevel LoadLevel(const Word* const words) noexcept
+{
+    return Trading::DepthLevel{words[0].load(std::memory_order_relaxed),
+                               words[1].load(std::memory_order_relaxed),
+                               words[2].load(std::memory_order_relaxed)};
+}
+}  // namespace
+
+Trading::MarketDataPublisher::MarketDataPublisher(
+    const std::string& name, const MarketDataOptions options)
+    : m_name(RegionName(name)), m_options(options)
+{
+    if (options.capacity < 2 ||
+        (options.capacity & (options.capacity - 1)) != 0)
+    {
+        throw std::invalid_argument(
+            "ERROR: Market data capacity must be a power of two.");
+    }
+    if (options.snapshotInterval == 0 ||
+        options.snapshotInterval > options.capacity / 2)
+    {
+        throw std::invalid_argument(
+            "ERROR: Market data snapshots must come every 1 to capacity / 2 "
+            "updates.");
+    }
+
+#ifdef TRADING_SHM
+    const Layout layout{options.capacity, options.snapshotLevels};
+    m_size = layout.Bytes();
+    // Never take over an existing region: it may be the live feed of
+    // another publisher, and its readers would keep a mapping of an object
+    // that is being rewritten under them.
+    const int fd =
+        ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error(
+            errno == EEXIST ? "Shared memory " + m_name + " already exists"
+                            : "Cannot create shared memory " + m_name);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(m_size)) != 0)
+    {
+        ::close(fd);
+        ::shm_unlink(m_name.c_str());
+        throw std::runtime_error("Cannot size shared memory " + m_name);
+    }
+    m_region =
+        ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_region == MAP_FAILED)
+    {
+        m_region = nullptr;
+        ::shm_unlink(m_name.c_str());
+        throw std::runtime_error("Cannot map shared memory " + m_name);
+    }
+
+    Word* const words = Words(m_region);
+    for (std::size_t i = 0; i < m_size / sizeof(Word); ++i)
+    {
+        new (&words[i]) Word(0);
+    }
+    words[kVersionWord].store(kVersion, std::memory_order_relaxed);
+    words[kCapacityWord].store(options.capacity, std::memory_order_relaxed);
+    words[kLevelsWord].store(options.snapshotLevels,
+                             std::memory_order_relaxed);
+    // Readers can always start from an empty book at sequence 0.
+    PublishSnapshot({}, {});
+    words[kMagicWord].store(kMagic, std::memory_order_release);
+#else
+    throw std::runtime_error("Shared memory market data is not supported on "
+                             "this platform");
+#endif
+}
+
+Trading::MarketDataPublisher::~MarketDataPublisher()
+{
+#ifdef TRADING_SHM
+    if (m_region != nullptr)
+    {
+        ::munmap(m_region, m_size);
+        ::shm_unlink(m_name.c_str());
+    }
+#endif
+}
+
+void Trading::MarketDataPublisher::Publish(MarketDataUpdate update) noexcept
+{
+    update.sequence = ++m_published;
+    std::uint64_t values[kSlotWords];
+    std::memcpy(values, &update, sizeof(update));
+
+    Word* const words = Words(m_region);
+    Word* const slot = words + LayoutOf(words).Slot(update.sequence);
+    slot[0].store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 1; i < kSlotWords; ++i)
+    {
+        slot[i].store(values[i], std::memory_order_relaxed);
+    }
+    slot[0].store(update.sequence, std::memory_order_release);
+    words[kPublishedWord].store(update.sequence, std::memory_order_release);
+}
+
+void Trading::MarketDataPublisher::PublishLevel(const MarketDataKind kind,
+                                                const char side,
+                                                const DepthLevel& level) noexcept
+{
+    Publish(MarketDataUpdate{0,
+                             level.price,
+                             level.quantity,
+                             static_cast<std::uint32_t>(level.orders),
+                             kind,
+                             side,
+                             {}});
+}
+
+void Trading::MarketDataPublisher::PublishBest(const DepthLevel& bid,
+                                               const DepthLevel& ask) noexcept
+{
+    const auto publish = [this](DepthLevel& last, const DepthLevel& level,
+                                const char side)
+    {
+        if (level.price != last.price || level.quantity != last.quantity ||
+            level.orders != last.orders)
+        {
+            last = level;
+            PublishLevel(MarketDataKind::BestLevel, side, level);
+        }
+    };
+    publish(m_bestBid, bid, 'B');
+    publish(m_bestAsk, ask, 'S');
+}
+
+void Trading::MarketDataPublisher::Skip(const std::size_t count,
+                                        const DepthLevel& bid,
+                                        const DepthLevel& ask) noexcept
+{
+    m_published += count;
+    m_bestBid = bid;
+    m_bestAsk = ask;
+}
+
+void Trading::MarketDataPublisher::PublishSnapshot(
+    const Span<const DepthLevel> bids,
+    const Span<const DepthLevel> asks) noexcept
+{
+    Word* const words = Words(m_region);
+    const Layout layout = LayoutOf(words);
+
+    // Overwrite the older of the two, so that a reader still copying the
+    // newer one has a whole snapshot interval to finish.
+    const std::size_t index = m_snapshots++ % 2;
+    Word* const snapshot = words + layout.Snapshot(index);
+    const std::uint64_t guard = snapshot[0].load(std::memory_order_relaxed);
+    snapshot[0].store(guard + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const std::size_t bidCount = std::min(bids.size(), layout.levels);
+    const std::size_t askCount = std::min(asks.size(), layout.levels);
+    snapshot[1].store(m_published, std::memory_order_relaxed);
+    snapshot[2].store(bidCount, std::memory_order_relaxed);
+    snapshot[3].store(askCount, std::memory_order_relaxed);
+    Word* const levels = snapshot + kSnapshotHeaderWords;
+    for (std::size_t i = 0; i < bidCount; ++i)
+    {
+        StoreLevel(levels + i * kLevelWords, bids[i]);
+    }
+    for (std::size_t i = 0; i < askCount; ++i)
+    {
+        StoreLevel(levels + (layout.levels + i) * kLevelWords, asks[i]);
+    }
+
+    snapshot[0].store(guard + 2, std::memory_order_release);
+    words[kLatestSnapshotWord].store(index + 1, std::memory_order_release);
+    words[kPublishedWord].store(m_published, std::memory_order_release);
+    m_snapshotSequence = m_published;
+}
+
+Trading::MarketDataReader::MarketDataReader(const std::string& name)
+{
+#ifdef TRADING_SHM
+    const std::string region = RegionName(name);
+    const int fd = ::shm_open(region.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open shared memory " + region);
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat shared memory " + region);
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    m_region = m_size < kHeaderWords * sizeof(Word)
+                   ? MAP_FAILED
+                   : ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_region == MAP_FAILED)
+    {
+        m_region = nullptr;
+        throw std::runtime_error("Cannot map shared memory " + region);
+    }
+
+    const Word* const words = Words(m_region);
+    if (words[kMagicWord].load(std::memory_order_acquire) != kMagic ||
+        words[kVersionWord].load(std::memory_order_relaxed) != kVersion ||
+        LayoutOf(words).Bytes() != m_size)
+    {
+        ::munmap(m_region, m_size);
+        m_region = nullptr;
+        throw std::runtime_error(region + " is not a market data feed");
+    }
+#else
+    static_cast<void>(name);
+    throw std::runtime_error("Shared memory market data is not supported on "
+                             "this platform");
+#endif
+}
+
+Trading::MarketDataReader::~MarketDataReader()
+{
+#ifdef TRADING_SHM
+    if (m_region != nullptr)
+    {
+        ::munmap(m_region, m_size);
+    }
+#endif
+}
+
+Trading::ReadStatus Trading::MarketDataReader::Next(
+    MarketDataUpdate& update) noexcept
+{
+    const Word* const words = Words(m_region);
+    if (words[kPublishedWord].load(std::memory_order_acquire) < m_next)
+    {
+        return ReadStatus::Empty;
+    }
+
+    // The update was written, so any other sequence in its slot means it
+    // has been overwritten since.
+    const Word* const slot = words + LayoutOf(words).Slot(m_next);
+    std::uint64_t values[kSlotWords];
+    values[0] = slot[0].load(std::memory_order_acquire);
+    for (std::size_t i = 1; i < kSlotWords; ++i)
+    {
+        values[i] = slot[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (values[0] != m_next ||
+        slot[0].load(std::memory_order_relaxed) != m_next)
+    {
+        return ReadStatus::Lapped;
+    }
+
+    std::memcpy(&update, values, sizeof(update));
+    ++m_next;
+    return ReadStatus::Ok;
+}
+
+void Trading::MarketDataReader::Sync(DepthBook& book)
+{
+    const Word* const words = Words(m_region);
+    const Layout layout = LayoutOf(words);
+    std::vector<DepthLevel> bids;
+    std::vector<DepthLevel> asks;
+    std::uint64_t sequence = 0;
+    for (;;)
+    {
+        const std::size_t index = static_cast<std::size_t>(
+            words[kLatestSnapshotWord].load(std::memory_order_acquire) - 1);
+        const Word* const snapshot = words + layout.Snapshot(index);
+        const std::uint64_t guard =
+            snapshot[0].load(std::memory_order_acquire);
+        if ((guard & 1) != 0)
+        {
+            continue;
+        }
+
+        sequence = snapshot[1].load(std::memory_order_relaxed);
+        bids.resize(std::min<std::size_t>(
+            snapshot[2].load(std::memory_order_relaxed), layout.levels));
+        asks.resize(std::min<std::size_t>(
+            snapshot[3].load(std::memory_order_relaxed), layout.levels));
+        const Word* const levels = snapshot + kSnapshotHeaderWords;
+        for (std::size_t i = 0; i < bids.size(); ++i)
+        {
+            bids[i] = LoadLevel(levels + i * kLevelWords);
+        }
+        for (std::size_t i = 0; i < asks.size(); ++i)
+        {
+            asks[i] = LoadLevel(levels + (layout.levels + i) * kLevelWords);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (snapshot[0].load(std::memory_order_relaxed) == guard)
+        {
+            break;
+        }
+    }
+
+    book.Reset(sequence);
+    for (const DepthLevel& level : bids)
+    {
+        book.SetLevel('B', level);
+    }
+    for (const DepthLevel& level : asks)
+    {
+        book.SetLevel('S', level);
+    }
+    m_next = sequence + 1;
+}
+
+Trading::ReadStatus Trading::MarketDataReader::Poll(DepthBook& book)
+{
+    MarketDataUpdate update{};
+    ReadStatus status = ReadStatus::Ok;
+    while ((status = Next(update)) == ReadStatus::Ok)
+    {
+        book.Apply(update);
+    }
+    return status;
+}
+
+void Trading::DepthBook::Apply(const MarketDataUpdate& update)
+{
+    const DepthLevel level{update.price, update.quantity, update.orders};
+    Levels& levels = update.side == 'B' ? m_bids : m_asks;
+    switch (update.kind)
+    {
+        case MarketDataKind::LevelAdd:
+        case MarketDataKind::LevelUpdate:
+            levels[update.price] = level;
+            break;
+        case MarketDataKind::LevelDelete:
+            levels.erase(update.price);
+            break;
+        case MarketDataKind::BestLevel:
+            (update.side == 'B' ? m_bestBid : m_bestAsk) = level;
+            break;
+    }
+    m_sequence = update.sequence;
+}
+
+void Trading::DepthBook::Reset(const std::uint64_t sequence)
+{
+    m_bids.clear();
+    m_asks.clear();
+    m_bestBid = DepthLevel{};
+    m_bestAsk = DepthLevel{};
+    m_sequence = sequence;
+}
+
+void Trading::DepthBook::SetLevel(const char side, const DepthLevel& level)
+{
+    if (side == 'B')
+    {
+        m_bids[level.price] = level;
+        m_bestBid = m_bids.rbegin()->second;
+    }
+    else
+    {
+        m_asks[level.price] = level;
+        m_bestAsk = m_asks.begin()->second;
+    }
+}
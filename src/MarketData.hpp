@@ -0,0 +1,220 @@
+#ifndef MARKET_DATA_H
+#define MARKET_DATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+
+#include "BookSnapshot.hpp"
+#include "Span.hpp"
+
+namespace Trading
+{
+class MarketDataPublisher;
+class MarketDataReader;
+class DepthBook;
+
+enum class MarketDataKind : std::uint8_t
+{
+    // A price level appeared, changed or emptied on one side.
+    LevelAdd = 1,
+    LevelUpdate,
+    LevelDelete,
+    // The best level of one side changed; an empty side has price 0.
+    BestLevel
+};
+
+// One entry of the feed. Sequences start at 1 and have no gaps, and every
+// update an engine operation causes is published before the next
+// operation starts. An operation that changes more levels than the ring
+// holds publishes a snapshot in place of its updates instead; their
+// sequences are never written, so readers see Lapped and Sync to it.
+struct MarketDataUpdate
+{
+    std::uint64_t sequence;
+    std::uint64_t price;
+    std::uint64_t quantity;
+    std::uint32_t orders;
+    MarketDataKind kind;
+    char side;
+    std::uint8_t reserved[2];
+};
+
+static_assert(sizeof(MarketDataUpdate) == 32 &&
+                  std::is_trivially_copyable_v<MarketDataUpdate>,
+              "MarketDataUpdate is copied to and from shared memory words");
+
+struct MarketDataOptions
+{
+    // Updates kept in the ring; a power of two.
+    std::size_t capacity = std::size_t{1} << 16;
+    // Levels per side a snapshot holds. Deeper levels are left out of it.
+    std::size_t snapshotLevels = std::size_t{1} << 14;
+    // Updates between snapshots; at most half the capacity, so that the
+    // updates following a snapshot are still in the ring while a reader
+    // copies it.
+    std::size_t snapshotInterval = std::size_t{1} << 14;
+};
+
+enum class ReadStatus : std::uint8_t
+{
+    Ok,
+    // Nothing new has been published.
+    Empty,
+    // The writer overwrote updates the reader had not read yet; the reader
+    // has to Sync again.
+    Lapped
+};
+}  // namespace Trading
+
+// Writes the L2 feed of one engine to a named shared-memory region: a ring
+// of fixed-size updates and two alternating full-depth snapshots. Each ring
+// slot and snapshot is guarded by its own sequence word, so the single
+// writer never waits for readers and readers in any number of processes
+// detect torn or overwritten data instead of locking. The region is
+// removed when the publisher is destroyed.
+class Trading::MarketDataPublisher final
+{
+   public:
+    // Throws std::invalid_argument for bad options and std::runtime_error
+    // if the region cannot be created. A region that already exists under
+    // the name is an error rather than being replaced, since another
+    // publisher may still be writing it; one left behind by a publisher
+    // that crashed has to be removed (shm_unlink) before the name is used
+    // again.
+    MarketDataPublisher(const std::string& name, MarketDataOptions options);
+
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+    ~MarketDataPublisher();
+
+    void PublishLevel(MarketDataKind kind, char side,
+                      const DepthLevel& level) noexcept;
+
+    // Publishes BestLevel updates for the sides whose best level differs
+    // from the last one published.
+    void PublishBest(const DepthLevel& bid, const DepthLevel& ask) noexcept;
+
+    [[nodiscard]] bool SnapshotDue() const noexcept
+    {
+        return m_published - m_snapshotSequence >= m_options.snapshotInterval;
+    }
+
+    [[nodiscard]] std::size_t SnapshotLevels() const noexcept
+    {
+        return m_options.snapshotLevels;
+    }
+
+    [[nodiscard]] std::size_t Capacity() const noexcept
+    {
+        return m_options.capacity;
+    }
+
+    // Leaves the next count updates out of the ring and takes bid and ask
+    // as the best levels last published. Readers only see the sequence move
+    // once the snapshot that has to follow is stored.
+    void Skip(std::size_t count, const DepthLevel& bid,
+              const DepthLevel& ask) noexcept;
+
+    // Stores the depth after the last published update, best price first;
+    // levels beyond SnapshotLevels() are dropped.
+    void PublishSnapshot(Span<const DepthLevel> bids,
+                         Span<const DepthLevel> asks) noexcept;
+
+    // Sequence of the last published update.
+    [[nodiscard]] std::uint64_t Sequence() const noexcept
+    {
+        return m_published;
+    }
+
+   private:
+    void Publish(MarketDataUpdate update) noexcept;
+
+   private:
+    const std::string m_name;
+    const MarketDataOptions m_options;
+    void* m_region = nullptr;
+    std::size_t m_size = 0;
+    std::uint64_t m_published = 0;
+    std::uint64_t m_snapshotSequence = 0;
+    std::uint64_t m_snapshots = 0;
+    DepthLevel m_bestBid{};
+    DepthLevel m_bestAsk{};
+};
+
+// Follows a feed from any process. Updates are copied out of the ring one
+// slot at a time.
+class Trading::MarketDataReader final
+{
+   public:
+    // Throws std::runtime_error if the region does not exist or is not a
+    // market data feed.
+    explicit MarketDataReader(const std::string& name);
+
+    MarketDataReader(const MarketDataReader&) = delete;
+    MarketDataReader& operator=(const MarketDataReader&) = delete;
+
+    ~MarketDataReader();
+
+    // Reads the update after the last one read.
+    [[nodiscard]] ReadStatus Next(MarketDataUpdate& update) noexcept;
+
+    // Replaces book with the latest snapshot and continues with the first
+    // update after it.
+    void Sync(DepthBook& book);
+
+    // Applies every available update to book and returns Empty once caught
+    // up, or Lapped if the reader fell too far behind.
+    ReadStatus Poll(DepthBook& book);
+
+   private:
+    void* m_region = nullptr;
+    std::size_t m_size = 0;
+    std::uint64_t m_next = 1;
+};
+
+// Price levels rebuilt from a feed, as a reader process sees them.
+class Trading::DepthBook final
+{
+   public:
+    using Levels = std::map<std::uint64_t, DepthLevel>;
+
+    void Apply(const MarketDataUpdate& update);
+
+    // Empties the book and sets the sequence it is current as of.
+    void Reset(std::uint64_t sequence);
+
+    void SetLevel(char side, const DepthLevel& level);
+
+    [[nodiscard]] const Levels& Bids() const noexcept { return m_bids; }
+
+    [[nodiscard]] const Levels& Asks() const noexcept { return m_asks; }
+
+    [[nodiscard]] const DepthLevel& BestBid() const noexcept
+    {
+        return m_bestBid;
+    }
+
+    [[nodiscard]] const DepthLevel& BestAsk() const noexcept
+    {
+        return m_bestAsk;
+    }
+
+    // Sequence of the last update applied.
+    [[nodiscard]] std::uint64_t Sequence() const noexcept
+    {
+        return m_sequence;
+    }
+
+   private:
+    Levels m_bids;
+    Levels m_asks;
+    DepthLevel m_bestBid{};
+    DepthLevel m_bestAsk{};
+    std::uint64_t m_sequence = 0;
+};
+
+#endif
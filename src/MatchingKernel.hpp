@@ -0,0 +1,157 @@
+#ifndef MATCHING_KERNEL_H
+#define MATCHING_KERNEL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace Trading
+{
+struct BuySide;
+struct SellSide;
+
+// What the kernel does with the front resting order before trading with it.
+enum class CrossAction : std::uint8_t
+{
+    Trade,
+    // Drop the resting order without trading and carry on.
+    CancelResting,
+    // Stop matching; nothing of the incoming order rests.
+    CancelAggressor,
+    // Take the smaller open quantity off both without trading.
+    DecrementBoth
+};
+
+// Matches an order of Side against book, the resting orders of the other
+// side, best price first and in time priority, until quantity runs out or
+// the best resting price no longer crosses limit. After each fill, calls
+// onFill(price, quantity, resting) with the resting order as the fill left
+// it; the book drops the order right afterwards if nothing of it is left.
+// Returns the quantity still open. Book is any layout with the TreeBook
+// interface, so the kernel is compiled once per side and layout with every
+// side decision resolved at compile time.
+template <typename Side, typename Book, typename OnFill>
+std::uint64_t MatchAgainst(Book& book, std::uint64_t quantity,
+                           std::uint64_t limit, OnFill&& onFill);
+
+// As above, but first asks onCross(price, quantity, resting), with the
+// incoming order's open quantity, what to do with each resting order it
+// reaches. Returns 0 once onCross cancels the incoming order.
+template <typename Side, typename Book, typename OnCross, typename OnFill>
+std::uint64_t MatchAgainst(Book& book, std::uint64_t quantity,
+                           std::uint64_t limit, OnCross&& onCross,
+                           OnFill&& onFill);
+}  // namespace Trading
+
+// Compile-time description of the side an incoming order is on.
+struct Trading::BuySide
+{
+    using Opposite = SellSide;
+
+    static constexpr char kSide = 'B';
+    // Sign of the side in trade text.
+    static constexpr char kSign = '+';
+    // Limit of a market order, which trades at any price.
+    static constexpr std::uint64_t kMarketLimit =
+        std::numeric_limits<std::uint64_t>::max();
+
+    // Whether an order limited at limit trades with a resting price.
+    [[nodiscard]] static constexpr bool Crosses(
+        const std::uint64_t limit, const std::uint64_t resting) noexcept
+    {
+        return resting <= limit;
+    }
+
+    template <typename Books>
+    [[nodiscard]] static auto& Own(Books& books) noexcept
+    {
+        return books.buyOrders;
+    }
+
+    template <typename Books>
+    [[nodiscard]] static auto& Other(Books& books) noexcept
+    {
+        return books.sellOrders;
+    }
+};
+
+struct Trading::SellSide
+{
+    using Opposite = BuySide;
+
+    static constexpr char kSide = 'S';
+    static constexpr char kSign = '-';
+    static constexpr std::uint64_t kMarketLimit = 0;
+
+    [[nodiscard]] static constexpr bool Crosses(
+        const std::uint64_t limit, const std::uint64_t resting) noexcept
+    {
+        return resting >= limit;
+    }
+
+    template <typename Books>
+    [[nodiscard]] static auto& Own(Books& books) noexcept
+    {
+        return books.sellOrders;
+    }
+
+    template <typename Books>
+    [[nodiscard]] static auto& Other(Books& books) noexcept
+    {
+        return books.buyOrders;
+    }
+};
+
+template <typename Side, typename Book, typename OnFill>
+std::uint64_t Trading::MatchAgainst(Book& book, const std::uint64_t quantity,
+                                    const std::uint64_t limit,
+                                    OnFill&& onFill)
+{
+    return MatchAgainst<Side>(
+        book, quantity, limit,
+        [](std::uint64_t, std::uint64_t, const auto&) noexcept
+        { return CrossAction::Trade; },
+        onFill);
+}
+
+template <typename Side, typename Book, typename OnCross, typename OnFill>
+std::uint64_t Trading::MatchAgainst(Book& book, std::uint64_t quantity,
+                                    const std::uint64_t limit,
+                                    OnCross&& onCross, OnFill&& onFill)
+{
+    while (quantity > 0 && !book.Empty())
+    {
+        const std::uint64_t bestPrice = book.BestPrice();
+        if (!Side::Crosses(limit, bestPrice))
+        {
+            break;
+        }
+
+        const auto& resting = book.Front();
+        const std::uint64_t tradeQty = std::min(resting.quantity, quantity);
+        switch (onCross(bestPrice, quantity, resting))
+        {
+            case CrossAction::Trade:
+                quantity -= tradeQty;
+                book.Fill(tradeQty);
+                onFill(bestPrice, tradeQty, resting);
+                break;
+            case CrossAction::CancelResting:
+                book.PopFront();
+                continue;
+            case CrossAction::CancelAggressor:
+                return 0;
+            case CrossAction::DecrementBoth:
+                quantity -= tradeQty;
+                book.Fill(tradeQty);
+                break;
+        }
+        if (resting.quantity == 0)
+        {
+            book.PopFront();
+        }
+    }
+    return quantity;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "NodeArena.hpp"
+
+void Trading::NodeArena::Refill(const std::size_t sizeClass)
+{
+    // new[] of std::byte is aligned for any fundamental type, and every
+    // slot size is a multiple of that alignment.
+    const std::size_t slotSize = (sizeClass + 1) * kGranularity;
+    std::byte* const slab =
+        m_slabs.emplace_back(new std::byte[slotSize * m_slotsPerSlab]).get();
+
+    // Chain the slots so that the lowest address is handed out first.
+    for (std::size_t slot = m_slotsPerSlab; slot-- > 0;)
+    {
+        Release(slab + slot * slotSize, slotSize);
+    }
+}
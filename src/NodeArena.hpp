@@ -0,0 +1,142 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Trading
+{
+class NodeArena;
+
+template <typename T>
+class PoolAllocator;
+}  // namespace Trading
+
+// Pool of fixed-size slots for container nodes, carved out of large slabs.
+// Slots are grouped into 16-byte size classes, each with its own free
+// list, so a released node is handed out again by the next allocation of
+// the same size. Slabs are only returned when the arena is destroyed.
+class Trading::NodeArena final
+{
+   public:
+    static constexpr std::size_t kGranularity = 16;
+    static constexpr std::size_t kMaxSlotSize = 256;
+
+    explicit NodeArena(std::size_t slotsPerSlab = 256) noexcept
+        : m_slotsPerSlab(slotsPerSlab)
+    {
+    }
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // size must not exceed kMaxSlotSize.
+    [[nodiscard]] void* Allocate(const std::size_t size)
+    {
+        FreeSlot*& free = m_free[ClassOf(size)];
+        if (free == nullptr)
+        {
+            Refill(ClassOf(size));
+        }
+        FreeSlot* const slot = free;
+        free = slot->next;
+        return slot;
+    }
+
+    void Release(void* const slot, const std::size_t size) noexcept
+    {
+        FreeSlot*& free = m_free[ClassOf(size)];
+        free = new (slot) FreeSlot{free};
+    }
+
+    [[nodiscard]] std::size_t SlabCount() const noexcept
+    {
+        return m_slabs.size();
+    }
+
+   private:
+    struct FreeSlot
+    {
+        FreeSlot* next;
+    };
+
+    [[nodiscard]] static constexpr std::size_t ClassOf(
+        const std::size_t size) noexcept
+    {
+        return (size + kGranularity - 1) / kGranularity - 1;
+    }
+
+    void Refill(std::size_t sizeClass);
+
+   private:
+    const std::size_t m_slotsPerSlab;
+    std::array<FreeSlot*, kMaxSlotSize / kGranularity> m_free{};
+    std::vector<std::unique_ptr<std::byte[]>> m_slabs;
+};
+
+// Standard allocator drawing single objects from a NodeArena, which makes
+// it suitable for node-based containers such as std::map and std::list.
+// Array allocations fall through to the global allocator.
+template <typename T>
+class Trading::PoolAllocator
+{
+   public:
+    using value_type = T;
+
+    explicit PoolAllocator(NodeArena& arena) noexcept : m_arena(&arena) {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : m_arena(other.Arena())
+    {
+    }
+
+    [[nodiscard]] T* allocate(const std::size_t count)
+    {
+        if constexpr (sizeof(T) <= NodeArena::kMaxSlotSize &&
+                      alignof(T) <= alignof(std::max_align_t))
+        {
+            if (count == 1)
+            {
+                return static_cast<T*>(m_arena->Allocate(sizeof(T)));
+            }
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* const pointer, const std::size_t count) noexcept
+    {
+        if constexpr (sizeof(T) <= NodeArena::kMaxSlotSize &&
+                      alignof(T) <= alignof(std::max_align_t))
+        {
+            if (count == 1)
+            {
+                m_arena->Release(pointer, sizeof(T));
+                return;
+            }
+        }
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    [[nodiscard]] NodeArena* Arena() const noexcept { return m_arena; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept
+    {
+        return m_arena == other.Arena();
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept
+    {
+        return m_arena != other.Arena();
+    }
+
+   private:
+    NodeArena* m_arena;
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef OCCUPANCY_BITMAP_H
+#define OCCUPANCY_BITMAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace Trading
+{
+class OccupancyBitmap;
+}
+
+// Set of positions in [0, Size()) kept as a hierarchy of 64-bit words. Each
+// level has one bit per word of the level below, set while that word has
+// any bit set, and the top level is a single word. Finding the next or
+// previous set position is one count-zeros instruction per level up and
+// down, so a million positions take at most four words each way however
+// far apart the set positions are.
+class Trading::OccupancyBitmap final
+{
+   public:
+    static constexpr std::size_t kNone =
+        std::numeric_limits<std::size_t>::max();
+    // 64^6 positions; far beyond any price ladder.
+    static constexpr std::size_t kMaxDepth = 6;
+
+    OccupancyBitmap() { Reset(0); }
+
+    explicit OccupancyBitmap(const std::size_t size) { Reset(size); }
+
+    // Resizes to size positions, all clear.
+    void Reset(std::size_t size);
+
+    [[nodiscard]] std::size_t Size() const noexcept { return m_size; }
+
+    [[nodiscard]] bool Empty() const noexcept { return m_words.back() == 0; }
+
+    [[nodiscard]] bool Test(const std::size_t position) const noexcept
+    {
+        return (m_words[position / kBits] >> (position % kBits)) & 1;
+    }
+
+    void Set(std::size_t position) noexcept
+    {
+        for (std::size_t level = 0; level < m_depth; ++level)
+        {
+            std::uint64_t& word = m_words[m_offsets[level] + position / kBits];
+            const bool wasEmpty = word == 0;
+            word |= Bit(position);
+            if (!wasEmpty)
+            {
+                // The levels above already know about this word.
+                return;
+            }
+            position /= kBits;
+        }
+    }
+
+    void Clear(std::size_t position) noexcept
+    {
+        for (std::size_t level = 0; level < m_depth; ++level)
+        {
+            std::uint64_t& word = m_words[m_offsets[level] + position / kBits];
+            word &= ~Bit(position);
+            if (word != 0)
+            {
+                return;
+            }
+            position /= kBits;
+        }
+    }
+
+    // Lowest set position at or after position, kNone if there is none.
+    [[nodiscard]] std::size_t NextFrom(std::size_t position) const noexcept;
+
+    // Highest set position at or before position, kNone if there is none.
+    // Positions past the end count as the last one.
+    [[nodiscard]] std::size_t PrevFrom(std::size_t position) const noexcept;
+
+    [[nodiscard]] std::size_t First() const noexcept { return NextFrom(0); }
+
+    [[nodiscard]] std::size_t Last() const noexcept { return PrevFrom(kNone); }
+
+   private:
+    static constexpr std::size_t kBits = 64;
+
+    [[nodiscard]] static std::uint64_t Bit(const std::size_t position) noexcept
+    {
+        return std::uint64_t{1} << (position % kBits);
+    }
+
+    [[nodiscard]] static unsigned LowestBit(const std::uint64_t word) noexcept
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        unsigned bit = 0;
+        while (((word >> bit) & 1) == 0)
+        {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    [[nodiscard]] static unsigned HighestBit(const std::uint64_t word) noexcept
+    {
+#if defined(__GNUC__)
+        return static_cast<unsigned>(63 - __builtin_clzll(word));
+#else
+        unsigned bit = 63;
+        while (((word >> bit) & 1) == 0)
+        {
+            --bit;
+        }
+        return bit;
+#endif
+    }
+
+    // Words in level.
+    [[nodiscard]] std::size_t Words(const std::size_t level) const noexcept
+    {
+        return m_offsets[level + 1] - m_offsets[level];
+    }
+
+   private:
+    // Every level back to back, leaves first and the single top word last.
+    std::vector<std::uint64_t> m_words;
+    // Start of each level in m_words, plus the end of the last one.
+    std::array<std::size_t, kMaxDepth + 1> m_offsets{};
+    std::size_t m_depth = 0;
+    std::size_t m_size = 0;
+};
+
+inline void Trading::OccupancyBitmap::Reset(const std::size_t size)
+{
+    std::size_t depth = 0;
+    std::size_t total = 0;
+    std::size_t words = (size + kBits - 1) / kBits;
+    do
+    {
+        if (depth == kMaxDepth)
+        {
+            throw std::invalid_argument(
+                "ERROR: Occupancy bitmap size out of range.");
+        }
+        words = words == 0 ? 1 : words;
+        m_offsets[depth++] = total;
+        total += words;
+        words = (words + kBits - 1) / kBits;
+    } while (total - m_offsets[depth - 1] > 1);
+    m_offsets[depth] = total;
+
+    m_words.assign(total, 0);
+    m_depth = depth;
+    m_size = size;
+}
+
+inline std::size_t Trading::OccupancyBitmap::NextFrom(
+    std::size_t position) const noexcept
+{
+    if (position >= m_size)
+    {
+        return kNone;
+    }
+
+    // Climb until a word holds a set bit at or after position.
+    std::size_t level = 0;
+    for (;;)
+    {
+        const std::size_t index = position / kBits;
+        const std::uint64_t bits = m_words[m_offsets[level] + index] &
+                                   (~std::uint64_t{0} << (position % kBits));
+        if (bits != 0)
+        {
+            position = index * kBits + LowestBit(bits);
+            break;
+        }
+        position = index + 1;
+        if (++level == m_depth || position / kBits >= Words(level))
+        {
+            return kNone;
+        }
+    }
+
+    // Descend along the lowest set bits.
+    while (level-- > 0)
+    {
+        position = position * kBits +
+                   LowestBit(m_words[m_offsets[level] + position]);
+    }
+    return position;
+}
+
+inline std::size_t Trading::OccupancyBitmap::PrevFrom(
+    std::size_t position) const noexcept
+{
+    if (m_size == 0)
+    {
+        return kNone;
+    }
+    if (position >= m_size)
+    {
+        position = m_size - 1;
+    }
+
+    std::size_t level = 0;
+    for (;;)
+    {
+        const std::size_t index = position / kBits;
+        const std::uint64_t bits =
+            m_words[m_offsets[level] + index] &
+            (~std::uint64_t{0} >> (kBits - 1 - position % kBits));
+        if (bits != 0)
+        {
+            position = index * kBits + HighestBit(bits);
+            break;
+        }
+        if (index == 0 || ++level == m_depth)
+        {
+            return kNone;
+        }
+        position = index - 1;
+    }
+
+    while (level-- > 0)
+    {
+        position = position * kBits +
+                   HighestBit(m_words[m_offsets[level] + position]);
+    }
+    return position;
+}
+
+#endif
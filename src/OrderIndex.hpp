@@ -0,0 +1,165 @@
+#ifndef ORDER_INDEX_H
+#define ORDER_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+template <typename Value>
+class OrderIndex;
+}
+
+// Open-addressing hash table from order id to the location of a resting
+// order. Probing is linear over a flat slot array and erasing shifts the
+// following entries back, so there are no tombstones and lookups stay O(1)
+// under heavy cancel traffic. Memory is only allocated when the table grows.
+template <typename Value>
+class Trading::OrderIndex final
+{
+   public:
+    explicit OrderIndex(const std::size_t capacity = 1024) { Rehash(capacity); }
+
+    [[nodiscard]] std::size_t Size() const noexcept { return m_size; }
+
+    // Sizes the table so that count entries fit without growing.
+    void Reserve(const std::size_t count)
+    {
+        if (count * 2 > m_slots.size())
+        {
+            Rehash(count * 2);
+        }
+    }
+
+    [[nodiscard]] Value* Find(const OrderId id) noexcept
+    {
+        for (std::size_t slot = Home(id);; slot = (slot + 1) & m_mask)
+        {
+            if (m_slots[slot].id == id)
+            {
+                return &m_slots[slot].value;
+            }
+            if (m_slots[slot].id == kEmpty)
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    [[nodiscard]] bool Contains(const OrderId id) const noexcept
+    {
+        for (std::size_t slot = Home(id);; slot = (slot + 1) & m_mask)
+        {
+            if (m_slots[slot].id == id)
+            {
+                return true;
+            }
+            if (m_slots[slot].id == kEmpty)
+            {
+                return false;
+            }
+        }
+    }
+
+    // id must be non-zero and not present yet.
+    void Insert(const OrderId id, const Value& value)
+    {
+        if ((m_size + 1) * 2 > m_slots.size())
+        {
+            Rehash(m_slots.size() * 2);
+        }
+        Place(id, value);
+        ++m_size;
+    }
+
+    bool Erase(const OrderId id) noexcept
+    {
+        std::size_t hole = Home(id);
+        while (m_slots[hole].id != id)
+        {
+            if (m_slots[hole].id == kEmpty)
+            {
+                return false;
+            }
+            hole = (hole + 1) & m_mask;
+        }
+
+        // Pull back every following entry whose home slot lies at or before
+        // the hole, so probes for it still find it.
+        for (std::size_t slot = (hole + 1) & m_mask; m_slots[slot].id != kEmpty;
+             slot = (slot + 1) & m_mask)
+        {
+            const std::size_t home = Home(m_slots[slot].id);
+            const bool stays = hole <= slot ? (hole < home && home <= slot)
+                                            : (hole < home || home <= slot);
+            if (!stays)
+            {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+        m_slots[hole].id = kEmpty;
+        --m_size;
+        return true;
+    }
+
+   private:
+    static constexpr OrderId kEmpty = 0;
+
+    struct Slot
+    {
+        OrderId id = kEmpty;
+        Value value{};
+    };
+
+    // Fibonacci hashing spreads the sequential ids the engine hands out.
+    [[nodiscard]] std::size_t Home(const OrderId id) const noexcept
+    {
+        return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ULL) >>
+                                        m_shift);
+    }
+
+    void Place(const OrderId id, const Value& value) noexcept
+    {
+        std::size_t slot = Home(id);
+        while (m_slots[slot].id != kEmpty)
+        {
+            slot = (slot + 1) & m_mask;
+        }
+        m_slots[slot] = Slot{id, value};
+    }
+
+    void Rehash(const std::size_t capacity)
+    {
+        std::size_t size = 16;
+        unsigned bits = 4;
+        while (size < capacity)
+        {
+            size <<= 1;
+            ++bits;
+        }
+
+        std::vector<Slot> slots(size);
+        slots.swap(m_slots);
+        m_mask = size - 1;
+        m_shift = 64 - bits;
+        for (const Slot& slot : slots)
+        {
+            if (slot.id != kEmpty)
+            {
+                Place(slot.id, slot.value);
+            }
+        }
+    }
+
+   private:
+    std::vector<Slot> m_slots;
+    std::size_t m_mask = 0;
+    unsigned m_shift = 0;
+    std::size_t m_size = 0;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#include "OrderParser.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+constexpr std::uint64_t kMaxValue = std::numeric_limits<std::uint64_t>::max();
+
+bool IsSpace(const char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+           c == '\f';
+}
+
+bool IsDigit(const char c) noexcept
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+bool IsAlnum(const char c) noexcept
+{
+    return IsDigit(c) ||
+           static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+const char* SkipSpaces(const char* cursor, const char* end) noexcept
+{
+    while (cursor != end && IsSpace(*cursor))
+    {
+        ++cursor;
+    }
+    return cursor;
+}
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+    defined(_WIN32)
+// Eight ASCII digits at once in a 64-bit word (SWAR). Bytes are loaded in
+// little-endian order, so the first character ends up in the lowest byte.
+bool IsEightDigits(const std::uint64_t chunk) noexcept
+{
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+            (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+           0x3333333333333333;
+}
+
+std::uint64_t EightDigitsValue(std::uint64_t chunk) noexcept
+{
+    constexpr std::uint64_t mask = 0x000000FF000000FF;
+    constexpr std::uint64_t mul1 = 100 + (1000000ULL << 32);
+    constexpr std::uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    return (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+}
+
+#define TRADING_SWAR_DIGITS 1
+#endif
+
+// Parses a run of digits that must be followed by whitespace or the end of
+// the input. Fails on an empty run or on overflow.
+bool ParseUnsigned(const char*& cursor, const char* end,
+                   std::uint64_t& value) noexcept
+{
+    const char* start = cursor;
+    std::uint64_t result = 0;
+
+#ifdef TRADING_SWAR_DIGITS
+    while (end - cursor >= 8)
+    {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, cursor, sizeof(chunk));
+        if (!IsEightDigits(chunk))
+        {
+            break;
+        }
+        const std::uint64_t digits = EightDigitsValue(chunk);
+        if (result > (kMaxValue - digits) / 100000000)
+        {
+            return false;
+        }
+        result = result * 100000000 + digits;
+        cursor += 8;
+    }
+#endif
+
+    for (; cursor != end && IsDigit(*cursor); ++cursor)
+    {
+        const auto digit = static_cast<std::uint64_t>(*cursor - '0');
+        if (result > (kMaxValue - digit) / 10)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+
+    if (cursor == start || (cursor != end && !IsSpace(*cursor)))
+    {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+// Reads the next whitespace-delimited word.
+std::string_view NextWord(const char*& cursor, const char* end) noexcept
+{
+    const char* const start = cursor;
+    while (cursor != end && !IsSpace(*cursor))
+    {
+        ++cursor;
+    }
+    return std::string_view(start, static_cast<std::size_t>(cursor - start));
+}
+
+constexpr std::string_view kMarketSuffix = "MKT";
+}  // namespace
+
+Trading::ParseStatus Trading::ParseOrder(const std::string_view input,
+                                         OrderView& order) noexcept
+{
+    const char* cursor = input.data();
+    const char* const end = cursor + input.size();
+
+    cursor = SkipSpaces(cursor, end);
+    if (cursor == end)
+    {
+        return ParseStatus::Empty;
+    }
+
+    const char* const identifier = cursor;
+    while (cursor != end && IsAlnum(*cursor))
+    {
+        ++cursor;
+    }
+    if (cursor == identifier || (cursor != end && !IsSpace(*cursor)))
+    {
+        return ParseStatus::BadIdentifier;
+    }
+    const std::string_view trader(
+        identifier, static_cast<std::size_t>(cursor - identifier));
+
+    cursor = SkipSpaces(cursor, end);
+    if (cursor == end || (*cursor != 'B' && *cursor != 'S') ||
+        (cursor + 1 != end && !IsSpace(cursor[1])))
+    {
+        return ParseStatus::BadSide;
+    }
+    const char side = *cursor++;
+
+    std::uint64_t quantity{};
+    cursor = SkipSpaces(cursor, end);
+    if (!ParseUnsigned(cursor, end, quantity))
+    {
+        return ParseStatus::BadQuantity;
+    }
+
+    std::uint64_t price{};
+    OrderType type = OrderType::Limit;
+    cursor = SkipSpaces(cursor, end);
+    if (cursor != end && *cursor == kMarketSuffix.front())
+    {
+        if (NextWord(cursor, end) != kMarketSuffix)
+        {
+            return ParseStatus::BadPrice;
+        }
+        type = OrderType::Market;
+    }
+    else
+    {
+        if (!ParseUnsigned(cursor, end, price))
+        {
+            return ParseStatus::BadPrice;
+        }
+
+        cursor = SkipSpaces(cursor, end);
+        if (cursor != end)
+        {
+            const std::string_view suffix = NextWord(cursor, end);
+            if (suffix == OrderTypeSuffix(OrderType::ImmediateOrCancel))
+            {
+                type = OrderType::ImmediateOrCancel;
+            }
+            else if (suffix == OrderTypeSuffix(OrderType::FillOrKill))
+            {
+                type = OrderType::FillOrKill;
+            }
+            else if (suffix == OrderTypeSuffix(OrderType::PostOnly))
+            {
+                type = OrderType::PostOnly;
+            }
+            else
+            {
+                return ParseStatus::TrailingInput;
+            }
+        }
+    }
+
+    if (SkipSpaces(cursor, end) != end)
+    {
+        return ParseStatus::TrailingInput;
+    }
+
+    order = OrderView{trader, side, quantity, price, type};
+    return ParseStatus::Ok;
+}
+
+const char* Trading::ToString(const ParseStatus status) noexcept
+{
+    switch (status)
+    {
+        case ParseStatus::Ok:
+            return "ok";
+        case ParseStatus::Empty:
+            return "empty input";
+        case ParseStatus::BadIdentifier:
+            return "invalid identifier";
+        case ParseStatus::BadSide:
+            return "invalid side";
+        case ParseStatus::BadQuantity:
+            return "invalid quantity";
+        case ParseStatus::BadPrice:
+            return "invalid price";
+        case ParseStatus::TrailingInput:
+            return "unexpected trailing input";
+    }
+    return "unknown parse status";
+}
+
+std::string_view Trading::OrderTypeSuffix(const OrderType type) noexcept
+{
+    switch (type)
+    {
+        case OrderType::Limit:
+            return {};
+        case OrderType::Market:
+            return kMarketSuffix;
+        case OrderType::ImmediateOrCancel:
+            return "IOC";
+        case OrderType::FillOrKill:
+            return "FOK";
+        case OrderType::PostOnly:
+            return "POST";
+    }
+    return {};
+}
@@ -0,0 +1,46 @@
+#ifndef ORDER_PARSER_H
+#define ORDER_PARSER_H
+
+#include <cstdint>
+#include <string_view>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+// An order parsed in place: identifier points into the parsed buffer and is
+// only valid for as long as that buffer is.
+struct OrderView
+{
+    std::string_view identifier;
+    char side;
+    std::uint64_t quantity;
+    std::uint64_t price;
+    OrderType type = OrderType::Limit;
+};
+
+enum class ParseStatus : std::uint8_t
+{
+    Ok,
+    Empty,
+    BadIdentifier,
+    BadSide,
+    BadQuantity,
+    BadPrice,
+    TrailingInput
+};
+
+// Parses a line of the form "<identifier> <B|S> <quantity> <price>",
+// optionally followed by IOC, FOK or POST, or a market order of the form
+// "<identifier> <B|S> <quantity> MKT", without allocating or throwing.
+// order is only written when Ok is returned.
+[[nodiscard]] ParseStatus ParseOrder(std::string_view input,
+                                     OrderView& order) noexcept;
+
+[[nodiscard]] const char* ToString(ParseStatus status) noexcept;
+
+// The suffix ParseOrder accepts for type, empty for a limit order.
+[[nodiscard]] std::string_view OrderTypeSuffix(OrderType type) noexcept;
+}  // namespace Trading
+
+#endif
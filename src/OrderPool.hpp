@@ -0,0 +1,126 @@
+#ifndef ORDER_POOL_H
+#define ORDER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+class OrderPool;
+
+// The part of a resting order that matching touches: its open quantity,
+// its ids and the links of its level's FIFO queue. Price and side are
+// implied by the level and book it rests in, and the trader's name lives
+// in the TraderRegistry, so the record fits in half a cache line and is
+// aligned never to straddle two.
+struct alignas(32) RestingOrder
+{
+    std::uint64_t quantity;
+    OrderId orderId;
+    TraderId trader;
+    std::uint32_t next;
+    std::uint32_t prev;
+};
+
+static_assert(sizeof(RestingOrder) == 32 &&
+                  std::is_trivially_copyable_v<RestingOrder>,
+              "Two resting orders share every cache line of the pool");
+
+// First and last order of a level, as slots of its book's OrderPool.
+struct OrderQueue
+{
+    std::uint32_t head = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t tail = std::numeric_limits<std::uint32_t>::max();
+};
+}  // namespace Trading
+
+// Slab of RestingOrders addressed by 32-bit slot, with released slots kept
+// on a free list threaded through their next links. Slots stay put until
+// released, so books chain them into per-level queues by slot instead of
+// by pointer, and orders that arrive together sit next to each other.
+class Trading::OrderPool final
+{
+   public:
+    static constexpr std::uint32_t kNil =
+        std::numeric_limits<std::uint32_t>::max();
+
+    [[nodiscard]] RestingOrder& operator[](const std::uint32_t slot) noexcept
+    {
+        return m_orders[slot];
+    }
+
+    [[nodiscard]] const RestingOrder& operator[](
+        const std::uint32_t slot) const noexcept
+    {
+        return m_orders[slot];
+    }
+
+    // Appends a new order to the back of queue and returns its slot.
+    std::uint32_t PushBack(OrderQueue& queue, const TraderId trader,
+                           const std::uint64_t quantity,
+                           const OrderId orderId)
+    {
+        const RestingOrder order{quantity, orderId, trader, kNil, queue.tail};
+        std::uint32_t slot = m_free;
+        if (slot != kNil)
+        {
+            m_free = m_orders[slot].next;
+            m_orders[slot] = order;
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(m_orders.size());
+            m_orders.push_back(order);
+        }
+
+        if (queue.tail == kNil)
+        {
+            queue.head = slot;
+        }
+        else
+        {
+            m_orders[queue.tail].next = slot;
+        }
+        queue.tail = slot;
+        return slot;
+    }
+
+    // Takes the order in slot out of queue and frees the slot.
+    void Remove(OrderQueue& queue, const std::uint32_t slot) noexcept
+    {
+        RestingOrder& order = m_orders[slot];
+        if (order.prev == kNil)
+        {
+            queue.head = order.next;
+        }
+        else
+        {
+            m_orders[order.prev].next = order.next;
+        }
+        if (order.next == kNil)
+        {
+            queue.tail = order.prev;
+        }
+        else
+        {
+            m_orders[order.next].prev = order.prev;
+        }
+        order.next = m_free;
+        m_free = slot;
+    }
+
+    // Sizes the pool for this many orders, so that reaching them does not
+    // allocate.
+    void Reserve(const std::size_t orders) { m_orders.reserve(orders); }
+
+   private:
+    std::vector<RestingOrder> m_orders;
+    std::uint32_t m_free = kNil;
+};
+
+#endif
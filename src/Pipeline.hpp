@@ -0,0 +1,78 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace Trading
+{
+class Backoff;
+
+// What a pipeline stage does while the queue it waits on is empty or full.
+enum class WaitPolicy : std::uint8_t
+{
+    // Busy-waits: lowest latency, but each stage occupies a core.
+    Spin,
+    // Spins briefly, then yields the core to other threads.
+    Yield,
+    // Spins and yields briefly, then sleeps; for interactive use.
+    Sleep
+};
+
+struct PipelineOptions
+{
+    // Input lines a block carries from stage to stage. An interactive
+    // reader hands a block on early whenever no more input is buffered.
+    std::size_t blockLines = 256;
+    // Blocks in flight across all three stages. Once all of them are
+    // queued for matching or output, the reader stops reading.
+    std::size_t blocks = 64;
+    WaitPolicy wait = WaitPolicy::Sleep;
+};
+}  // namespace Trading
+
+// Escalating wait between polls of a lock-free queue.
+class Trading::Backoff final
+{
+   public:
+    static constexpr unsigned kSpins = 64;
+    static constexpr unsigned kYields = 256;
+    static constexpr std::chrono::microseconds kSleep{50};
+
+    explicit Backoff(const WaitPolicy policy) noexcept : m_policy(policy) {}
+
+    void Wait() noexcept
+    {
+        if (m_policy == WaitPolicy::Spin || m_rounds < kSpins)
+        {
+            ++m_rounds;
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        }
+        else if (m_policy == WaitPolicy::Yield || m_rounds < kYields)
+        {
+            ++m_rounds;
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(kSleep);
+        }
+    }
+
+    // Called once the awaited condition came true.
+    void Reset() noexcept { m_rounds = 0; }
+
+   private:
+    const WaitPolicy m_policy;
+    unsigned m_rounds = 0;
+};
+
+#endif
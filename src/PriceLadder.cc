@@ -0,0 +1,188 @@
+#include "PriceLadder.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace
+{
+constexpr std::size_t kInitialLevels = 1024;
+constexpr std::uint64_t kMaxPrice = std::numeric_limits<std::uint64_t>::max();
+
+// Base price of a window of size levels centred on price, clamped so the
+// window never runs past kMaxPrice.
+std::uint64_t CenteredBase(const std::uint64_t price,
+                           const std::size_t size) noexcept
+{
+    const std::uint64_t base = price - std::min<std::uint64_t>(price, size / 2);
+    return std::min<std::uint64_t>(base, kMaxPrice - (size - 1));
+}
+}  // namespace
+
+Trading::PriceLadder::PriceLadder(const char side, const std::size_t maxLevels)
+    : m_side(side), m_maxLevels(std::max<std::size_t>(maxLevels, 1))
+{
+}
+
+bool Trading::PriceLadder::CanHold(const std::uint64_t price) const noexcept
+{
+    if (m_activeLevels == 0)
+    {
+        return true;
+    }
+    const std::uint64_t top = m_basePrice + (m_levels.size() - 1);
+    const std::uint64_t low = std::min(m_basePrice, price);
+    const std::uint64_t high = std::max(top, price);
+    return high - low < m_maxLevels;
+}
+
+void Trading::PriceLadder::Reserve(const std::uint64_t price)
+{
+    const std::size_t size = m_levels.size();
+    if (size != 0 && price >= m_basePrice && price - m_basePrice < size)
+    {
+        return;
+    }
+
+    if (m_activeLevels == 0)
+    {
+        // Nothing rests on this side, so the window can simply move.
+        if (size == 0)
+        {
+            m_levels.resize(std::min(kInitialLevels, m_maxLevels));
+            m_occupied.Reset(m_levels.size());
+        }
+        m_basePrice = CenteredBase(price, m_levels.size());
+        return;
+    }
+
+    const std::uint64_t top = m_basePrice + (size - 1);
+    const std::uint64_t low = std::min(m_basePrice, price);
+    const std::uint64_t high = std::max(top, price);
+    const std::size_t newSize = std::min(
+        std::max<std::size_t>(high - low + 1, size * 2), m_maxLevels);
+
+    std::uint64_t newBase = low;
+    if (price < m_basePrice)
+    {
+        newBase = high + 1 >= newSize ? high + 1 - newSize : 0;
+    }
+    newBase = std::min<std::uint64_t>(newBase, kMaxPrice - (newSize - 1));
+
+    std::vector<Level> levels(newSize);
+    const std::size_t offset = m_basePrice - newBase;
+    std::copy(m_levels.begin(), m_levels.end(), levels.begin() + offset);
+    m_levels.swap(levels);
+
+    OccupancyBitmap occupied(newSize);
+    for (std::size_t position = m_occupied.First();
+         position != OccupancyBitmap::kNone;
+         position = m_occupied.NextFrom(position + 1))
+    {
+        occupied.Set(position + offset);
+    }
+    m_occupied = std::move(occupied);
+    m_basePrice = newBase;
+    m_best += offset;
+}
+
+void Trading::PriceLadder::Preallocate(const std::size_t orders,
+                                       const std::size_t levels)
+{
+    m_orders.Reserve(orders);
+    if (m_activeLevels == 0 && levels > m_levels.size())
+    {
+        m_levels.resize(std::min(levels, m_maxLevels));
+        m_occupied.Reset(m_levels.size());
+    }
+}
+
+Trading::PriceLadder::Handle Trading::PriceLadder::Push(
+    const std::uint64_t price, const TraderId trader,
+    const std::uint64_t quantity, const OrderId orderId)
+{
+    Reserve(price);
+    const std::size_t position = price - m_basePrice;
+
+    Level& level = m_levels[position];
+    const bool wasEmpty = level.orders++ == 0;
+    level.quantity += quantity;
+    const std::uint32_t slot =
+        m_orders.PushBack(level.queue, trader, quantity, orderId);
+    if (wasEmpty)
+    {
+        m_occupied.Set(position);
+        if (m_activeLevels++ == 0 || Better(position, m_best))
+        {
+            m_best = position;
+        }
+    }
+    return {price, slot};
+}
+
+void Trading::PriceLadder::PopFront() noexcept
+{
+    Level& level = m_levels[m_best];
+    const std::uint32_t slot = level.queue.head;
+    level.quantity -= m_orders[slot].quantity;
+    m_orders.Remove(level.queue, slot);
+    if (--level.orders != 0)
+    {
+        return;
+    }
+    m_occupied.Clear(m_best);
+    AdvanceBest();
+}
+
+void Trading::PriceLadder::Remove(const Handle& handle) noexcept
+{
+    const std::size_t position = handle.price - m_basePrice;
+    Level& level = m_levels[position];
+    level.quantity -= m_orders[handle.slot].quantity;
+    m_orders.Remove(level.queue, handle.slot);
+    if (--level.orders != 0)
+    {
+        return;
+    }
+    m_occupied.Clear(position);
+    if (position == m_best)
+    {
+        AdvanceBest();
+    }
+    else
+    {
+        --m_activeLevels;
+    }
+}
+
+void Trading::PriceLadder::AdvanceBest() noexcept
+{
+    if (--m_activeLevels == 0)
+    {
+        return;
+    }
+
+    // The level at m_best is already clear in the bitmap.
+    m_best = m_side == 'B' ? m_occupied.PrevFrom(m_best)
+                           : m_occupied.NextFrom(m_best);
+}
+
+void Trading::PriceLadder::Export(ordersMap& levels,
+                                  const TraderRegistry& traders) const
+{
+    levels.clear();
+    for (std::size_t position = m_occupied.First();
+         position != OccupancyBitmap::kNone;
+         position = m_occupied.NextFrom(position + 1))
+    {
+        std::uint32_t index = m_levels[position].queue.head;
+        const std::uint64_t price = m_basePrice + position;
+        auto& orders = levels[price];
+        for (; index != kNil; index = m_orders[index].next)
+        {
+            const Order& order = m_orders[index];
+            orders.push_back({std::string(traders.Name(order.trader)), m_side,
+                              order.quantity, price});
+        }
+    }
+}
@@ -0,0 +1,223 @@
+#ifndef PRICE_LADDER_H
+#define PRICE_LADDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "BookSnapshot.hpp"
+#include "OccupancyBitmap.hpp"
+#include "OrderPool.hpp"
+#include "TradeOrder.hpp"
+#include "TraderRegistry.hpp"
+
+namespace Trading
+{
+class PriceLadder;
+}
+
+// One side of the order book laid out as a contiguous array of price levels,
+// one per tick, with a cursor on the best level. Resting orders live in an
+// OrderPool and are chained into per-level FIFO queues by slot, so
+// matching walks adjacent memory instead of tree and list nodes. Each level
+// keeps its order count and total quantity, and an occupancy bitmap finds
+// the next non-empty level without scanning the empty ticks in between.
+class Trading::PriceLadder final
+{
+   public:
+    static constexpr std::uint32_t kNil = OrderPool::kNil;
+    static constexpr std::size_t kDefaultMaxLevels = std::size_t{1} << 20;
+
+    using Order = RestingOrder;
+
+    // Stays valid until the order is removed or filled.
+    struct Handle
+    {
+        std::uint64_t price;
+        std::uint32_t slot;
+    };
+
+    explicit PriceLadder(char side,
+                         std::size_t maxLevels = kDefaultMaxLevels);
+
+    [[nodiscard]] bool Empty() const noexcept { return m_activeLevels == 0; }
+
+    [[nodiscard]] std::size_t LevelCount() const noexcept
+    {
+        return m_activeLevels;
+    }
+
+    // False when resting an order at price would stretch the ladder past
+    // its configured number of levels.
+    [[nodiscard]] bool CanHold(std::uint64_t price) const noexcept;
+
+    [[nodiscard]] std::uint64_t BestPrice() const noexcept
+    {
+        return m_basePrice + m_best;
+    }
+
+    [[nodiscard]] const Order& Front() const noexcept
+    {
+        return m_orders[m_levels[m_best].queue.head];
+    }
+
+    // Takes quantity, at most all of it, from the front order.
+    void Fill(const std::uint64_t quantity) noexcept
+    {
+        Level& level = m_levels[m_best];
+        m_orders[level.queue.head].quantity -= quantity;
+        level.quantity -= quantity;
+    }
+
+    void PopFront() noexcept;
+
+    Handle Push(std::uint64_t price, TraderId trader, std::uint64_t quantity,
+                OrderId orderId);
+
+    // Quantity and number of orders resting at price, zero if none.
+    [[nodiscard]] DepthLevel LevelAt(const std::uint64_t price) const noexcept
+    {
+        if (price < m_basePrice || price - m_basePrice >= m_levels.size())
+        {
+            return DepthLevel{price, 0, 0};
+        }
+        const Level& level = m_levels[price - m_basePrice];
+        return DepthLevel{price, level.quantity, level.orders};
+    }
+
+    [[nodiscard]] const Order& Get(const Handle& handle) const noexcept
+    {
+        return m_orders[handle.slot];
+    }
+
+    // Lowers the order's quantity in place, keeping its time priority.
+    void Reduce(const Handle& handle, const std::uint64_t quantity) noexcept
+    {
+        Order& order = m_orders[handle.slot];
+        m_levels[handle.price - m_basePrice].quantity -=
+            order.quantity - quantity;
+        order.quantity = quantity;
+    }
+
+    [[nodiscard]] static std::uint64_t PriceOf(const Handle& handle) noexcept
+    {
+        return handle.price;
+    }
+
+    void Remove(const Handle& handle) noexcept;
+
+    // Sizes the order pool for this many resting orders and, while the
+    // side is still empty, the ladder for this many ticks around the first
+    // price, so that reaching them does not allocate.
+    void Preallocate(std::size_t orders, std::size_t levels);
+
+    // Rebuilds the ordersMap representation of this side, used by the
+    // public depth getters.
+    void Export(ordersMap& levels, const TraderRegistry& traders) const;
+
+    // Calls fn(price, quantity, orders) for each level, best price first,
+    // until fn returns false.
+    template <typename Fn>
+    void VisitLevels(Fn&& fn) const
+    {
+        if (m_activeLevels == 0)
+        {
+            return;
+        }
+        for (std::size_t position = m_best;
+             position != OccupancyBitmap::kNone;
+             position = NextWorse(position))
+        {
+            const Level& level = m_levels[position];
+            if (!fn(m_basePrice + position, level.quantity, level.orders))
+            {
+                return;
+            }
+        }
+    }
+
+    // Calls fn(price, order) for each resting order, best price first and
+    // in time priority within a level, until fn returns false.
+    template <typename Fn>
+    void VisitOrdersFromBest(Fn&& fn) const
+    {
+        VisitLevels(
+            [this, &fn](const std::uint64_t price, std::uint64_t,
+                        std::uint64_t)
+            {
+                for (std::uint32_t index =
+                         m_levels[price - m_basePrice].queue.head;
+                     index != kNil; index = m_orders[index].next)
+                {
+                    if (!fn(price, m_orders[index]))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+    }
+
+    // Calls fn(price, order) for every resting order, lowest price first
+    // and in time priority within a level.
+    template <typename Fn>
+    void VisitOrders(Fn&& fn) const
+    {
+        for (std::size_t position = m_occupied.First();
+             position != OccupancyBitmap::kNone;
+             position = m_occupied.NextFrom(position + 1))
+        {
+            for (std::uint32_t index = m_levels[position].queue.head;
+                 index != kNil; index = m_orders[index].next)
+            {
+                fn(m_basePrice + position, m_orders[index]);
+            }
+        }
+    }
+
+   private:
+    struct Level
+    {
+        OrderQueue queue;
+        std::uint32_t orders = 0;
+        std::uint64_t quantity = 0;
+    };
+
+    [[nodiscard]] bool Better(std::size_t lhs, std::size_t rhs) const noexcept
+    {
+        return m_side == 'B' ? lhs > rhs : lhs < rhs;
+    }
+
+    // Next non-empty level after position in price priority.
+    [[nodiscard]] std::size_t NextWorse(
+        const std::size_t position) const noexcept
+    {
+        if (m_side == 'B')
+        {
+            return position == 0 ? OccupancyBitmap::kNone
+                                 : m_occupied.PrevFrom(position - 1);
+        }
+        return m_occupied.NextFrom(position + 1);
+    }
+
+    void Reserve(std::uint64_t price);
+
+    // Moves the best level cursor off a level that just became empty.
+    void AdvanceBest() noexcept;
+
+   private:
+    const char m_side;
+    const std::size_t m_maxLevels;
+
+    std::uint64_t m_basePrice = 0;
+    std::size_t m_best = 0;
+    std::size_t m_activeLevels = 0;
+    std::vector<Level> m_levels;
+    // One bit per entry of m_levels, set while the level has orders.
+    OccupancyBitmap m_occupied;
+
+    OrderPool m_orders;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "Replay.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "OrderParser.hpp"
+#include "TradeEngine.hpp"
+
+namespace
+{
+constexpr std::size_t kBatchSize = 4096;
+constexpr std::size_t kOutputBlock = std::size_t{1} << 20;
+
+// Returns the line starting at offset, without its terminator, and moves
+// offset past it.
+std::string_view NextLine(const std::string_view input, std::size_t& offset)
+{
+    const char* const begin = input.data() + offset;
+    const std::size_t left = input.size() - offset;
+    const void* const newline = std::memchr(begin, '\n', left);
+    std::size_t length =
+        newline ? static_cast<const char*>(newline) - begin : left;
+    offset += newline ? length + 1 : length;
+    if (length > 0 && begin[length - 1] == '\r')
+    {
+        --length;
+    }
+    return {begin, length};
+}
+
+// Removes the engine's trade sink however the replay ends, as the sink
+// refers to the replay's locals.
+class SinkReset final
+{
+   public:
+    explicit SinkReset(Trading::TradeEngine& engine) noexcept
+        : m_engine(engine)
+    {
+    }
+
+    SinkReset(const SinkReset&) = delete;
+    SinkReset& operator=(const SinkReset&) = delete;
+
+    ~SinkReset() { m_engine.SetTradeSink(nullptr); }
+
+   private:
+    Trading::TradeEngine& m_engine;
+};
+}  // namespace
+
+Trading::ReplayStats Trading::ReplayOrders(TradeEngine& engine,
+                                           const std::string_view input,
+                                           std::ostream& output)
+{
+    std::string pending;
+    pending.reserve(kOutputBlock + 4096);
+    const SinkReset sinkReset(engine);
+    engine.SetTradeSink(
+        [&pending, &output](const std::string_view trades)
+        {
+            pending.append(trades);
+            pending.push_back('\n');
+            if (pending.size() >= kOutputBlock)
+            {
+                output.write(pending.data(),
+                             static_cast<std::streamsize>(pending.size()));
+                pending.clear();
+            }
+        });
+
+    ReplayStats stats{};
+    std::array<OrderView, kBatchSize> batch;
+    std::size_t offset = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (offset < input.size())
+    {
+        // Views into the input stay valid for the whole replay, so a batch
+        // is parsed first and then matched without copying.
+        std::size_t count = 0;
+        while (count < kBatchSize && offset < input.size())
+        {
+            const ParseStatus status =
+                ParseOrder(NextLine(input, offset), batch[count]);
+            if (status == ParseStatus::Ok)
+            {
+                ++count;
+            }
+            else if (status != ParseStatus::Empty)
+            {
+                ++stats.rejected;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            try
+            {
+                engine.ProcessOrder(batch[i]);
+                ++stats.orders;
+            }
+            catch (const std::invalid_argument&)
+            {
+                ++stats.rejected;
+            }
+        }
+    }
+    output.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+    output.flush();
+    stats.seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    return stats;
+}
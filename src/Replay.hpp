@@ -0,0 +1,29 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace Trading
+{
+class TradeEngine;
+
+struct ReplayStats
+{
+    std::uint64_t orders;
+    std::uint64_t rejected;
+    double seconds;
+};
+
+// Feeds every order line of input to the engine and writes its trades to
+// output, one line per order that traded, as Start() would. Lines are
+// split and parsed in place a batch at a time, and output is written in
+// large blocks. Lines that cannot be parsed or are rejected are counted
+// and skipped. The engine's trade sink is replaced for the replay and
+// removed when it returns or throws.
+ReplayStats ReplayOrders(TradeEngine& engine, std::string_view input,
+                         std::ostream& output);
+}  // namespace Trading
+
+#endif
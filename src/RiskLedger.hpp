@@ -0,0 +1,208 @@
+#ifndef RISK_LEDGER_H
+#define RISK_LEDGER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+class RiskLedger;
+
+// What the matcher does when an incoming order would trade with a resting
+// order of the same trader.
+enum class SelfTradePrevention : std::uint8_t
+{
+    // The orders trade with each other.
+    None,
+    // The resting order is cancelled and matching continues behind it.
+    CancelResting,
+    // Whatever is left of the incoming order is cancelled.
+    CancelAggressor,
+    // Both are reduced by the smaller open quantity without trading.
+    DecrementBoth
+};
+
+// Pre-trade limits of one trader. 0 leaves a limit off.
+struct RiskLimits
+{
+    std::uint64_t maxOrderQuantity = 0;
+    // Largest absolute net position an order may lead to if it fills in
+    // full.
+    std::uint64_t maxPosition = 0;
+    // Largest total price times quantity of the trader's resting orders,
+    // including the order being checked if it may rest.
+    std::uint64_t maxOpenNotional = 0;
+};
+}  // namespace Trading
+
+// Risk state of every trader in one flat array indexed by TraderId, so that
+// checking an order and booking a fill are each a single O(1) lookup. An
+// entry fits half a cache line; limits live in a short table of their own
+// that stays cached however many traders there are. Positions count the
+// fills booked since the ledger was enabled.
+class Trading::RiskLedger final
+{
+   public:
+    struct alignas(32) Entry
+    {
+        std::int64_t position;
+        std::uint64_t openNotional;
+        // Index into m_limits; 0 for the defaults.
+        std::uint32_t limits;
+    };
+
+    RiskLedger() : m_limits(1) {}
+
+    // Limits of every trader without limits of its own.
+    void SetDefaults(const RiskLimits& limits) { m_limits.front() = limits; }
+
+    [[nodiscard]] const RiskLimits& Defaults() const noexcept
+    {
+        return m_limits.front();
+    }
+
+    // Null if the trader has no limits of its own.
+    [[nodiscard]] const RiskLimits* OwnLimits(
+        const TraderId trader) const noexcept
+    {
+        return trader < m_entries.size() && m_entries[trader].limits != 0
+                   ? &m_limits[m_entries[trader].limits]
+                   : nullptr;
+    }
+
+    void SetLimits(const TraderId trader, const RiskLimits& limits)
+    {
+        Resize(trader + std::size_t{1});
+        std::uint32_t& index = m_entries[trader].limits;
+        if (index == 0)
+        {
+            index = static_cast<std::uint32_t>(m_limits.size());
+            m_limits.push_back(limits);
+        }
+        else
+        {
+            m_limits[index] = limits;
+        }
+    }
+
+    // Makes room for traders up to count - 1.
+    void Resize(const std::size_t count)
+    {
+        if (count > m_entries.size())
+        {
+            m_entries.resize(count, Entry{0, 0, 0});
+        }
+    }
+
+    // Throws OrderRejected if an order of trader would break one of
+    // its limits. restingNotional is the order's price times quantity if
+    // it may rest, 0 otherwise.
+    void Check(const TraderId trader, const bool buy,
+               const std::uint64_t quantity,
+               const std::uint64_t restingNotional) const
+    {
+        const Entry& entry = m_entries[trader];
+        const RiskLimits& limits = m_limits[entry.limits];
+        if (limits.maxOrderQuantity != 0 && quantity > limits.maxOrderQuantity)
+        {
+            throw OrderRejected(
+                RejectReason::QuantityLimit,
+                "ERROR: Order quantity above the trader's limit.");
+        }
+        if (limits.maxPosition != 0)
+        {
+            // Room left towards the limit in the order's direction.
+            const auto max = static_cast<std::int64_t>(
+                std::min<std::uint64_t>(limits.maxPosition, kMaxPosition));
+            const std::int64_t room =
+                buy ? max - entry.position : max + entry.position;
+            if (room < 0 || quantity > static_cast<std::uint64_t>(room))
+            {
+                throw OrderRejected(
+                    RejectReason::PositionLimit,
+                    "ERROR: Order could take the trader past its position "
+                    "limit.");
+            }
+        }
+        if (limits.maxOpenNotional != 0 &&
+            (restingNotional > limits.maxOpenNotional ||
+             entry.openNotional > limits.maxOpenNotional - restingNotional))
+        {
+            throw OrderRejected(
+                RejectReason::NotionalLimit,
+                "ERROR: Order would take the trader past its open notional "
+                "limit.");
+        }
+    }
+
+    // Price times quantity, saturating instead of wrapping around.
+    [[nodiscard]] static std::uint64_t Notional(
+        const std::uint64_t price, const std::uint64_t quantity) noexcept
+    {
+        std::uint64_t notional = 0;
+        if (__builtin_mul_overflow(price, quantity, &notional))
+        {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+        return notional;
+    }
+
+    void Fill(const TraderId trader, const bool buy,
+              const std::uint64_t quantity) noexcept
+    {
+        const auto signedQuantity = static_cast<std::int64_t>(quantity);
+        m_entries[trader].position += buy ? signedQuantity : -signedQuantity;
+    }
+
+    void Open(const TraderId trader, const std::uint64_t notional) noexcept
+    {
+        m_entries[trader].openNotional += notional;
+    }
+
+    void Close(const TraderId trader, const std::uint64_t notional) noexcept
+    {
+        m_entries[trader].openNotional -= notional;
+    }
+
+    // Forgets every open notional, before it is recounted from the books.
+    void ClearOpen() noexcept
+    {
+        for (Entry& entry : m_entries)
+        {
+            entry.openNotional = 0;
+        }
+    }
+
+    // Trader must be below the count last passed to Resize.
+    void SetPosition(const TraderId trader,
+                     const std::int64_t position) noexcept
+    {
+        m_entries[trader].position = position;
+    }
+
+    [[nodiscard]] std::int64_t Position(const TraderId trader) const noexcept
+    {
+        return trader < m_entries.size() ? m_entries[trader].position : 0;
+    }
+
+    [[nodiscard]] std::uint64_t OpenNotional(
+        const TraderId trader) const noexcept
+    {
+        return trader < m_entries.size() ? m_entries[trader].openNotional : 0;
+    }
+
+   private:
+    // Keeps position arithmetic clear of signed overflow.
+    static constexpr std::uint64_t kMaxPosition = std::uint64_t{1} << 62;
+
+    std::vector<Entry> m_entries;
+    std::vector<RiskLimits> m_limits;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Trading
+{
+template <typename T>
+class Seqlock;
+}
+
+// Publishes a trivially copyable value from one writer thread to any number
+// of readers. The writer never waits; a reader that overlaps a write simply
+// copies the value again. The value is kept as relaxed atomic words so that
+// the racing copies are well defined.
+template <typename T>
+class Trading::Seqlock final
+{
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Seqlock values are copied word by word");
+    static_assert(sizeof(T) % sizeof(std::uint64_t) == 0,
+                  "Seqlock values must be a whole number of words");
+
+   public:
+    Seqlock() noexcept : Seqlock(T{}) {}
+
+    explicit Seqlock(const T& value) noexcept { Store(value); }
+
+    // Single writer only.
+    void Store(const T& value) noexcept
+    {
+        std::uint64_t words[kWords];
+        std::memcpy(words, &value, sizeof(T));
+
+        const std::uint64_t sequence =
+            m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < kWords; ++i)
+        {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]] T Load() const noexcept
+    {
+        std::uint64_t words[kWords];
+        std::uint64_t before = 0;
+        std::uint64_t after = 0;
+        do
+        {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < kWords; ++i)
+            {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+   private:
+    static constexpr std::size_t kWords = sizeof(T) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> m_sequence{0};
+    std::atomic<std::uint64_t> m_words[kWords];
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "ShardedEngine.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "SpscQueue.hpp"
+#include "TradeEngine.hpp"
+
+namespace
+{
+enum class MessageKind : std::uint8_t
+{
+    AddBook,
+    Order
+};
+
+// For AddBook, order.identifier carries the instrument name.
+struct Message
+{
+    MessageKind kind = MessageKind::Order;
+    std::uint32_t book = 0;
+    Trading::TradeOrder order{};
+};
+
+void PinToCore(std::thread& thread, const std::size_t index)
+{
+#ifdef __linux__
+    const unsigned cores = std::max(1U, std::thread::hardware_concurrency());
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % cores, &cpus);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#else
+    (void)thread;
+    (void)index;
+#endif
+}
+}  // namespace
+
+struct Trading::ShardedEngine::Shard
+{
+    explicit Shard(const std::size_t capacity) : queue(capacity) {}
+
+    SpscQueue<Message> queue;
+    std::thread thread;
+    // Only touched by the shard's thread.
+    std::vector<std::unique_ptr<TradeEngine>> books;
+    std::uint64_t submitted = 0;
+    alignas(kCacheLineSize) std::atomic<std::uint64_t> processed{0};
+    std::atomic<std::uint64_t> rejected{0};
+};
+
+Trading::ShardedEngine::ShardedEngine(const std::size_t shardCount,
+                                      TradeSink sink, const BookType bookType,
+                                      const std::size_t queueCapacity,
+                                      const bool pinThreads,
+                                      const WaitPolicy wait)
+    : m_sink(std::move(sink)), m_bookType(bookType), m_wait(wait)
+{
+    if (shardCount == 0)
+    {
+        throw std::invalid_argument("ERROR: At least one shard is required.");
+    }
+
+    m_shards.reserve(shardCount);
+    for (std::size_t index = 0; index < shardCount; ++index)
+    {
+        m_shards.push_back(std::make_unique<Shard>(queueCapacity));
+    }
+    for (std::size_t index = 0; index < shardCount; ++index)
+    {
+        Shard& shard = *m_shards[index];
+        shard.thread = std::thread([this, &shard] { Run(shard); });
+        if (pinThreads)
+        {
+            PinToCore(shard.thread, index);
+        }
+    }
+}
+
+Trading::ShardedEngine::~ShardedEngine()
+{
+    m_stopping.store(true, std::memory_order_release);
+    for (const auto& shard : m_shards)
+    {
+        shard->thread.join();
+    }
+}
+
+void Trading::ShardedEngine::Submit(const std::string_view instrument,
+                                    const TradeOrder& order)
+{
+    const std::size_t known = m_instruments.Size();
+    const TraderId id = m_instruments.Intern(instrument);
+    const std::size_t shardCount = m_shards.size();
+    Shard& shard = *m_shards[id % shardCount];
+    const auto book = static_cast<std::uint32_t>(id / shardCount);
+
+    Message message{MessageKind::Order, book, order};
+    Backoff backoff(m_wait);
+    if (id == known)
+    {
+        Message addBook{MessageKind::AddBook, book,
+                        TradeOrder{std::string(instrument), 0, 0, 0}};
+        while (!shard.queue.TryPush(std::move(addBook)))
+        {
+            backoff.Wait();
+        }
+        backoff.Reset();
+        ++shard.submitted;
+    }
+    while (!shard.queue.TryPush(std::move(message)))
+    {
+        backoff.Wait();
+    }
+    ++shard.submitted;
+}
+
+void Trading::ShardedEngine::Flush()
+{
+    Backoff backoff(m_wait);
+    for (const auto& shard : m_shards)
+    {
+        while (shard->processed.load(std::memory_order_acquire) !=
+               shard->submitted)
+        {
+            backoff.Wait();
+        }
+    }
+}
+
+std::uint64_t Trading::ShardedEngine::GetRejectedOrders() const noexcept
+{
+    std::uint64_t rejected = 0;
+    for (const auto& shard : m_shards)
+    {
+        rejected += shard->rejected.load(std::memory_order_relaxed);
+    }
+    return rejected;
+}
+
+void Trading::ShardedEngine::Run(Shard& shard)
+{
+    Message message;
+    Backoff backoff(m_wait);
+    while (true)
+    {
+        if (!shard.queue.TryPop(message))
+        {
+            if (m_stopping.load(std::memory_order_acquire) &&
+                shard.queue.Empty())
+            {
+                return;
+            }
+            backoff.Wait();
+            continue;
+        }
+        backoff.Reset();
+
+        if (message.kind == MessageKind::AddBook)
+        {
+            auto engine = std::make_unique<TradeEngine>(
+                m_bookType, ConcurrencyMode::SingleWriter);
+            engine->SetTradeHistory(false);
+            engine->SetTradeSink(
+                [this, instrument = std::move(message.order.identifier)](
+                    const std::string_view trade)
+                { m_sink(instrument, trade); });
+            shard.books.push_back(std::move(engine));
+        }
+        else
+        {
+            try
+            {
+                shard.books[message.book]->ProcessOrder(message.order);
+            }
+            catch (const std::invalid_argument&)
+            {
+                shard.rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        shard.processed.fetch_add(1, std::memory_order_release);
+    }
+}
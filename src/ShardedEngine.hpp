@@ -0,0 +1,90 @@
+#ifndef SHARDED_ENGINE_H
+#define SHARDED_ENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "Pipeline.hpp"
+#include "TradeOrder.hpp"
+#include "TraderRegistry.hpp"
+
+namespace Trading
+{
+class ShardedEngine;
+}
+
+// Owns one order book per instrument and splits the instruments across
+// shards. Each shard has its own matching thread, fed by a lock-free SPSC
+// queue from the submitting thread, so orders of one instrument are always
+// matched in submission order while different shards run in parallel.
+class Trading::ShardedEngine final
+{
+   public:
+    static constexpr std::size_t kDefaultQueueCapacity = 1 << 16;
+
+    // Invoked on the matching thread of the instrument's shard. Shards call
+    // it concurrently, so it has to be thread-safe.
+    using TradeSink = std::function<void(std::string_view instrument,
+                                         std::string_view trade)>;
+
+    // wait is what a shard thread does while its queue is empty, and what
+    // Submit and Flush do while a queue is full or still draining, as for
+    // the stages of the Start() pipeline.
+    ShardedEngine(std::size_t shardCount, TradeSink sink,
+                  BookType bookType = BookType::Tree,
+                  std::size_t queueCapacity = kDefaultQueueCapacity,
+                  bool pinThreads = false,
+                  WaitPolicy wait = WaitPolicy::Sleep);
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine(ShardedEngine&&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(ShardedEngine&&) = delete;
+
+    // Drains every queue and joins the matching threads.
+    ~ShardedEngine();
+
+   public:
+    // Must always be called from the same thread. Waits while the shard's
+    // queue is full.
+    void Submit(std::string_view instrument, const TradeOrder& order);
+
+    // Waits until every submitted order has been matched. Same thread as
+    // Submit.
+    void Flush();
+
+    [[nodiscard]] std::size_t ShardCount() const noexcept
+    {
+        return m_shards.size();
+    }
+
+    [[nodiscard]] std::size_t InstrumentCount() const noexcept
+    {
+        return m_instruments.Size();
+    }
+
+    // Orders the books refused, e.g. for an unknown side.
+    [[nodiscard]] std::uint64_t GetRejectedOrders() const noexcept;
+
+   private:
+    struct Shard;
+
+    void Run(Shard& shard);
+
+   private:
+    const TradeSink m_sink;
+    const BookType m_bookType;
+    const WaitPolicy m_wait;
+    // Instrument names to ids, only touched by the submitting thread. An
+    // instrument id maps to shard id % shards, book id / shards.
+    TraderRegistry m_instruments;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_stopping{false};
+};
+
+#endif
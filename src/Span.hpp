@@ -0,0 +1,106 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace Trading
+{
+template <typename T>
+class Span;
+}  // namespace Trading
+
+// Non-owning view of contiguous elements, the subset of C++20 std::span the
+// engine needs. Span<const T> views read-only elements.
+template <typename T>
+class Trading::Span final
+{
+   public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    constexpr Span() noexcept = default;
+
+    constexpr Span(T* const data, const std::size_t size) noexcept
+        : m_data(data), m_size(size)
+    {
+    }
+
+    template <std::size_t N>
+    constexpr Span(T (&array)[N]) noexcept : m_data(array), m_size(N)
+    {
+    }
+
+    template <typename U, std::size_t N,
+              typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    constexpr Span(std::array<U, N>& array) noexcept
+        : m_data(array.data()), m_size(N)
+    {
+    }
+
+    template <typename U, std::size_t N,
+              typename = std::enable_if_t<std::is_convertible_v<const U*, T*>>>
+    constexpr Span(const std::array<U, N>& array) noexcept
+        : m_data(array.data()), m_size(N)
+    {
+    }
+
+    template <typename U, typename Allocator,
+              typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Span(std::vector<U, Allocator>& vector) noexcept
+        : m_data(vector.data()), m_size(vector.size())
+    {
+    }
+
+    template <typename U, typename Allocator,
+              typename = std::enable_if_t<std::is_convertible_v<const U*, T*>>>
+    Span(const std::vector<U, Allocator>& vector) noexcept
+        : m_data(vector.data()), m_size(vector.size())
+    {
+    }
+
+    // Span<T> converts to Span<const T>.
+    template <typename U,
+              typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    constexpr Span(const Span<U>& other) noexcept
+        : m_data(other.data()), m_size(other.size())
+    {
+    }
+
+    [[nodiscard]] constexpr T* data() const noexcept { return m_data; }
+
+    [[nodiscard]] constexpr std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+
+    [[nodiscard]] constexpr T& operator[](const std::size_t i) const noexcept
+    {
+        return m_data[i];
+    }
+
+    [[nodiscard]] constexpr iterator begin() const noexcept { return m_data; }
+
+    [[nodiscard]] constexpr iterator end() const noexcept
+    {
+        return m_data + m_size;
+    }
+
+    // The count elements starting at offset.
+    [[nodiscard]] constexpr Span subspan(const std::size_t offset,
+                                         const std::size_t count) const noexcept
+    {
+        return Span(m_data + offset, count);
+    }
+
+   private:
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Trading
+{
+template <typename T>
+class SpscQueue;
+
+inline constexpr std::size_t kCacheLineSize = 64;
+}  // namespace Trading
+
+// Bounded lock-free ring buffer for exactly one producer thread and one
+// consumer thread. Slots are allocated up front and reused, so pushing and
+// popping never allocate beyond what moving a T does.
+template <typename T>
+class Trading::SpscQueue final
+{
+   public:
+    // capacity is rounded up to a power of two.
+    explicit SpscQueue(const std::size_t capacity)
+        : m_slots(RoundUp(capacity)), m_mask(m_slots.size() - 1)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. Returns false when the queue is full.
+    template <typename U>
+    [[nodiscard]] bool TryPush(U&& value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == m_slots.size())
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == m_slots.size())
+            {
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = std::forward<U>(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the queue is empty.
+    [[nodiscard]] bool TryPop(T& value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+        value = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with the other thread.
+    [[nodiscard]] bool Empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::size_t Capacity() const noexcept
+    {
+        return m_slots.size();
+    }
+
+   private:
+    static std::size_t RoundUp(const std::size_t capacity) noexcept
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+   private:
+    std::vector<T> m_slots;
+    const std::size_t m_mask;
+
+    // Consumer side: its position and the last producer position it saw.
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_head{0};
+    std::size_t m_cachedTail = 0;
+
+    // Producer side: its position and the last consumer position it saw.
+    alignas(kCacheLineSize) std::atomic<std::size_t> m_tail{0};
+    std::size_t m_cachedHead = 0;
+};
+
+#endif
@@ -1,223 +1,1777 @@
 #include "TradeEngine.hpp"
 
+#include "MappedFile.hpp"
+#include "MatchingKernel.hpp"
+#include "SpscQueue.hpp"
+
 #include <algorithm>
 #include <iostream>
 #include <list>
-#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
-void Trading::TradeEngine::Start()
+namespace
+{
+// A run of input lines on its way through the Start() pipeline. The
+// reader fills in the lines and their parsed orders, the matcher the
+// trades and diagnostics, and the output thread writes both out.
+struct PipelineBlock
 {
     std::string input;
+    std::vector<std::size_t> lineEnds;
+    std::vector<Trading::OrderView> orders;
+    std::vector<Trading::ParseStatus> statuses;
+    // The trades of each order that traded, each followed by a newline.
+    std::string trades;
+    std::vector<std::size_t> tradeEnds;
+    std::string diagnostics;
+    // Set on the block that ends the input.
+    bool last = false;
+};
+
+// Never 0, which is what a thread's stats cache starts out with.
+std::atomic<std::uint64_t> nextStatsId{1};
+// Engines a thread remembers the stats slot of.
+constexpr std::size_t kMaxCachedEngines = 4096;
+
+// A snapshot is written in host byte order as
+//   "TMES" | uint32 version | uint64 last order id | uint64 sequence |
+//   uint64 last fill sequence | uint64 journal offset | uint32 trader count |
+//   per trader: uint32 length | name bytes |
+//   uint64 buy count | uint64 sell count | SnapshotOrder...
+// with the orders of each side lowest price first, in time priority.
+constexpr char kSnapshotMagic[4] = {'T', 'M', 'E', 'S'};
+constexpr std::uint32_t kSnapshotVersion = 2;
+// Version 1 snapshots have no fill sequence; fills then count from 1 again.
+constexpr std::uint32_t kSnapshotVersionWithoutFills = 1;
+constexpr std::size_t kSnapshotBlock = std::size_t{1} << 20;
+
+struct SnapshotOrder
+{
+    Trading::OrderId orderId;
+    std::uint64_t price;
+    std::uint64_t quantity;
+    Trading::TraderId trader;
+    std::uint32_t reserved;
+};
+
+template <typename T>
+void AppendRaw(std::string& data, const T& value)
+{
+    data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads consecutive values out of a snapshot, throwing if it ends early.
+class SnapshotReader
+{
+   public:
+    explicit SnapshotReader(const std::string_view data) noexcept
+        : m_data(data)
+    {
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        std::memcpy(&value, Take(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    std::string_view Take(const std::size_t size)
+    {
+        if (m_data.size() - m_offset < size)
+        {
+            throw std::runtime_error("Truncated snapshot");
+        }
+        const std::string_view bytes = m_data.substr(m_offset, size);
+        m_offset += size;
+        return bytes;
+    }
+
+   private:
+    std::string_view m_data;
+    std::size_t m_offset = 0;
+};
+}  // namespace
+
+const char* Trading::ToString(const RejectReason reason) noexcept
+{
+    switch (reason)
+    {
+        case RejectReason::None:
+            return "not rejected";
+        case RejectReason::UnknownTrader:
+            return "unknown trader";
+        case RejectReason::UnknownSide:
+            return "unknown side";
+        case RejectReason::UnknownType:
+            return "unknown order type";
+        case RejectReason::PriceOutOfRange:
+            return "price outside of book range";
+        case RejectReason::PostOnlyWouldTrade:
+            return "post-only order would trade";
+        case RejectReason::QuantityLimit:
+            return "order quantity limit";
+        case RejectReason::PositionLimit:
+            return "position limit";
+        case RejectReason::NotionalLimit:
+            return "open notional limit";
+        case RejectReason::Invalid:
+            return "invalid order";
+    }
+    return "unknown reject reason";
+}
+
+Trading::TradeEngine::TradeEngine(const BookType bookType,
+                                  const ConcurrencyMode concurrency)
+    : m_bookType(bookType),
+      m_concurrency(concurrency),
+      m_statsId(nextStatsId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+void Trading::TradeEngine::Start(const PipelineOptions& options)
+{
+    if (options.blockLines == 0 || options.blocks == 0)
+    {
+        throw std::invalid_argument(
+            "ERROR: A pipeline needs at least one block of one line.");
+    }
     std::cerr << "Enter inputs (e.g., T1 B 5 30), one per line. Press Ctrl+D "
                  "to end:"
               << std::endl;
 
-    std::istringstream input_stream(input);
-    while (std::getline(std::cin, input))
+    // Blocks circulate reader -> matcher -> output -> reader, so none of the
+    // queues can overflow, and running out of spare blocks is what stops
+    // the reader when matching or output falls behind.
+    std::vector<PipelineBlock> blocks(options.blocks);
+    SpscQueue<PipelineBlock*> parsed(options.blocks);
+    SpscQueue<PipelineBlock*> matched(options.blocks);
+    SpscQueue<PipelineBlock*> spare(options.blocks);
+    for (PipelineBlock& block : blocks)
+    {
+        static_cast<void>(spare.TryPush(&block));
+    }
+    std::atomic<bool> aborted{false};
+
+    std::thread reader(
+        [this, &options, &parsed, &spare, &aborted]()
+        {
+            std::istream& input = std::cin;
+            std::string line;
+            bool done = false;
+            while (!done)
+            {
+                PipelineBlock* block = nullptr;
+                Backoff backoff(options.wait);
+                while (!spare.TryPop(block))
+                {
+                    if (aborted.load(std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    backoff.Wait();
+                }
+
+                // Lines are copied in whole before parsing, since the
+                // parsed orders point into the block's text.
+                block->input.clear();
+                block->lineEnds.clear();
+                while (block->lineEnds.size() < options.blockLines)
+                {
+                    if (aborted.load(std::memory_order_relaxed) ||
+                        !std::getline(input, line))
+                    {
+                        done = true;
+                        break;
+                    }
+                    block->input.append(line);
+                    block->lineEnds.push_back(block->input.size());
+                    if (input.rdbuf()->in_avail() <= 0)
+                    {
+                        break;
+                    }
+                }
+
+                block->orders.resize(block->lineEnds.size());
+                block->statuses.resize(block->lineEnds.size());
+                ThreadStats* const stats = LocalStats();
+                std::size_t begin = 0;
+                for (std::size_t i = 0; i < block->lineEnds.size(); ++i)
+                {
+                    const std::string_view text(block->input.data() + begin,
+                                                block->lineEnds[i] - begin);
+                    begin = block->lineEnds[i];
+                    ScopedProbe probe(stats ? &stats->stages[0] : nullptr);
+                    block->statuses[i] = ParseOrder(text, block->orders[i]);
+                }
+                block->last = done;
+                static_cast<void>(parsed.TryPush(block));
+            }
+        });
+
+    // Trades are written straight to standard output unless a sink was
+    // installed, which is then called from the output thread instead.
+    TradeSink sink;
+    {
+        std::lock_guard lock(m_mutex);
+        sink = std::move(m_tradeSink);
+    }
+    std::thread writer(
+        [&options, &matched, &spare, &sink]()
+        {
+            Backoff backoff(options.wait);
+            for (;;)
+            {
+                PipelineBlock* block = nullptr;
+                if (!matched.TryPop(block))
+                {
+                    backoff.Wait();
+                    continue;
+                }
+                backoff.Reset();
+
+                if (!block->diagnostics.empty())
+                {
+                    std::cerr << block->diagnostics;
+                }
+                if (sink)
+                {
+                    std::size_t begin = 0;
+                    for (const std::size_t end : block->tradeEnds)
+                    {
+                        sink(std::string_view(block->trades)
+                                 .substr(begin, end - begin - 1));
+                        begin = end;
+                    }
+                }
+                else
+                {
+                    std::cout.write(
+                        block->trades.data(),
+                        static_cast<std::streamsize>(block->trades.size()));
+                }
+                if (block->last)
+                {
+                    std::cout.flush();
+                    return;
+                }
+                if (matched.Empty())
+                {
+                    std::cout.flush();
+                }
+                static_cast<void>(spare.TryPush(block));
+            }
+        });
+
+    PipelineBlock* current = nullptr;
+    SetTradeSink(
+        [&current](const std::string_view trades)
+        {
+            current->trades.append(trades);
+            current->trades.push_back('\n');
+            current->tradeEnds.push_back(current->trades.size());
+        });
+
+    try
     {
-        decltype(auto) TradeOrder = ParseInput(input);
-        ProcessOrder(TradeOrder);
-        for (const auto& trade : m_trades)
+        Backoff backoff(options.wait);
+        for (bool last = false; !last;)
         {
-            std::cout << trade << std::endl;
+            if (!parsed.TryPop(current))
+            {
+                backoff.Wait();
+                continue;
+            }
+            backoff.Reset();
+
+            current->trades.clear();
+            current->tradeEnds.clear();
+            current->diagnostics.clear();
+            for (std::size_t i = 0; i < current->orders.size(); ++i)
+            {
+                const ParseStatus status = current->statuses[i];
+                if (status == ParseStatus::Empty)
+                {
+                    continue;
+                }
+                if (status != ParseStatus::Ok)
+                {
+                    CountReject();
+                    ++m_rejectedLines;
+                    current->diagnostics.append("Skipping line: ")
+                        .append(ToString(status))
+                        .push_back('\n');
+                    continue;
+                }
+
+                try
+                {
+                    ProcessOrder(current->orders[i]);
+                }
+                catch (const std::invalid_argument& arg)
+                {
+                    ++m_rejectedLines;
+                    current->diagnostics.append("Skipping line: ")
+                        .append(arg.what())
+                        .push_back('\n');
+                }
+            }
+            // The block's trades are written out only once they are in the
+            // journal.
+            FlushJournal();
+            last = current->last;
+            static_cast<void>(matched.TryPush(current));
         }
     }
+    catch (...)
+    {
+        // Stop reading and let the output thread finish with what has been
+        // matched so far.
+        aborted.store(true, std::memory_order_release);
+        current->last = true;
+        static_cast<void>(matched.TryPush(current));
+        reader.join();
+        writer.join();
+        SetTradeSink(std::move(sink));
+        throw;
+    }
+    reader.join();
+    writer.join();
+    SetTradeSink(std::move(sink));
 }
 
-Trading::TradeEngine::TradeOrder Trading::TradeEngine::ParseInput(
-    const std::string& input)
+void Trading::TradeEngine::SetTradeSink(TradeSink sink)
 {
-    if (input.empty())
-    {
-        throw std::invalid_argument("Input for parseInput is empty");
-    }
+    std::lock_guard lock(m_mutex);
+    m_tradeSink = std::move(sink);
+}
 
-    std::istringstream iss(input);
-    std::string identifier;
-    char side{};
-    std::string quantity_str;
-    std::string price_str;
-    std::uint64_t quantity{};
-    std::uint64_t price{};
+void Trading::TradeEngine::SetFillSink(FillSink sink)
+{
+    std::lock_guard lock(m_mutex);
+    m_fillSink = std::move(sink);
+}
 
-    iss >> identifier >> side >> quantity_str >> price_str;
+void Trading::TradeEngine::SetReportSink(ReportSink sink)
+{
+    std::lock_guard lock(m_mutex);
+    m_reportSink = std::move(sink);
+}
 
-    if (!std::all_of(identifier.begin(), identifier.end(),
-                     [](const char c) { return std::isalnum(c); }))
+void Trading::TradeEngine::SetTradeHistory(const bool retain) noexcept
+{
+    std::lock_guard lock(m_mutex);
+    m_retainTrades = retain;
+    if (!retain)
     {
-        throw std::invalid_argument("Invalid identifier passed to parseInput");
+        m_trades.clear();
+        m_trades.shrink_to_fit();
     }
-    if (!std::isalpha(side))
+}
+
+Trading::TradeEngine::TradeOrder Trading::TradeEngine::ParseInput(
+    const std::string& input)
+{
+    ThreadStats* const stats = LocalStats();
+    ScopedProbe probe(stats ? &stats->stages[0] : nullptr);
+    OrderView order{};
+    const ParseStatus status = ParseOrder(input, order);
+    if (status != ParseStatus::Ok)
     {
-        throw std::invalid_argument("Invalid side passed to parseInput");
+        CountReject();
+        throw std::invalid_argument(
+            std::string("Invalid input passed to parseInput: ") +
+            ToString(status));
     }
+    return Trading::TradeEngine::TradeOrder{std::string(order.identifier),
+                                            order.side, order.quantity,
+                                            order.price, order.type};
+}
 
-    if (std::all_of(quantity_str.begin(), quantity_str.end(),
-                    [](const char c) { return std::isdigit(c); }))
+template <typename Fn>
+decltype(auto) Trading::TradeEngine::WithBooks(Fn&& fn)
+{
+    if (m_bookType == BookType::Ladder)
     {
-        quantity = std::stoull(quantity_str);
+        return fn(m_ladder);
     }
-    if (std::all_of(price_str.begin(), price_str.end(),
-                    [](const char c) { return std::isdigit(c); }))
+    return fn(m_tree);
+}
+
+template <typename Fn>
+decltype(auto) Trading::TradeEngine::WithBooks(Fn&& fn) const
+{
+    if (m_bookType == BookType::Ladder)
     {
-        price = std::stoull(price_str);
+        return fn(m_ladder);
     }
-    return Trading::TradeEngine::TradeOrder{identifier, side, quantity, price};
+    return fn(m_tree);
 }
 
-void Trading::TradeEngine::HandleBuy(const std::string& trader,
-                                     std::uint64_t quantity,
-                                     const std::uint64_t price) noexcept
+std::unique_lock<std::shared_mutex> Trading::TradeEngine::LockWriter()
 {
-    while (quantity > 0 && !m_sellOrders.empty())
+    if (m_concurrency == ConcurrencyMode::Locked)
     {
-        auto& [bestSellPrice, orders] = *m_sellOrders.begin();
-        if (bestSellPrice > price)
-        {
-            break;
-        }
+        return std::unique_lock(m_mutex);
+    }
+    return std::unique_lock(m_mutex, std::defer_lock);
+}
 
-        while (quantity > 0 && !orders.empty())
+template <typename Side, typename Book>
+void Trading::TradeEngine::Match(Books<Book>& books, const TraderId trader,
+                                 const OrderId orderId,
+                                 std::uint64_t quantity,
+                                 const std::uint64_t price,
+                                 const bool rest)
+{
+    constexpr bool buy = Side::kSide == 'B';
+    quantity = MatchAgainst<Side>(
+        Side::Other(books), quantity, price,
+        [&](const std::uint64_t restingPrice, const std::uint64_t open,
+            const auto& resting)
         {
-            auto& restingSellOrder = orders.front();
-            const std::uint64_t tradeQty =
-                std::min(restingSellOrder.quantity, quantity);
-            m_tradeInfo[{trader, '+'}][bestSellPrice] += tradeQty;
-            m_tradeInfo[{restingSellOrder.identifier, '-'}][bestSellPrice] +=
-                tradeQty;
+            if (m_selfTrade == SelfTradePrevention::None ||
+                resting.trader != trader)
+            {
+                return CrossAction::Trade;
+            }
+            if (m_marketData)
+            {
+                MarkLevel(books, Side::Opposite::kSide, restingPrice);
+            }
 
-            quantity -= tradeQty;
-            restingSellOrder.quantity -= tradeQty;
-            if (restingSellOrder.quantity == 0)
+            // The kernel takes this much off the resting order.
+            std::uint64_t removed = 0;
+            CrossAction action = CrossAction::Trade;
+            switch (m_selfTrade)
             {
-                orders.pop_front();
+                case SelfTradePrevention::CancelResting:
+                    removed = resting.quantity;
+                    action = CrossAction::CancelResting;
+                    break;
+                case SelfTradePrevention::CancelAggressor:
+                    return CrossAction::CancelAggressor;
+                case SelfTradePrevention::DecrementBoth:
+                    removed = std::min(resting.quantity, open);
+                    action = CrossAction::DecrementBoth;
+                    break;
+                default:
+                    return CrossAction::Trade;
             }
-        }
+            if (m_riskChecks)
+            {
+                m_risk.Close(resting.trader,
+                             RiskLedger::Notional(restingPrice, removed));
+            }
+            if (removed == resting.quantity)
+            {
+                books.index.Erase(resting.orderId);
+            }
+            return action;
+        },
+        [&](const std::uint64_t fillPrice, const std::uint64_t fillQty,
+            const auto& resting)
+        {
+            m_fills.push_back({++m_fillSequence, orderId, resting.orderId,
+                               fillPrice, fillQty, resting.quantity, trader,
+                               resting.trader, Side::kSide, {}});
+            if (m_riskChecks)
+            {
+                m_risk.Fill(trader, buy, fillQty);
+                m_risk.Fill(resting.trader, !buy, fillQty);
+                m_risk.Close(resting.trader,
+                             RiskLedger::Notional(fillPrice, fillQty));
+            }
+            if (resting.quantity == 0)
+            {
+                books.index.Erase(resting.orderId);
+            }
+        });
 
-        if (orders.empty())
+    if (quantity > 0 && rest)
+    {
+        books.index.Insert(
+            orderId, {Side::Own(books).Push(price, trader, quantity, orderId),
+                      Side::kSide});
+        if (m_riskChecks)
         {
-            m_sellOrders.erase(bestSellPrice);
+            m_risk.Open(trader, RiskLedger::Notional(price, quantity));
         }
     }
+}
 
-    if (quantity > 0)
+void Trading::TradeEngine::PublishFills()
+{
+    if (m_fills.empty())
     {
-        m_buyOrders[price].push_back({trader, 'B', quantity, price});
+        return;
     }
+    if (m_fillSink)
+    {
+        m_fillSink(m_fills.data(), m_fills.size());
+    }
+    EmitReports();
+    CollectTrades();
+    m_fills.clear();
 }
 
-void Trading::TradeEngine::HandleSell(const std::string& trader,
-                                      std::uint64_t quantity,
-                                      const std::uint64_t price) noexcept
+void Trading::TradeEngine::EmitReports()
 {
-    while (quantity > 0 && !m_buyOrders.empty())
+    if (!m_reportSink)
     {
-        auto& [bestBuyPrice, orders] = *m_buyOrders.rbegin();
-        if (bestBuyPrice < price)
-        {
-            break;
-        }
+        return;
+    }
 
-        while (quantity > 0 && !orders.empty())
-        {
-            auto& restingBuyOrder = orders.front();
-            const std::uint64_t tradeQty =
-                std::min(restingBuyOrder.quantity, quantity);
-            m_tradeInfo[{trader, '-'}][bestBuyPrice] += tradeQty;
-            m_tradeInfo[{restingBuyOrder.identifier, '+'}][bestBuyPrice] +=
-                tradeQty;
+    m_reports.clear();
+    for (const Fill& fill : m_fills)
+    {
+        m_reports.push_back({fill.aggressorOrderId,
+                             fill.price,
+                             fill.quantity,
+                             fill.aggressorTrader,
+                             fill.aggressorSide,
+                             'A',
+                             {}});
+        m_reports.push_back({fill.restingOrderId,
+                             fill.price,
+                             fill.quantity,
+                             fill.restingTrader,
+                             fill.aggressorSide == 'B' ? 'S' : 'B',
+                             'P',
+                             {}});
+    }
+    m_reportSink(m_reports.data(), m_reports.size());
+}
 
-            quantity -= tradeQty;
-            restingBuyOrder.quantity -= tradeQty;
+void Trading::TradeEngine::CollectTrades() noexcept
+{
+    if (!m_tradeSink && !m_retainTrades)
+    {
+        return;
+    }
 
-            if (restingBuyOrder.quantity == 0)
-            {
-                orders.pop_front();
-            }
-        }
+    const std::string_view trades = m_tradeFormatter.Format(m_fills);
+    if (m_tradeSink)
+    {
+        m_tradeSink(trades);
+    }
+    if (m_retainTrades)
+    {
+        m_trades.emplace_back(trades);
+    }
+}
+
+Trading::OrderId Trading::TradeEngine::ProcessOrder(const TradeOrder& order)
+{
+    return ProcessOrder(OrderView{order.identifier, order.side,
+                                  order.quantity, order.price, order.type});
+}
+
+Trading::OrderId Trading::TradeEngine::ProcessOrder(const OrderView& order)
+{
+    const auto lock = LockWriter();
+    return Submit(InternTrader(order.identifier), order.side, order.quantity,
+                  order.price, order.type)
+        .orderId;
+}
+
+std::size_t Trading::TradeEngine::ProcessOrders(
+    const Span<const TradeOrder> orders, const Span<OrderResult> results)
+{
+    return SubmitBatch(orders, results);
+}
+
+std::size_t Trading::TradeEngine::ProcessOrders(
+    const Span<const OrderView> orders, const Span<OrderResult> results)
+{
+    return SubmitBatch(orders, results);
+}
+
+template <typename Order>
+std::size_t Trading::TradeEngine::SubmitBatch(const Span<const Order> orders,
+                                              const Span<OrderResult> results)
+{
+    if (results.size() < orders.size())
+    {
+        throw std::invalid_argument(
+            "ERROR: Fewer results than orders in the batch.");
+    }
 
-        if (orders.empty())
+    std::size_t accepted = 0;
+    const auto lock = LockWriter();
+    for (std::size_t i = 0; i < orders.size(); ++i)
+    {
+        const Order& order = orders[i];
+        try
+        {
+            results[i] = Submit(InternTrader(order.identifier), order.side,
+                                order.quantity, order.price, order.type);
+            ++accepted;
+        }
+        catch (const OrderRejected& rejected)
+        {
+            results[i] = OrderResult{0, 0, 0, true, rejected.Reason()};
+        }
+        catch (const std::invalid_argument&)
         {
-            m_buyOrders.erase(bestBuyPrice);
+            results[i] = OrderResult{0, 0, 0, true, RejectReason::Invalid};
         }
     }
+    if (m_journal)
+    {
+        m_journal->Flush();
+    }
+    return accepted;
+}
 
-    if (quantity > 0)
+Trading::TraderId Trading::TradeEngine::InternTrader(
+    const std::string_view name)
+{
+    const std::size_t known = m_traders.Size();
+    const TraderId trader = m_traders.Intern(name);
+    if (m_journal && trader == known)
     {
-        m_sellOrders[price].push_back({trader, 'S', quantity, price});
+        m_journal->AppendTrader(trader, name);
     }
+    return trader;
 }
 
-void Trading::TradeEngine::CollectTrades() noexcept
+void Trading::TradeEngine::SetSelfTradePrevention(
+    const SelfTradePrevention mode)
+{
+    const auto lock = LockWriter();
+    m_selfTrade = mode;
+    if (m_journal)
+    {
+        m_journal->Append(JournalRecordKind::SelfTrade, 0, 0, 0,
+                          static_cast<std::uint64_t>(mode), 0);
+    }
+}
+
+void Trading::TradeEngine::SetRiskLimits(const RiskLimits& limits)
+{
+    const auto lock = LockWriter();
+    EnableRiskChecks();
+    m_risk.SetDefaults(limits);
+    if (m_journal)
+    {
+        JournalRiskLimits(0, false, limits);
+    }
+}
+
+void Trading::TradeEngine::SetRiskLimits(const std::string_view trader,
+                                         const RiskLimits& limits)
+{
+    const auto lock = LockWriter();
+    const TraderId id = InternTrader(trader);
+    EnableRiskChecks();
+    m_risk.SetLimits(id, limits);
+    if (m_journal)
+    {
+        JournalRiskLimits(id, true, limits);
+    }
+}
+
+void Trading::TradeEngine::EnableRiskChecks()
+{
+    if (!m_riskChecks)
+    {
+        m_riskChecks = true;
+        m_risk.Resize(m_traders.Size());
+        WithBooks([this](const auto& books) { CountOpenNotional(books); });
+    }
+}
+
+void Trading::TradeEngine::JournalSettings()
 {
-    std::vector<std::string> tradeOutput;
-	tradeOutput.reserve(m_tradeInfo.size());
-    for (const auto& [identifier, sign] : m_tradeInfo)
+    m_journal->Append(JournalRecordKind::SelfTrade, 0, 0, 0,
+                      static_cast<std::uint64_t>(m_selfTrade), 0);
+    if (!m_riskChecks)
     {
-        const std::string& trader = identifier.first;
-        const char trade_sign = identifier.second;
-        for (const auto& [price, quantity] : sign)
+        return;
+    }
+    JournalRiskLimits(0, false, m_risk.Defaults());
+    for (TraderId trader = 0; trader < m_traders.Size(); ++trader)
+    {
+        if (const RiskLimits* const limits = m_risk.OwnLimits(trader))
+        {
+            JournalRiskLimits(trader, true, *limits);
+        }
+        if (const std::int64_t position = m_risk.Position(trader))
         {
-            tradeOutput.emplace_back(trader + trade_sign +
-                                     std::to_string(quantity) + "@" +
-                                     std::to_string(price));
+            m_journal->Append(JournalRecordKind::Position, 0, trader, 0,
+                              static_cast<std::uint64_t>(position), 0);
         }
     }
+}
+
+void Trading::TradeEngine::JournalRiskLimits(const TraderId trader,
+                                             const bool own,
+                                             const RiskLimits& limits)
+{
+    m_journal->Append(JournalRecordKind::RiskLimits, limits.maxOpenNotional,
+                      trader, own ? 'T' : 0, limits.maxOrderQuantity,
+                      limits.maxPosition);
+}
+
+std::int64_t Trading::TradeEngine::GetPosition(
+    const std::string_view trader) const
+{
+    std::shared_lock lock(m_mutex);
+    const TraderId* const id = m_traders.Find(trader);
+    return id ? m_risk.Position(*id) : 0;
+}
+
+template <typename Book>
+void Trading::TradeEngine::CountOpenNotional(const Books<Book>& books)
+{
+    m_risk.ClearOpen();
+    const auto count = [this](const std::uint64_t price, const auto& order)
+    { m_risk.Open(order.trader, RiskLedger::Notional(price, order.quantity)); };
+    books.buyOrders.VisitOrders(count);
+    books.sellOrders.VisitOrders(count);
+}
+
+Trading::TraderId Trading::TradeEngine::RegisterTrader(
+    const std::string_view name)
+{
+    const auto lock = LockWriter();
+    return InternTrader(name);
+}
+
+Trading::OrderId Trading::TradeEngine::ProcessMessage(
+    const OrderMessage& message)
+{
+    const auto lock = LockWriter();
+    if (message.trader >= m_traders.Size())
+    {
+        CountReject();
+        throw OrderRejected(RejectReason::UnknownTrader,
+                            "ERROR: Unknown trader id.");
+    }
+    return Submit(message.trader, message.side, message.quantity,
+                  message.price, message.type)
+        .orderId;
+}
 
-    std::sort(tradeOutput.begin(), tradeOutput.end());
-    if (!tradeOutput.empty())
+std::size_t Trading::TradeEngine::ProcessMessages(const char* const data,
+                                                  const std::size_t size)
+{
+    std::size_t offset = 0;
+    for (; offset + kOrderMessageSize <= size; offset += kOrderMessageSize)
     {
-        std::stringstream ss;
-        for (const std::string& trade : tradeOutput)
+        try
         {
-            ss << trade << " ";
+            ProcessMessage(DecodeOrder(data + offset));
+        }
+        catch (const std::invalid_argument&)
+        {
+            const auto lock = LockWriter();
+            ++m_rejectedLines;
         }
-        std::string result = ss.str();
-        result.pop_back();
-        m_trades.emplace_back(result);
     }
-    m_tradeInfo.clear();
+    FlushJournal();
+    return offset;
 }
 
-void Trading::TradeEngine::ProcessOrder(const TradeOrder& order)
+Trading::OrderResult Trading::TradeEngine::Submit(const TraderId trader,
+                                                  const char side,
+                                                  const std::uint64_t quantity,
+                                                  const std::uint64_t price,
+                                                  const OrderType type)
 {
-    const std::string trader = order.identifier;
-    const char side = order.side;
-    const std::uint64_t quantity = order.quantity;
-    const std::uint64_t price = order.price;
+    ThreadStats* const stats = LocalStats();
+    const auto stage = [stats](const Stage which)
+    {
+        return stats ? &stats->stages[static_cast<std::size_t>(which)]
+                     : nullptr;
+    };
+    ScopedProbe probe(stage(Stage::ProcessOrder));
 
+    OrderId orderId = 0;
     {
-        std::lock_guard lock(m_mutex);
-        if (side == 'B')
+        ScopedProbe matchProbe(stage(Stage::Match));
+        try
         {
-            HandleBuy(trader, quantity, price);
+            orderId = WithBooks(
+                [&](auto& books)
+                {
+                    if (m_marketData)
+                    {
+                        MarkLevel(books, side, price);
+                    }
+                    const OrderId id =
+                        Dispatch(books, trader, side, quantity, price, type);
+                    ++m_sequence;
+                    PublishSnapshots(books);
+                    return id;
+                });
         }
-        else if (side == 'S')
+        catch (const std::invalid_argument&)
         {
-            HandleSell(trader, quantity, price);
+            m_levelMarks.clear();
+            CountReject();
+            throw;
         }
-        else
+    }
+    if (m_journal)
+    {
+        try
         {
-            throw std::invalid_argument("ERROR: Unknown side consumed.");
+            m_journal->Append(JournalRecordKind::Order, orderId, trader,
+                              side, quantity, price, type);
         }
-        CollectTrades();
+        catch (const std::runtime_error&)
+        {
+            // The order has traded and rests already; its fills must not
+            // leak into the next order's.
+            PublishFills();
+            throw;
+        }
+    }
+    if (stats)
+    {
+        ThreadStats::Add(stats->orders, 1);
+        CountFills(*stats);
     }
+
+    OrderResult result{orderId, 0,
+                       static_cast<std::uint32_t>(m_fills.size()), false,
+                       RejectReason::None};
+    for (const Fill& fill : m_fills)
+    {
+        result.filledQuantity += fill.quantity;
+    }
+
+    ScopedProbe collectProbe(stage(Stage::CollectTrades));
+    PublishFills();
+    return result;
 }
 
-const Trading::TradeEngine::ordersMap& Trading::TradeEngine::GetBuyOrders() const noexcept
+bool Trading::TradeEngine::Cancel(const OrderId orderId)
 {
-    std::shared_lock lock(m_mutex);
-    return m_buyOrders;
+    const auto lock = LockWriter();
+    const bool cancelled = CancelOrder(orderId);
+    if (cancelled && m_journal)
+    {
+        m_journal->Append(JournalRecordKind::Cancel, orderId, 0, 0, 0, 0);
+    }
+    return cancelled;
 }
 
-const Trading::TradeEngine::ordersMap& Trading::TradeEngine::GetSellOrders() const noexcept
+bool Trading::TradeEngine::CancelOrder(const OrderId orderId)
 {
-    std::shared_lock lock(m_mutex);
-    return m_sellOrders;
+    return WithBooks(
+        [&](auto& books)
+        {
+            const auto* const locator = books.index.Find(orderId);
+            if (locator == nullptr)
+            {
+                return false;
+            }
+            if (m_marketData)
+            {
+                MarkLevel(books, locator->side,
+                          books.buyOrders.PriceOf(locator->handle));
+            }
+            auto& book =
+                locator->side == 'B' ? books.buyOrders : books.sellOrders;
+            if (m_riskChecks)
+            {
+                const auto& resting = book.Get(locator->handle);
+                m_risk.Close(resting.trader,
+                             RiskLedger::Notional(
+                                 book.PriceOf(locator->handle),
+                                 resting.quantity));
+            }
+            book.Remove(locator->handle);
+            books.index.Erase(orderId);
+            ++m_sequence;
+            PublishSnapshots(books);
+            return true;
+        });
 }
 
-const std::vector<std::string>& Trading::TradeEngine::GetTrades() const noexcept
+bool Trading::TradeEngine::Amend(const OrderId orderId,
+                                 const std::uint64_t quantity,
+                                 const std::uint64_t price)
 {
-    std::shared_lock lock(m_mutex);
-    return m_trades;
-}
\ No newline at end of file
+    const auto lock = LockWriter();
+    const bool amended = WithBooks(
+        [&](auto& books) { return Amend(books, orderId, quantity, price); });
+    if (amended && m_journal)
+    {
+        try
+        {
+            m_journal->Append(JournalRecordKind::Amend, orderId, 0, 0,
+                              quantity, price);
+        }
+        catch (const std::runtime_error&)
+        {
+            PublishFills();
+            throw;
+        }
+    }
+    if (ThreadStats* const stats = LocalStats())
+    {
+        CountFills(*stats);
+    }
+    PublishFills();
+    return amended;
+}
+
+template <typename Book>
+bool Trading::TradeEngine::Amend(Books<Book>& books, const OrderId orderId,
+                                 const std::uint64_t quantity,
+                                 const std::uint64_t price)
+{
+    auto* const locator = books.index.Find(orderId);
+    if (locator == nullptr)
+    {
+        return false;
+    }
+
+    const char side = locator->side;
+    Book& book = side == 'B' ? books.buyOrders : books.sellOrders;
+    const auto& resting = book.Get(locator->handle);
+    const std::uint64_t oldPrice = Book::PriceOf(locator->handle);
+    if (quantity != 0 && quantity <= resting.quantity && price == oldPrice)
+    {
+        if (m_marketData)
+        {
+            MarkLevel(books, side, price);
+        }
+        if (m_riskChecks)
+        {
+            m_risk.Close(resting.trader,
+                         RiskLedger::Notional(
+                             price, resting.quantity - quantity));
+        }
+        book.Reduce(locator->handle, quantity);
+    }
+    else
+    {
+        if (quantity != 0 && !book.CanHold(price))
+        {
+            throw OrderRejected(RejectReason::PriceOutOfRange,
+                                "ERROR: Price outside of book range.");
+        }
+
+        const TraderId trader = resting.trader;
+        if (m_riskChecks)
+        {
+            // The amended order is checked as if it were new, without the
+            // notional it replaces.
+            const std::uint64_t notional =
+                RiskLedger::Notional(oldPrice, resting.quantity);
+            m_risk.Close(trader, notional);
+            try
+            {
+                if (quantity != 0)
+                {
+                    m_risk.Check(trader, side == 'B', quantity,
+                                 RiskLedger::Notional(price, quantity));
+                }
+            }
+            catch (const std::invalid_argument&)
+            {
+                m_risk.Open(trader, notional);
+                throw;
+            }
+        }
+        if (m_marketData)
+        {
+            MarkLevel(books, side, oldPrice);
+            MarkLevel(books, side, price);
+        }
+
+        book.Remove(locator->handle);
+        books.index.Erase(orderId);
+        if (side == 'B')
+        {
+            Match<BuySide>(books, trader, orderId, quantity, price, true);
+        }
+        else
+        {
+            Match<SellSide>(books, trader, orderId, quantity, price, true);
+        }
+    }
+    ++m_sequence;
+    PublishSnapshots(books);
+    return true;
+}
+
+template <typename Book>
+void Trading::TradeEngine::PublishSnapshots(const Books<Book>& books) noexcept
+{
+    if (m_marketData)
+    {
+        PublishMarketData(books);
+    }
+    if constexpr (kStatsEnabled)
+    {
+        m_restingOrders.store(books.index.Size(), std::memory_order_relaxed);
+        m_bidLevels.store(books.buyOrders.LevelCount(),
+                          std::memory_order_relaxed);
+        m_askLevels.store(books.sellOrders.LevelCount(),
+                          std::memory_order_relaxed);
+    }
+    if (m_snapshotDepth == 0)
+    {
+        return;
+    }
+
+    BookSnapshot snapshot{};
+    snapshot.sequence = m_sequence;
+    const auto collect = [this](const Book& book, auto& levels,
+                                std::uint64_t& count)
+    {
+        book.VisitLevels(
+            [this, &levels, &count](const std::uint64_t price,
+                                    const std::uint64_t quantity,
+                                    const std::uint64_t orders)
+            {
+                levels[count++] = DepthLevel{price, quantity, orders};
+                return count < m_snapshotDepth;
+            });
+    };
+    collect(books.buyOrders, snapshot.bids, snapshot.bidLevels);
+    collect(books.sellOrders, snapshot.asks, snapshot.askLevels);
+
+    m_topOfBook.Store(
+        TopOfBook{m_sequence, snapshot.bids[0], snapshot.asks[0]});
+    m_bookSnapshot.Store(snapshot);
+}
+
+template <typename Book>
+void Trading::TradeEngine::MarkLevel(const Books<Book>& books, const char side,
+                                     const std::uint64_t price)
+{
+    for (const LevelMark& mark : m_levelMarks)
+    {
+        if (mark.side == side && mark.price == price)
+        {
+            return;
+        }
+    }
+    const Book& book = side == 'B' ? books.buyOrders : books.sellOrders;
+    m_levelMarks.push_back({side, price, book.LevelAt(price).orders != 0});
+}
+
+template <typename Book>
+void Trading::TradeEngine::PublishMarketData(const Books<Book>& books) noexcept
+{
+    // Every level traded against had orders on it before, and fills at one
+    // level are recorded next to each other.
+    for (std::size_t i = 0; i < m_fills.size(); ++i)
+    {
+        const Fill& fill = m_fills[i];
+        if (i == 0 || fill.price != m_fills[i - 1].price)
+        {
+            m_levelMarks.push_back(
+                {fill.aggressorSide == 'B' ? 'S' : 'B', fill.price, true});
+        }
+    }
+
+    const auto best = [](const Book& book)
+    { return book.Empty() ? DepthLevel{} : book.LevelAt(book.BestPrice()); };
+
+    // Updates that overrun the ring would lap every reader before the
+    // operation's snapshot exists, so it is published in their place.
+    if (m_levelMarks.size() + 2 > m_marketData->Capacity())
+    {
+        m_marketData->Skip(m_levelMarks.size(), best(books.buyOrders),
+                           best(books.sellOrders));
+        m_levelMarks.clear();
+        PublishDepthSnapshot(books);
+        return;
+    }
+
+    for (const LevelMark& mark : m_levelMarks)
+    {
+        const Book& book =
+            mark.side == 'B' ? books.buyOrders : books.sellOrders;
+        const DepthLevel level = book.LevelAt(mark.price);
+        if (level.orders != 0)
+        {
+            m_marketData->PublishLevel(mark.existed
+                                           ? MarketDataKind::LevelUpdate
+                                           : MarketDataKind::LevelAdd,
+                                       mark.side, level);
+        }
+        else if (mark.existed)
+        {
+            m_marketData->PublishLevel(MarketDataKind::LevelDelete, mark.side,
+                                       level);
+        }
+    }
+    m_levelMarks.clear();
+
+    m_marketData->PublishBest(best(books.buyOrders), best(books.sellOrders));
+    if (m_marketData->SnapshotDue())
+    {
+        PublishDepthSnapshot(books);
+    }
+}
+
+template <typename Book>
+void Trading::TradeEngine::PublishDepthSnapshot(
+    const Books<Book>& books) noexcept
+{
+    const std::size_t limit = m_marketData->SnapshotLevels();
+    const auto collect = [limit](const Book& book,
+                                 std::vector<DepthLevel>& levels)
+    {
+        levels.clear();
+        if (limit == 0)
+        {
+            return;
+        }
+        book.VisitLevels(
+            [limit, &levels](const std::uint64_t price,
+                             const std::uint64_t quantity,
+                             const std::uint64_t orders)
+            {
+                levels.push_back(DepthLevel{price, quantity, orders});
+                return levels.size() < limit;
+            });
+    };
+    collect(books.buyOrders, m_depthBids);
+    collect(books.sellOrders, m_depthAsks);
+    m_marketData->PublishSnapshot(m_depthBids, m_depthAsks);
+}
+
+template <typename Side, typename Book>
+bool Trading::TradeEngine::CanFill(const Book& book, const TraderId trader,
+                                   const std::uint64_t quantity,
+                                   const std::uint64_t price) const noexcept
+{
+    std::uint64_t available = 0;
+    if (m_selfTrade != SelfTradePrevention::None)
+    {
+        bool blocked = false;
+        book.VisitOrdersFromBest(
+            [&](const std::uint64_t orderPrice, const auto& order)
+            {
+                if (!Side::Crosses(price, orderPrice))
+                {
+                    return false;
+                }
+                blocked = order.trader == trader;
+                available += order.quantity;
+                return !blocked && available < quantity;
+            });
+        return !blocked && available >= quantity;
+    }
+
+    // Level totals make this a walk over levels, not orders.
+    book.VisitLevels(
+        [&](const std::uint64_t levelPrice, const std::uint64_t levelQuantity,
+            std::uint64_t)
+        {
+            if (!Side::Crosses(price, levelPrice))
+            {
+                return false;
+            }
+            available += levelQuantity;
+            return available < quantity;
+        });
+    return available >= quantity;
+}
+
+template <typename Book>
+Trading::OrderId Trading::TradeEngine::Dispatch(Books<Book>& books,
+                                                const TraderId trader,
+                                                const char side,
+                                                const std::uint64_t quantity,
+                                                const std::uint64_t price,
+                                                const OrderType type)
+{
+    switch (side)
+    {
+        case 'B':
+            return Place<BuySide>(books, trader, quantity, price, type);
+        case 'S':
+            return Place<SellSide>(books, trader, quantity, price, type);
+        default:
+            throw OrderRejected(RejectReason::UnknownSide,
+                                "ERROR: Unknown side consumed.");
+    }
+}
+
+template <typename Side, typename Book>
+Trading::OrderId Trading::TradeEngine::Place(Books<Book>& books,
+                                             const TraderId trader,
+                                             const std::uint64_t quantity,
+                                             std::uint64_t price,
+                                             const OrderType type)
+{
+    const Book& opposite = Side::Other(books);
+
+    bool rest = true;
+    switch (type)
+    {
+        case OrderType::Limit:
+            break;
+        case OrderType::Market:
+            price = Side::kMarketLimit;
+            rest = false;
+            break;
+        case OrderType::ImmediateOrCancel:
+        case OrderType::FillOrKill:
+            rest = false;
+            break;
+        case OrderType::PostOnly:
+            if (!opposite.Empty() &&
+                Side::Crosses(price, opposite.BestPrice()))
+            {
+                throw OrderRejected(
+                    RejectReason::PostOnlyWouldTrade,
+                    "ERROR: Post-only order would take liquidity.");
+            }
+            break;
+        default:
+            throw OrderRejected(RejectReason::UnknownType,
+                                "ERROR: Unknown order type.");
+    }
+    if (rest && !Side::Own(books).CanHold(price))
+    {
+        throw OrderRejected(RejectReason::PriceOutOfRange,
+                            "ERROR: Price outside of book range.");
+    }
+    if (m_riskChecks)
+    {
+        // Traders may have been interned without going through
+        // InternTrader, e.g. by a restore.
+        m_risk.Resize(m_traders.Size());
+        m_risk.Check(trader, Side::kSide == 'B', quantity,
+                     rest ? RiskLedger::Notional(price, quantity) : 0);
+    }
+
+    const OrderId orderId = ++m_lastOrderId;
+    if (type == OrderType::FillOrKill &&
+        !CanFill<Side>(opposite, trader, quantity, price))
+    {
+        return orderId;
+    }
+    Match<Side>(books, trader, orderId, quantity, price, rest);
+    return orderId;
+}
+
+Trading::TradeEngine::ordersMap Trading::TradeEngine::GetBuyOrders() const
+{
+    std::shared_lock lock(m_mutex);
+    ordersMap levels;
+    WithBooks([&](const auto& books)
+              { books.buyOrders.Export(levels, m_traders); });
+    return levels;
+}
+
+bool Trading::TradeEngine::IsResting(const OrderId orderId) const
+{
+    std::shared_lock lock(m_mutex);
+    return WithBooks([orderId](const auto& books)
+                     { return books.index.Contains(orderId); });
+}
+
+Trading::TradeEngine::ordersMap Trading::TradeEngine::GetSellOrders() const
+{
+    std::shared_lock lock(m_mutex);
+    ordersMap levels;
+    WithBooks([&](const auto& books)
+              { books.sellOrders.Export(levels, m_traders); });
+    return levels;
+}
+
+std::vector<std::string> Trading::TradeEngine::GetTrades() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_trades;
+}
+
+void Trading::TradeEngine::SetSnapshotDepth(const std::size_t depth)
+{
+    std::lock_guard lock(m_mutex);
+    m_snapshotDepth = std::min(depth, kMaxSnapshotDepth);
+}
+
+Trading::TopOfBook Trading::TradeEngine::GetTopOfBook() const noexcept
+{
+    return m_topOfBook.Load();
+}
+
+Trading::BookSnapshot Trading::TradeEngine::GetBookSnapshot() const noexcept
+{
+    return m_bookSnapshot.Load();
+}
+
+std::uint64_t Trading::TradeEngine::GetRejectedLines() const noexcept
+{
+    std::shared_lock lock(m_mutex);
+    return m_rejectedLines;
+}
+
+void Trading::TradeEngine::Preallocate(const std::size_t orders,
+                                       const std::size_t levels)
+{
+    const auto lock = LockWriter();
+    WithBooks(
+        [&](auto& books)
+        {
+            books.buyOrders.Preallocate(orders, levels);
+            books.sellOrders.Preallocate(orders, levels);
+            books.index.Reserve(orders * 2);
+        });
+    // A single order fills at most every resting order of the other side.
+    m_fills.reserve(orders);
+    m_reports.reserve(orders * 2);
+    m_tradeFormatter.Reserve(orders);
+}
+
+void Trading::TradeEngine::OpenJournal(const std::string& path,
+                                       const JournalOptions options)
+{
+    const auto lock = LockWriter();
+    m_journal = std::make_unique<Journal>(path, options);
+    JournalSettings();
+}
+
+void Trading::TradeEngine::FlushJournal()
+{
+    const auto lock = LockWriter();
+    if (m_journal)
+    {
+        m_journal->Flush();
+    }
+}
+
+void Trading::TradeEngine::OpenMarketData(const std::string& name,
+                                          const MarketDataOptions options)
+{
+    const auto lock = LockWriter();
+    m_marketData = std::make_unique<MarketDataPublisher>(name, options);
+    m_depthBids.reserve(std::min<std::size_t>(options.snapshotLevels, 4096));
+    m_depthAsks.reserve(std::min<std::size_t>(options.snapshotLevels, 4096));
+    WithBooks([this](const auto& books) { PublishDepthSnapshot(books); });
+}
+
+void Trading::TradeEngine::WriteSnapshot(const std::string& path)
+{
+    const auto lock = LockWriter();
+    // The settings follow the part of the journal the snapshot covers, so
+    // that restoring it replays them first.
+    const std::uint64_t journalOffset = m_journal ? m_journal->Size() : 0;
+    if (m_journal)
+    {
+        JournalSettings();
+        m_journal->Flush();
+    }
+
+    const std::string partial = path + ".tmp";
+    std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write snapshot " + partial);
+    }
+
+    std::string data;
+    data.reserve(kSnapshotBlock + sizeof(SnapshotOrder));
+    const auto writeBlock = [&out, &data]()
+    {
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        data.clear();
+    };
+
+    data.append(kSnapshotMagic, sizeof(kSnapshotMagic));
+    AppendRaw(data, kSnapshotVersion);
+    AppendRaw(data, m_lastOrderId);
+    AppendRaw(data, m_sequence);
+    AppendRaw(data, m_fillSequence);
+    AppendRaw(data, journalOffset);
+    AppendRaw(data, static_cast<std::uint32_t>(m_traders.Size()));
+    for (TraderId trader = 0; trader < m_traders.Size(); ++trader)
+    {
+        const std::string_view name = m_traders.Name(trader);
+        AppendRaw(data, static_cast<std::uint32_t>(name.size()));
+        data.append(name);
+        if (data.size() >= kSnapshotBlock)
+        {
+            writeBlock();
+        }
+    }
+
+    WithBooks(
+        [&](const auto& books)
+        {
+            std::uint64_t buyCount = 0;
+            books.buyOrders.VisitOrders([&buyCount](std::uint64_t,
+                                                    const auto&)
+                                        { ++buyCount; });
+            AppendRaw(data, buyCount);
+            AppendRaw(data, std::uint64_t{books.index.Size() - buyCount});
+
+            const auto writeOrder =
+                [&](const std::uint64_t price, const auto& order)
+            {
+                AppendRaw(data, SnapshotOrder{order.orderId, price,
+                                              order.quantity, order.trader,
+                                              0});
+                if (data.size() >= kSnapshotBlock)
+                {
+                    writeBlock();
+                }
+            };
+            books.buyOrders.VisitOrders(writeOrder);
+            books.sellOrders.VisitOrders(writeOrder);
+        });
+    writeBlock();
+
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error("Cannot write snapshot " + partial);
+    }
+    std::filesystem::rename(partial, path);
+}
+
+void Trading::TradeEngine::Restore(const std::string& snapshotPath,
+                                   const std::string& journalPath)
+{
+    const auto lock = LockWriter();
+    if (m_journal || m_lastOrderId != 0 || m_traders.Size() != 0)
+    {
+        throw std::runtime_error("Restore needs a fresh engine");
+    }
+
+    std::uint64_t journalOffset = 0;
+    if (!snapshotPath.empty())
+    {
+        const MappedFile snapshot(snapshotPath);
+        journalOffset = WithBooks(
+            [&](auto& books) { return LoadSnapshot(books, snapshot.Data()); });
+        if (m_riskChecks)
+        {
+            m_risk.Resize(m_traders.Size());
+            WithBooks([this](const auto& books) { CountOpenNotional(books); });
+        }
+    }
+
+    // Replayed trades were published before the restart.
+    TradeSink tradeSink = std::move(m_tradeSink);
+    FillSink fillSink = std::move(m_fillSink);
+    ReportSink reportSink = std::move(m_reportSink);
+    const bool retainTrades = m_retainTrades;
+    m_tradeSink = nullptr;
+    m_fillSink = nullptr;
+    m_reportSink = nullptr;
+    m_retainTrades = false;
+    const auto restoreSinks = [&]()
+    {
+        m_tradeSink = std::move(tradeSink);
+        m_fillSink = std::move(fillSink);
+        m_reportSink = std::move(reportSink);
+        m_retainTrades = retainTrades;
+    };
+
+    try
+    {
+        std::uint64_t journalSize = 0;
+        std::uint64_t validSize = journalOffset;
+        if (std::filesystem::exists(journalPath))
+        {
+            const MappedFile journal(journalPath);
+            const std::string_view data = journal.Data();
+            journalSize = data.size();
+            if (journalSize < journalOffset)
+            {
+                throw std::runtime_error("Journal is older than the snapshot");
+            }
+            validSize += ReadJournal(
+                data.substr(journalOffset),
+                [this](const JournalRecord& record, const std::string_view name)
+                { ReplayRecord(record, name); });
+        }
+        if (validSize < journalSize)
+        {
+            std::filesystem::resize_file(journalPath, validSize);
+        }
+    }
+    catch (...)
+    {
+        restoreSinks();
+        throw;
+    }
+    restoreSinks();
+    WithBooks([this](const auto& books) { PublishSnapshots(books); });
+}
+
+template <typename Book>
+std::uint64_t Trading::TradeEngine::LoadSnapshot(Books<Book>& books,
+                                                 const std::string_view data)
+{
+    SnapshotReader reader(data);
+    if (reader.Take(sizeof(kSnapshotMagic)) !=
+        std::string_view(kSnapshotMagic, sizeof(kSnapshotMagic)))
+    {
+        throw std::runtime_error("Not a snapshot or unsupported version");
+    }
+    const auto version = reader.Read<std::uint32_t>();
+    if (version != kSnapshotVersion && version != kSnapshotVersionWithoutFills)
+    {
+        throw std::runtime_error("Not a snapshot or unsupported version");
+    }
+    m_lastOrderId = reader.Read<OrderId>();
+    m_sequence = reader.Read<std::uint64_t>();
+    if (version == kSnapshotVersion)
+    {
+        m_fillSequence = reader.Read<std::uint64_t>();
+    }
+    const auto journalOffset = reader.Read<std::uint64_t>();
+
+    const auto traders = reader.Read<std::uint32_t>();
+    for (std::uint32_t trader = 0; trader < traders; ++trader)
+    {
+        static_cast<void>(
+            m_traders.Intern(reader.Take(reader.Read<std::uint32_t>())));
+    }
+
+    const auto buyCount = reader.Read<std::uint64_t>();
+    const auto sellCount = reader.Read<std::uint64_t>();
+    books.index.Reserve(buyCount + sellCount);
+    const auto load = [&](Book& book, const char side,
+                          const std::uint64_t count)
+    {
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            const auto order = reader.Read<SnapshotOrder>();
+            if (order.trader >= traders || !book.CanHold(order.price))
+            {
+                throw std::runtime_error("Snapshot does not fit the book");
+            }
+            books.index.Insert(order.orderId,
+                               {book.Push(order.price, order.trader,
+                                          order.quantity, order.orderId),
+                                side});
+        }
+    };
+    load(books.buyOrders, 'B', buyCount);
+    load(books.sellOrders, 'S', sellCount);
+    return journalOffset;
+}
+
+void Trading::TradeEngine::ReplayRecord(const JournalRecord& record,
+                                        const std::string_view name)
+{
+    switch (record.kind)
+    {
+        case JournalRecordKind::Trader:
+            if (m_traders.Intern(name) != record.trader)
+            {
+                throw std::runtime_error("Journal does not match snapshot");
+            }
+            break;
+        case JournalRecordKind::Order:
+            if (record.trader >= m_traders.Size() ||
+                Submit(record.trader, record.side, record.quantity,
+                       record.price, record.type)
+                        .orderId != record.orderId)
+            {
+                throw std::runtime_error("Journal does not match snapshot");
+            }
+            break;
+        case JournalRecordKind::Cancel:
+            CancelOrder(record.orderId);
+            break;
+        case JournalRecordKind::Amend:
+            WithBooks([&](auto& books)
+                      { Amend(books, record.orderId, record.quantity,
+                              record.price); });
+            PublishFills();
+            break;
+        case JournalRecordKind::SelfTrade:
+            if (record.quantity >
+                static_cast<std::uint64_t>(SelfTradePrevention::DecrementBoth))
+            {
+                throw std::runtime_error("Unknown journal record");
+            }
+            m_selfTrade = static_cast<SelfTradePrevention>(record.quantity);
+            break;
+        case JournalRecordKind::RiskLimits:
+        {
+            const RiskLimits limits{record.quantity, record.price,
+                                    record.orderId};
+            EnableRiskChecks();
+            if (record.side == 0)
+            {
+                m_risk.SetDefaults(limits);
+            }
+            else if (record.trader < m_traders.Size())
+            {
+                m_risk.SetLimits(record.trader, limits);
+            }
+            else
+            {
+                throw std::runtime_error("Journal does not match snapshot");
+            }
+            break;
+        }
+        case JournalRecordKind::Position:
+            if (!m_riskChecks || record.trader >= m_traders.Size())
+            {
+                throw std::runtime_error("Journal does not match snapshot");
+            }
+            m_risk.Resize(m_traders.Size());
+            m_risk.SetPosition(record.trader,
+                               static_cast<std::int64_t>(record.quantity));
+            break;
+        default:
+            throw std::runtime_error("Unknown journal record");
+    }
+}
+
+Trading::ThreadStats* Trading::TradeEngine::LocalStats()
+{
+    if constexpr (!kStatsEnabled)
+    {
+        return nullptr;
+    }
+
+    // The engine last used on this thread, then every engine it used, so
+    // that a thread serving several books, like a ShardedEngine shard, only
+    // takes the lock the first time it uses each. Ids are never reused, so
+    // entries of destroyed engines are never found again; they are dropped
+    // wholesale once there are too many.
+    thread_local std::uint64_t cachedEngine = 0;
+    thread_local ThreadStats* cachedStats = nullptr;
+    thread_local std::unordered_map<std::uint64_t, ThreadStats*> engines;
+    if (cachedEngine == m_statsId)
+    {
+        return cachedStats;
+    }
+
+    const auto cached = engines.find(m_statsId);
+    if (cached != engines.end())
+    {
+        cachedStats = cached->second;
+    }
+    else
+    {
+        const std::thread::id self = std::this_thread::get_id();
+        {
+            std::lock_guard lock(m_statsMutex);
+            auto found =
+                std::find_if(m_threadStats.begin(), m_threadStats.end(),
+                             [self](const auto& stats)
+                             { return stats->owner == self; });
+            if (found == m_threadStats.end())
+            {
+                m_threadStats.push_back(std::make_unique<ThreadStats>(self));
+                found = std::prev(m_threadStats.end());
+            }
+            cachedStats = found->get();
+        }
+        if (engines.size() >= kMaxCachedEngines)
+        {
+            engines.clear();
+        }
+        engines.emplace(m_statsId, cachedStats);
+    }
+    cachedEngine = m_statsId;
+    return cachedStats;
+}
+
+void Trading::TradeEngine::CountReject()
+{
+    if (ThreadStats* const stats = LocalStats())
+    {
+        ThreadStats::Add(stats->rejects, 1);
+    }
+}
+
+void Trading::TradeEngine::CountFills(ThreadStats& stats) const noexcept
+{
+    // Fills are recorded in matching order, so a new level starts wherever
+    // the price changes.
+    std::uint64_t levels = 0;
+    for (std::size_t i = 0; i < m_fills.size(); ++i)
+    {
+        if (i == 0 || m_fills[i].price != m_fills[i - 1].price)
+        {
+            ++levels;
+        }
+    }
+    ThreadStats::Add(stats.fills, m_fills.size());
+    ThreadStats::Add(stats.levelsSwept, levels);
+}
+
+Trading::EngineStats Trading::TradeEngine::GetStats() const
+{
+    EngineStats stats{};
+    if constexpr (kStatsEnabled)
+    {
+        const double scale = TicksPerNanosecond();
+        std::lock_guard lock(m_statsMutex);
+        for (std::size_t stage = 0; stage < kStageCount; ++stage)
+        {
+            LatencyHistogram::Counts counts{};
+            for (const auto& thread : m_threadStats)
+            {
+                thread->stages[stage].AddTo(counts);
+            }
+            stats.stages[stage] = LatencyHistogram::Summarize(counts, scale);
+        }
+        for (const auto& thread : m_threadStats)
+        {
+            stats.orders += thread->orders.load(std::memory_order_relaxed);
+            stats.fills += thread->fills.load(std::memory_order_relaxed);
+            stats.levelsSwept +=
+                thread->levelsSwept.load(std::memory_order_relaxed);
+            stats.rejects += thread->rejects.load(std::memory_order_relaxed);
+        }
+        stats.restingOrders = m_restingOrders.load(std::memory_order_relaxed);
+        stats.bidLevels = m_bidLevels.load(std::memory_order_relaxed);
+        stats.askLevels = m_askLevels.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void Trading::TradeEngine::DumpStatsEvery(
+    const std::chrono::milliseconds period, const std::string& path)
+{
+    m_statsDumper.reset();
+    if (period.count() == 0)
+    {
+        return;
+    }
+
+    std::shared_ptr<std::ofstream> file;
+    if (!path.empty())
+    {
+        file = std::make_shared<std::ofstream>(path, std::ios::app);
+        if (!*file)
+        {
+            throw std::runtime_error("Cannot open stats file " + path);
+        }
+    }
+    m_statsDumper = std::make_unique<StatsDumper>(
+        period,
+        [this, file]()
+        {
+            const EngineStats stats = GetStats();
+            std::ostream& out = file ? *file : std::cerr;
+            PrintStats(out, stats);
+            out.flush();
+        });
+}
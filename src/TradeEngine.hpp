@@ -1,14 +1,38 @@
 #ifndef TRADE_ENGINE_H
 #define TRADE_ENGINE_H
 
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "BinaryProtocol.hpp"
+#include "BookSnapshot.hpp"
+#include "EngineStats.hpp"
+#include "Fill.hpp"
+#include "Journal.hpp"
+#include "MarketData.hpp"
+#include "OrderIndex.hpp"
+#include "OrderParser.hpp"
+#include "Pipeline.hpp"
+#include "PriceLadder.hpp"
+#include "RiskLedger.hpp"
+#include "Seqlock.hpp"
+#include "Span.hpp"
+#include "TradeFormatter.hpp"
+#include "TradeOrder.hpp"
+#include "TraderRegistry.hpp"
+#include "TreeBook.hpp"
+
 namespace Trading
 {
 class TradeEngine;
@@ -17,7 +41,9 @@ class TradeEngine;
 class Trading::TradeEngine final
 {
    public:
-    explicit TradeEngine() = default;
+    explicit TradeEngine(
+        BookType bookType = BookType::Tree,
+        ConcurrencyMode concurrency = ConcurrencyMode::Locked);
 
     TradeEngine(const TradeEngine&) = delete;
     TradeEngine(TradeEngine&&) = delete;
@@ -27,45 +53,345 @@ class Trading::TradeEngine final
     ~TradeEngine() = default;
 
    public:
-    struct TradeOrder
-    {
-        std::string identifier;
-        char side;
-        std::uint64_t quantity;
-        std::uint64_t price;
-    };
-
-    using ordersMap = std::map<const std::uint64_t, std::list<TradeOrder>>;
+    using TradeOrder = Trading::TradeOrder;
+    using ordersMap = Trading::ordersMap;
+    using TradeSink = std::function<void(std::string_view)>;
+    using FillSink = std::function<void(const Fill* fills, std::size_t count)>;
+    using ReportSink =
+        std::function<void(const ExecutionReport* reports, std::size_t count)>;
 
    public:
-    void Start();
+    // Matches the order lines of standard input and streams the trades of
+    // each to the trade sink, or to standard output when none is installed,
+    // in input order. Lines that cannot be parsed or are rejected by the
+    // book are skipped and counted. Reading and parsing, matching, and
+    // output run on three threads joined by bounded SPSC queues; matching
+    // stays on the calling thread, while the trade sink is called from the
+    // output thread. Returns once all input has been written out.
+    void Start(const PipelineOptions& options = {});
+
+    // Called with the fills of every order and amend that trades, in
+    // matching order, before any of the views below are built from them.
+    // Nothing is formatted for it; this is the engine's primary output.
+    void SetFillSink(FillSink sink);
+
+    // Called with the trades of every order as soon as it is matched,
+    // formatted by a TradeFormatter.
+    void SetTradeSink(TradeSink sink);
+
+    // When disabled, GetTrades stays empty and trades only reach the sink.
+    // Trades are not formatted at all without a trade sink or history.
+    void SetTradeHistory(bool retain) noexcept;
+
+    // Called with the execution reports of every order that trades, two
+    // per fill, the incoming order's first. The reports can be written out
+    // as they are.
+    void SetReportSink(ReportSink sink);
 
     [[nodiscard]] TradeEngine::TradeOrder ParseInput(const std::string& input);
 
-    void ProcessOrder(const TradeOrder& order);
+    // Returns the id assigned to the order, which stays valid for Cancel
+    // and Amend for as long as any of it rests in the book. Market,
+    // immediate-or-cancel and fill-or-kill orders get an id but never rest.
+    // Throws std::invalid_argument for a rejected order, including a
+    // post-only order that would trade.
+    OrderId ProcessOrder(const TradeOrder& order);
+
+    OrderId ProcessOrder(const OrderView& order);
+
+    // Matches the orders in sequence under a single lock, exactly as
+    // ProcessOrder would one by one, and writes the outcome of orders[i]
+    // to results[i]. A rejected order is marked in its result, with the
+    // reason, instead of throwing and the rest of the batch still runs.
+    // results must hold at least orders.size() entries. Returns the number
+    // of accepted orders. Throws std::runtime_error if the journal fails.
+    std::size_t ProcessOrders(Span<const TradeOrder> orders,
+                              Span<OrderResult> results);
+
+    std::size_t ProcessOrders(Span<const OrderView> orders,
+                              Span<OrderResult> results);
+
+    // Returns the id binary messages use for the trader, assigning one on
+    // first use.
+    [[nodiscard]] TraderId RegisterTrader(std::string_view name);
+
+    // Throws std::invalid_argument for an unregistered trader or a rejected
+    // order, like ProcessOrder.
+    OrderId ProcessMessage(const OrderMessage& message);
+
+    // Processes the whole messages at the start of data, skipping and
+    // counting rejected ones. Returns the number of bytes consumed.
+    std::size_t ProcessMessages(const char* data, std::size_t size);
+
+    // Removes a resting order. Returns false if it is no longer resting.
+    bool Cancel(OrderId orderId);
+
+    // Sets the open quantity and price of a resting order. Lowering the
+    // quantity at the same price keeps the order's time priority; any other
+    // change re-enters it at the back of the queue, where it may trade.
+    // A quantity of zero cancels. Returns false if it is no longer resting.
+    bool Amend(OrderId orderId, std::uint64_t quantity, std::uint64_t price);
+
+    // Decides what happens when an order would trade with a resting order
+    // of its own trader. Off (None) by default.
+    void SetSelfTradePrevention(SelfTradePrevention mode);
 
-    [[nodiscard]] const ordersMap& GetBuyOrders() const noexcept;
+    // Turns on pre-trade risk checks, with limits for every trader that has
+    // none of its own. From then on an order that would break a limit of
+    // its trader is rejected like an invalid order. Positions count from
+    // the first call, open notional covers the orders already resting.
+    // Market orders are checked on quantity and position only.
+    void SetRiskLimits(const RiskLimits& limits);
 
-    [[nodiscard]] const ordersMap& GetSellOrders() const noexcept;
+    void SetRiskLimits(std::string_view trader, const RiskLimits& limits);
 
-    [[nodiscard]] const std::vector<std::string>& GetTrades() const noexcept;
+    // Net quantity the trader bought since risk checks were turned on.
+    [[nodiscard]] std::int64_t GetPosition(std::string_view trader) const;
+
+    // Preallocates room for this many resting orders and price levels per
+    // side. Once every trader has been seen and the trade buffers have
+    // grown to the largest sweep, orders within that capacity are matched
+    // without calling the global allocator, provided trade history is off.
+    void Preallocate(std::size_t orders, std::size_t levels);
+
+    // From now on appends every trader, accepted order, cancel and amend to
+    // the journal at path before the resulting trades are published. When
+    // appending fails, the order or amend has still taken effect: its
+    // trades are published before the std::runtime_error propagates.
+    void OpenJournal(const std::string& path, JournalOptions options = {});
+
+    // Writes out and syncs every journal record buffered so far. Callers
+    // of ProcessOrder call it before passing on fills that must survive a
+    // crash; the batch calls and Start() do so themselves.
+    void FlushJournal();
+
+    // From now on publishes every change to a price level and to the best
+    // levels, plus periodic depth snapshots, to the shared-memory feed name
+    // for MarketDataReaders in any local process. Throws
+    // std::runtime_error if the feed cannot be created.
+    void OpenMarketData(const std::string& name,
+                        MarketDataOptions options = {});
+
+    // Writes every resting order to path, replacing the file only once the
+    // snapshot is complete, together with how much of the journal it
+    // already covers. The journal is flushed first.
+    void WriteSnapshot(const std::string& path);
+
+    // Rebuilds a fresh engine from the snapshot, unless snapshotPath is
+    // empty, and the journal records written after it. Trades of replayed
+    // orders are not published again. A record torn by a crash is cut off
+    // the end of the journal. Throws std::runtime_error if the files cannot
+    // be read or do not belong together.
+    void Restore(const std::string& snapshotPath,
+                 const std::string& journalPath);
+
+    // Copies taken under the engine lock. A SingleWriter engine may only be
+    // queried like this from its writer thread.
+    [[nodiscard]] ordersMap GetBuyOrders() const;
+
+    [[nodiscard]] ordersMap GetSellOrders() const;
+
+    [[nodiscard]] std::vector<std::string> GetTrades() const;
+
+    // Whether any of the order still rests in the book.
+    [[nodiscard]] bool IsResting(OrderId orderId) const;
+
+    // Publishes the top of book and up to depth levels per side after every
+    // order, for readers on any thread. 0, the default, stops publishing.
+    void SetSnapshotDepth(std::size_t depth);
+
+    // Lock-free; never blocks the matching thread.
+    [[nodiscard]] TopOfBook GetTopOfBook() const noexcept;
+
+    [[nodiscard]] BookSnapshot GetBookSnapshot() const noexcept;
+
+    // Latency percentiles per stage and order flow counters, merged over
+    // every thread that used the engine. Safe to call from any thread; all
+    // zero when the engine is built without stats.
+    [[nodiscard]] EngineStats GetStats() const;
+
+    // Prints GetStats() every period to the file at path, or to standard
+    // error when path is empty. A zero period stops printing.
+    void DumpStatsEvery(std::chrono::milliseconds period,
+                        const std::string& path = {});
+
+    // Number of input lines Start() and messages ProcessMessages skipped as
+    // invalid.
+    [[nodiscard]] std::uint64_t GetRejectedLines() const noexcept;
 
    private:
-    void HandleSell(const std::string& trader, std::uint64_t quantity,
-                    const std::uint64_t price) noexcept;
+    // Both sides of one book layout and the index of its resting orders.
+    template <typename Book>
+    struct Books
+    {
+        struct Locator
+        {
+            typename Book::Handle handle;
+            char side;
+        };
 
-    void HandleBuy(const std::string& trader, std::uint64_t quantity,
-                   const std::uint64_t price) noexcept;
+        Book buyOrders{'B'};
+        Book sellOrders{'S'};
+        OrderIndex<Locator> index;
+    };
+
+    // Calls fn with the books of the configured layout.
+    template <typename Fn>
+    decltype(auto) WithBooks(Fn&& fn);
+
+    template <typename Fn>
+    decltype(auto) WithBooks(Fn&& fn) const;
+
+    // The matching kernel for Side: trades the order against the other
+    // side and rests what is left if rest is set. Recording fills and
+    // resting the order may allocate, so it can throw std::bad_alloc.
+    template <typename Side, typename Book>
+    void Match(Books<Book>& books, TraderId trader, OrderId orderId,
+               std::uint64_t quantity, std::uint64_t price, bool rest);
+
+    template <typename Book>
+    void PublishSnapshots(const Books<Book>& books) noexcept;
+
+    // Notes a level about to change, for the market data feed.
+    template <typename Book>
+    void MarkLevel(const Books<Book>& books, char side, std::uint64_t price);
+
+    // Publishes the marked levels and those the last order traded against.
+    template <typename Book>
+    void PublishMarketData(const Books<Book>& books) noexcept;
+
+    template <typename Book>
+    void PublishDepthSnapshot(const Books<Book>& books) noexcept;
+
+    // Whether an order of Side priced at price could trade all of quantity
+    // against book. With self-trade prevention on, reaching an order of
+    // the same trader first means it could not.
+    template <typename Side, typename Book>
+    [[nodiscard]] bool CanFill(const Book& book, TraderId trader,
+                               std::uint64_t quantity,
+                               std::uint64_t price) const noexcept;
+
+    // Books the open notional of every resting order with the risk ledger.
+    template <typename Book>
+    void CountOpenNotional(const Books<Book>& books);
+
+    // Turns risk checks on unless they are already.
+    void EnableRiskChecks();
+
+    // Appends the self-trade prevention mode, every risk limit and every
+    // position to the journal, so that a replay from here on matches like
+    // this engine.
+    void JournalSettings();
+
+    // own is false for the defaults.
+    void JournalRiskLimits(TraderId trader, bool own,
+                           const RiskLimits& limits);
+
+    // Resolves side once, so that everything below is compiled per side.
+    template <typename Book>
+    OrderId Dispatch(Books<Book>& books, TraderId trader, char side,
+                     std::uint64_t quantity, std::uint64_t price,
+                     OrderType type);
+
+    template <typename Side, typename Book>
+    OrderId Place(Books<Book>& books, TraderId trader, std::uint64_t quantity,
+                  std::uint64_t price, OrderType type);
+
+    // Interns name and journals it if it is new.
+    TraderId InternTrader(std::string_view name);
+
+    // Matches an order for a known trader; the caller holds the lock.
+    OrderResult Submit(TraderId trader, char side, std::uint64_t quantity,
+                       std::uint64_t price, OrderType type);
+
+    template <typename Order>
+    std::size_t SubmitBatch(Span<const Order> orders,
+                            Span<OrderResult> results);
+
+    bool CancelOrder(OrderId orderId);
+
+    template <typename Book>
+    bool Amend(Books<Book>& books, OrderId orderId, std::uint64_t quantity,
+               std::uint64_t price);
+
+    // Takes the engine lock unless the engine is single-writer.
+    [[nodiscard]] std::unique_lock<std::shared_mutex> LockWriter();
+
+    // Returns the journal offset the snapshot covers.
+    template <typename Book>
+    std::uint64_t LoadSnapshot(Books<Book>& books, std::string_view data);
+
+    void ReplayRecord(const JournalRecord& record, std::string_view name);
+
+    // The calling thread's stats slot, or null when stats are compiled out.
+    [[nodiscard]] ThreadStats* LocalStats();
+
+    void CountReject();
+
+    // Counts the fills of the order just matched and the levels they swept.
+    void CountFills(ThreadStats& stats) const noexcept;
+
+    // Hands the fills of the last order to every sink, then clears them.
+    void PublishFills();
+
+    void EmitReports();
 
     void CollectTrades() noexcept;
 
    private:
     mutable std::shared_mutex m_mutex;
 
-    ordersMap m_buyOrders;
-    ordersMap m_sellOrders;
+    const BookType m_bookType;
+    const ConcurrencyMode m_concurrency;
+    TraderRegistry m_traders;
+    Books<TreeBook> m_tree;
+    Books<PriceLadder> m_ladder;
+    OrderId m_lastOrderId = 0;
     std::vector<std::string> m_trades;
-    std::map<std::pair<std::string, char>, std::map<int, int>> m_tradeInfo;
+    FillSink m_fillSink;
+    TradeSink m_tradeSink;
+    ReportSink m_reportSink;
+    std::unique_ptr<Journal> m_journal;
+    bool m_retainTrades = true;
+    SelfTradePrevention m_selfTrade = SelfTradePrevention::None;
+    bool m_riskChecks = false;
+    RiskLedger m_risk;
+    std::uint64_t m_rejectedLines = 0;
+
+    std::uint64_t m_sequence = 0;
+    std::uint64_t m_fillSequence = 0;
+    std::size_t m_snapshotDepth = 0;
+    Seqlock<TopOfBook> m_topOfBook;
+    Seqlock<BookSnapshot> m_bookSnapshot;
+
+    // A level as it was before the current operation changed it.
+    struct LevelMark
+    {
+        char side;
+        std::uint64_t price;
+        bool existed;
+    };
+
+    std::unique_ptr<MarketDataPublisher> m_marketData;
+    std::vector<LevelMark> m_levelMarks;
+    std::vector<DepthLevel> m_depthBids;
+    std::vector<DepthLevel> m_depthAsks;
+
+    // Per-order scratch buffers, cleared but never shrunk between orders.
+    std::vector<Fill> m_fills;
+    std::vector<ExecutionReport> m_reports;
+    TradeFormatter m_tradeFormatter{m_traders};
+
+    // Stats slots of every thread that used the engine, looked up through
+    // a per-thread map keyed by m_statsId.
+    const std::uint64_t m_statsId;
+    mutable std::mutex m_statsMutex;
+    std::vector<std::unique_ptr<ThreadStats>> m_threadStats;
+    std::atomic<std::uint64_t> m_restingOrders{0};
+    std::atomic<std::uint64_t> m_bidLevels{0};
+    std::atomic<std::uint64_t> m_askLevels{0};
+    // Declared last so that it stops before anything it reads goes away.
+    std::unique_ptr<StatsDumper> m_statsDumper;
 };
 
 #endif
@@ -0,0 +1,143 @@
+#include "TradeFormatter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+
+namespace
+{
+std::size_t CountDigits(std::uint64_t value) noexcept
+{
+    std::size_t digits = 1;
+    for (; value >= 10; value /= 10)
+    {
+        ++digits;
+    }
+    return digits;
+}
+
+// Compares the decimal spellings of two numbers character by character.
+// When one spelling is a prefix of the other, the shorter one sorts first
+// unless prefixSortsLast is set.
+bool DecimalLess(const std::uint64_t lhs, const std::uint64_t rhs,
+                 const bool prefixSortsLast) noexcept
+{
+    const std::size_t lhsDigits = CountDigits(lhs);
+    const std::size_t rhsDigits = CountDigits(rhs);
+    if (lhsDigits == rhsDigits)
+    {
+        return lhs < rhs;
+    }
+
+    char lhsText[20];
+    char rhsText[20];
+    std::to_chars(lhsText, lhsText + sizeof(lhsText), lhs);
+    std::to_chars(rhsText, rhsText + sizeof(rhsText), rhs);
+    const int order =
+        std::memcmp(lhsText, rhsText, std::min(lhsDigits, rhsDigits));
+    if (order != 0)
+    {
+        return order < 0;
+    }
+    return prefixSortsLast ? lhsDigits > rhsDigits : lhsDigits < rhsDigits;
+}
+
+void AppendDecimal(std::string& text, const std::uint64_t value)
+{
+    char digits[20];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    text.append(digits, result.ptr);
+}
+}  // namespace
+
+std::string_view Trading::TradeFormatter::Format(const Span<const Fill> fills)
+{
+    m_entries.clear();
+    for (const Fill& fill : fills)
+    {
+        const bool buy = fill.aggressorSide == 'B';
+        m_entries.push_back({fill.aggressorTrader, buy ? '+' : '-',
+                             fill.price, fill.quantity});
+        m_entries.push_back({fill.restingTrader, buy ? '-' : '+', fill.price,
+                             fill.quantity});
+    }
+    m_text.clear();
+    if (m_entries.empty())
+    {
+        return m_text;
+    }
+
+    // Group fills by trader name, side and price, then aggregate each
+    // group into a single entry.
+    std::sort(m_entries.begin(), m_entries.end(),
+              [this](const Entry& lhs, const Entry& rhs)
+              {
+                  if (lhs.trader != rhs.trader)
+                  {
+                      const auto lhsKey = m_traders.SortKey(lhs.trader);
+                      const auto rhsKey = m_traders.SortKey(rhs.trader);
+                      if (lhsKey != rhsKey)
+                      {
+                          return lhsKey < rhsKey;
+                      }
+                      return m_traders.Name(lhs.trader) <
+                             m_traders.Name(rhs.trader);
+                  }
+                  return std::tie(lhs.sign, lhs.price) <
+                         std::tie(rhs.sign, rhs.price);
+              });
+    auto last = m_entries.begin();
+    for (auto entry = std::next(last); entry != m_entries.end(); ++entry)
+    {
+        if (entry->trader == last->trader && entry->sign == last->sign &&
+            entry->price == last->price)
+        {
+            last->quantity += entry->quantity;
+        }
+        else
+        {
+            *++last = *entry;
+        }
+    }
+    m_entries.erase(std::next(last), m_entries.end());
+
+    // Within each trader and side, order entries as their
+    // "<quantity>@<price>" spellings sort. '@' sorts after every digit.
+    for (auto run = m_entries.begin(); run != m_entries.end();)
+    {
+        const auto runEnd = std::find_if(
+            run, m_entries.end(), [run](const Entry& entry)
+            { return entry.trader != run->trader || entry.sign != run->sign; });
+        std::sort(run, runEnd,
+                  [](const Entry& lhs, const Entry& rhs)
+                  {
+                      if (lhs.quantity != rhs.quantity)
+                      {
+                          return DecimalLess(lhs.quantity, rhs.quantity, true);
+                      }
+                      return DecimalLess(lhs.price, rhs.price, false);
+                  });
+        run = runEnd;
+    }
+
+    for (const Entry& entry : m_entries)
+    {
+        if (!m_text.empty())
+        {
+            m_text.push_back(' ');
+        }
+        m_text.append(m_traders.Name(entry.trader));
+        m_text.push_back(entry.sign);
+        AppendDecimal(m_text, entry.quantity);
+        m_text.push_back('@');
+        AppendDecimal(m_text, entry.price);
+    }
+    return m_text;
+}
+
+void Trading::TradeFormatter::Reserve(const std::size_t fills)
+{
+    m_entries.reserve(fills * 2);
+}
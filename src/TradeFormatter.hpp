@@ -0,0 +1,55 @@
+#ifndef TRADE_FORMATTER_H
+#define TRADE_FORMATTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Fill.hpp"
+#include "Span.hpp"
+#include "TraderRegistry.hpp"
+
+namespace Trading
+{
+class TradeFormatter;
+}
+
+// Turns the fills of one order into the engine's trade line: both sides of
+// every fill, summed per trader, side and price, as
+// "<trader><+|-><quantity>@<price>" entries separated by spaces. Entries
+// are sorted by trader name, buys before sells, then as their quantity and
+// price spellings sort. Buffers are reused, so formatting stops allocating
+// once they have grown to the largest sweep.
+class Trading::TradeFormatter final
+{
+   public:
+    // Names are looked up in traders, which must outlive the formatter.
+    explicit TradeFormatter(const TraderRegistry& traders) noexcept
+        : m_traders(traders)
+    {
+    }
+
+    // The returned view stays valid until the next call.
+    [[nodiscard]] std::string_view Format(Span<const Fill> fills);
+
+    // Makes room for an order with this many fills.
+    void Reserve(std::size_t fills);
+
+   private:
+    // One side of a fill: the trader, '+' for buying or '-' for selling.
+    struct Entry
+    {
+        TraderId trader;
+        char sign;
+        std::uint64_t price;
+        std::uint64_t quantity;
+    };
+
+    const TraderRegistry& m_traders;
+    std::vector<Entry> m_entries;
+    std::string m_text;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef TRADE_ORDER_H
+#define TRADE_ORDER_H
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace Trading
+{
+class OrderRejected;
+
+// What happens to an order beyond matching up to its price.
+enum class OrderType : std::uint8_t
+{
+    // Whatever does not trade on entry rests in the book.
+    Limit,
+    // Trades at any price; whatever does not trade is cancelled.
+    Market,
+    // Trades up to its price; whatever does not trade is cancelled.
+    ImmediateOrCancel,
+    // Trades its whole quantity up to its price on entry, or not at all.
+    FillOrKill,
+    // Rests in full; rejected if any of it would trade on entry.
+    PostOnly
+};
+
+struct TradeOrder
+{
+    std::string identifier;
+    char side;
+    std::uint64_t quantity;
+    // Ignored for market orders.
+    std::uint64_t price;
+    OrderType type = OrderType::Limit;
+};
+
+using ordersMap = std::map<const std::uint64_t, std::list<TradeOrder>>;
+
+// Dense id of an interned trader identifier, see TraderRegistry.
+using TraderId = std::uint32_t;
+
+// Engine-assigned id of an accepted order, starting at 1.
+using OrderId = std::uint64_t;
+
+// Why the engine refused an order, see OrderRejected.
+enum class RejectReason : std::uint8_t
+{
+    None,
+    UnknownTrader,
+    UnknownSide,
+    UnknownType,
+    PriceOutOfRange,
+    PostOnlyWouldTrade,
+    QuantityLimit,
+    PositionLimit,
+    NotionalLimit,
+    // Any other std::invalid_argument raised for the order.
+    Invalid
+};
+
+[[nodiscard]] const char* ToString(RejectReason reason) noexcept;
+
+// Outcome of one order of a batch, see TradeEngine::ProcessOrders.
+struct OrderResult
+{
+    // 0 for a rejected order.
+    OrderId orderId;
+    // Quantity the order traded on entry; the rest rests in the book.
+    std::uint64_t filledQuantity;
+    // Number of resting orders it traded against.
+    std::uint32_t fills;
+    bool rejected;
+    RejectReason reason;
+};
+
+enum class BookType
+{
+    Tree,
+    Ladder
+};
+
+// Locked engines may be shared between threads. SingleWriter engines must
+// only be driven by one thread and skip all locking on the order path;
+// other threads read them through the published snapshots.
+enum class ConcurrencyMode
+{
+    Locked,
+    SingleWriter
+};
+}  // namespace Trading
+
+// Thrown for an order the engine refuses. what() has the full message,
+// Reason() the code a batch reports it under.
+class Trading::OrderRejected final : public std::invalid_argument
+{
+   public:
+    OrderRejected(const RejectReason reason, const char* const message)
+        : std::invalid_argument(message), m_reason(reason)
+    {
+    }
+
+    [[nodiscard]] RejectReason Reason() const noexcept { return m_reason; }
+
+   private:
+    RejectReason m_reason;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "TraderRegistry.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+Trading::TraderId Trading::TraderRegistry::Intern(
+    const std::string_view name)
+{
+    const auto found = m_ids.find(name);
+    if (found != m_ids.end())
+    {
+        return found->second;
+    }
+
+    if (m_names.size() >= std::numeric_limits<TraderId>::max())
+    {
+        throw std::length_error("ERROR: Trader id space exhausted.");
+    }
+    const auto id = static_cast<TraderId>(m_names.size());
+    const std::string& stored = m_names.emplace_back(name);
+    m_ids.emplace(stored, id);
+
+    std::uint64_t key = 0;
+    for (std::size_t i = 0; i < sizeof(key); ++i)
+    {
+        const auto byte =
+            i < stored.size() ? static_cast<unsigned char>(stored[i]) : 0U;
+        key = (key << 8) | byte;
+    }
+    m_sortKeys.push_back(key);
+    return id;
+}
@@ -0,0 +1,57 @@
+#ifndef TRADER_REGISTRY_H
+#define TRADER_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "TradeOrder.hpp"
+
+namespace Trading
+{
+class TraderRegistry;
+}
+
+// Symbol table mapping trader identifiers to dense 32-bit ids, assigned in
+// order of first appearance. Books and trade aggregation only ever see ids;
+// names are looked up again when output is formatted.
+class Trading::TraderRegistry final
+{
+   public:
+    // Returns the id of name, assigning the next free one on first use.
+    [[nodiscard]] TraderId Intern(std::string_view name);
+
+    // The id of name, or null if it was never interned.
+    [[nodiscard]] const TraderId* Find(const std::string_view name) const
+    {
+        const auto found = m_ids.find(name);
+        return found == m_ids.end() ? nullptr : &found->second;
+    }
+
+    [[nodiscard]] std::string_view Name(const TraderId id) const noexcept
+    {
+        return m_names[id];
+    }
+
+    // The first eight bytes of the name read as a big-endian number. Keys
+    // order like the names do, except that equal keys need a full compare.
+    [[nodiscard]] std::uint64_t SortKey(const TraderId id) const noexcept
+    {
+        return m_sortKeys[id];
+    }
+
+    [[nodiscard]] std::size_t Size() const noexcept { return m_names.size(); }
+
+   private:
+    // A deque never moves its elements, so the views used as keys stay
+    // valid as names are added.
+    std::deque<std::string> m_names;
+    std::unordered_map<std::string_view, TraderId> m_ids;
+    std::vector<std::uint64_t> m_sortKeys;
+};
+
+#endif
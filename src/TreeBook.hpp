@@ -0,0 +1,268 @@
+#ifndef TREE_BOOK_H
+#define TREE_BOOK_H
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+
+#include "BookSnapshot.hpp"
+#include "NodeArena.hpp"
+#include "OrderPool.hpp"
+#include "TradeOrder.hpp"
+#include "TraderRegistry.hpp"
+
+namespace Trading
+{
+class TreeBook;
+}
+
+// One side of the order book kept as a std::map of FIFO queues. This is
+// the original engine layout and the reference for every other book type.
+// Map nodes come from the book's own NodeArena and orders from its
+// OrderPool, both recycled, so a warmed-up book does not call the global
+// allocator. Each level keeps its order count and the total quantity
+// resting on it.
+class Trading::TreeBook final
+{
+   public:
+    using Order = RestingOrder;
+
+   private:
+    struct Level
+    {
+        OrderQueue queue;
+        std::uint32_t orders = 0;
+        std::uint64_t quantity = 0;
+    };
+
+    using Levels =
+        std::map<std::uint64_t, Level, std::less<std::uint64_t>,
+                 PoolAllocator<std::pair<const std::uint64_t, Level>>>;
+
+   public:
+    // Stays valid until the order is removed or filled.
+    struct Handle
+    {
+        Levels::iterator level;
+        std::uint32_t slot;
+    };
+
+    explicit TreeBook(const char side)
+        : m_side(side), m_levels(Levels::allocator_type(m_arena))
+    {
+    }
+
+    TreeBook(const TreeBook&) = delete;
+    TreeBook& operator=(const TreeBook&) = delete;
+
+    [[nodiscard]] bool Empty() const noexcept { return m_levels.empty(); }
+
+    [[nodiscard]] std::size_t LevelCount() const noexcept
+    {
+        return m_levels.size();
+    }
+
+    [[nodiscard]] bool CanHold(const std::uint64_t) const noexcept
+    {
+        return true;
+    }
+
+    [[nodiscard]] std::uint64_t BestPrice() const noexcept
+    {
+        return m_side == 'B' ? m_levels.rbegin()->first
+                             : m_levels.begin()->first;
+    }
+
+    [[nodiscard]] const Order& Front() noexcept
+    {
+        return m_orders[BestLevel()->second.queue.head];
+    }
+
+    // Takes quantity, at most all of it, from the front order.
+    void Fill(const std::uint64_t quantity) noexcept
+    {
+        Level& level = BestLevel()->second;
+        m_orders[level.queue.head].quantity -= quantity;
+        level.quantity -= quantity;
+    }
+
+    void PopFront() noexcept
+    {
+        const auto level = BestLevel();
+        Remove({level, level->second.queue.head});
+    }
+
+    Handle Push(const std::uint64_t price, const TraderId trader,
+                const std::uint64_t quantity, const OrderId orderId)
+    {
+        const auto level = m_levels.try_emplace(price).first;
+        ++level->second.orders;
+        level->second.quantity += quantity;
+        return {level, m_orders.PushBack(level->second.queue, trader,
+                                         quantity, orderId)};
+    }
+
+    // Quantity and number of orders resting at price, zero if none.
+    [[nodiscard]] DepthLevel LevelAt(const std::uint64_t price) const noexcept
+    {
+        const auto level = m_levels.find(price);
+        if (level == m_levels.end())
+        {
+            return DepthLevel{price, 0, 0};
+        }
+        return DepthLevel{price, level->second.quantity,
+                          level->second.orders};
+    }
+
+    [[nodiscard]] const Order& Get(const Handle& handle) const noexcept
+    {
+        return m_orders[handle.slot];
+    }
+
+    // Lowers the order's quantity in place, keeping its time priority.
+    void Reduce(const Handle& handle, const std::uint64_t quantity) noexcept
+    {
+        Order& order = m_orders[handle.slot];
+        handle.level->second.quantity -= order.quantity - quantity;
+        order.quantity = quantity;
+    }
+
+    [[nodiscard]] static std::uint64_t PriceOf(const Handle& handle) noexcept
+    {
+        return handle.level->first;
+    }
+
+    void Remove(const Handle& handle) noexcept
+    {
+        Level& level = handle.level->second;
+        level.quantity -= m_orders[handle.slot].quantity;
+        m_orders.Remove(level.queue, handle.slot);
+        if (--level.orders == 0)
+        {
+            m_levels.erase(handle.level);
+        }
+    }
+
+    // Stocks the arena with nodes for this many price levels and the pool
+    // with room for this many resting orders, so that reaching them does
+    // not allocate.
+    void Preallocate(const std::size_t orders, const std::size_t levels)
+    {
+        Levels spareLevels{Levels::allocator_type(m_arena)};
+        for (std::size_t level = 0; level < levels; ++level)
+        {
+            spareLevels.try_emplace(level);
+        }
+        m_orders.Reserve(orders);
+    }
+
+    // Rebuilds the ordersMap representation of this side, used by the
+    // public depth getters.
+    void Export(ordersMap& levels, const TraderRegistry& traders) const
+    {
+        levels.clear();
+        for (const auto& [price, level] : m_levels)
+        {
+            auto& exported = levels[price];
+            for (std::uint32_t slot = level.queue.head; slot != OrderPool::kNil;
+                 slot = m_orders[slot].next)
+            {
+                const Order& order = m_orders[slot];
+                exported.push_back({std::string(traders.Name(order.trader)),
+                                    m_side, order.quantity, price});
+            }
+        }
+    }
+
+    // Calls fn(price, quantity, orders) for each level, best price first,
+    // until fn returns false.
+    template <typename Fn>
+    void VisitLevels(Fn&& fn) const
+    {
+        VisitLevelsBestFirst(
+            [&fn](const auto& level)
+            {
+                return fn(level.first, level.second.quantity,
+                          level.second.orders);
+            });
+    }
+
+    // Calls fn(price, order) for each resting order, best price first and
+    // in time priority within a level, until fn returns false.
+    template <typename Fn>
+    void VisitOrdersFromBest(Fn&& fn) const
+    {
+        VisitLevelsBestFirst(
+            [this, &fn](const auto& level)
+            {
+                for (std::uint32_t slot = level.second.queue.head;
+                     slot != OrderPool::kNil; slot = m_orders[slot].next)
+                {
+                    if (!fn(level.first, m_orders[slot]))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+    }
+
+    // Calls fn(price, order) for every resting order, lowest price first
+    // and in time priority within a level.
+    template <typename Fn>
+    void VisitOrders(Fn&& fn) const
+    {
+        for (const auto& [price, level] : m_levels)
+        {
+            for (std::uint32_t slot = level.queue.head; slot != OrderPool::kNil;
+                 slot = m_orders[slot].next)
+            {
+                fn(price, m_orders[slot]);
+            }
+        }
+    }
+
+   private:
+    // Calls fn(level) for each map entry, best price first, until fn
+    // returns false.
+    template <typename Fn>
+    void VisitLevelsBestFirst(Fn&& fn) const
+    {
+        if (m_side == 'B')
+        {
+            for (auto level = m_levels.rbegin(); level != m_levels.rend();
+                 ++level)
+            {
+                if (!fn(*level))
+                {
+                    return;
+                }
+            }
+        }
+        else
+        {
+            for (const auto& level : m_levels)
+            {
+                if (!fn(level))
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] Levels::iterator BestLevel() noexcept
+    {
+        return m_side == 'B' ? std::prev(m_levels.end()) : m_levels.begin();
+    }
+
+   private:
+    const char m_side;
+    // Declared first so that it outlives the nodes it hands out.
+    NodeArena m_arena;
+    Levels m_levels;
+    OrderPool m_orders;
+};
+
+#endif
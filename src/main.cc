@@ -1,13 +1,96 @@
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+#include "MappedFile.hpp"
+#include "Replay.hpp"
 #include "TradeEngine.hpp"
 
-int main()
+namespace
 {
-    Trading::TradeEngine engine;
+// Replays a whole order file as fast as possible, see ReplayOrders.
+int RunReplay(const char* inputPath, const char* outputPath,
+              const char* feedName)
+{
+    Trading::TradeEngine engine(Trading::BookType::Tree,
+                                Trading::ConcurrencyMode::SingleWriter);
+    engine.SetTradeHistory(false);
+    if (feedName != nullptr)
+    {
+        engine.OpenMarketData(feedName);
+    }
+
+    const Trading::MappedFile input(inputPath);
+    std::ofstream file;
+    if (outputPath != nullptr)
+    {
+        file.open(outputPath, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Error: Cannot open " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputPath != nullptr ? file : std::cout;
+
+    const Trading::ReplayStats stats =
+        Trading::ReplayOrders(engine, input.Data(), output);
+    std::cerr << "Replayed " << stats.orders << " orders ("
+              << stats.rejected << " rejected) in " << stats.seconds << " s";
+    if (stats.orders > 0 && stats.seconds > 0)
+    {
+        std::cerr << ", " << stats.orders / stats.seconds << " orders/s";
+    }
+    std::cerr << std::endl;
+    return 0;
+}
+}  // namespace
+
+// Usage: TradeMatchingEngine [--replay <orders file> [--output <file>]]
+//                            [--market-data <feed name>]
+int main(int argc, char* argv[])
+{
+    const char* replayPath = nullptr;
+    const char* outputPath = nullptr;
+    const char* feedName = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--market-data") == 0 && i + 1 < argc)
+        {
+            feedName = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--replay <orders file> [--output <file>]]"
+                         " [--market-data <feed name>]"
+                      << std::endl;
+            return 2;
+        }
+    }
 
     try
     {
+        if (replayPath != nullptr)
+        {
+            return RunReplay(replayPath, outputPath, feedName);
+        }
+        Trading::TradeEngine engine;
+        engine.SetTradeHistory(false);
+        if (feedName != nullptr)
+        {
+            engine.OpenMarketData(feedName);
+        }
+        // Lets the input thread read standard input in buffered blocks.
+        std::ios_base::sync_with_stdio(false);
         engine.Start();
     }
     catch (const std::invalid_argument& arg)
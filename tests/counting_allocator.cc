@@ -0,0 +1,107 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Replaces every form of the global allocator to count calls, so that tests
+// can assert that a code path does not allocate. Kept out of the test
+// sources so that the compiler does not inline the malloc and free behind
+// these into code that pairs new with delete.
+std::atomic<std::uint64_t> globalAllocations{0};
+
+namespace
+{
+void* Allocate(const std::size_t size)
+{
+    globalAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* const pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(const std::size_t size, const std::align_val_t align)
+{
+    globalAllocations.fetch_add(1, std::memory_order_relaxed);
+    const auto alignment = static_cast<std::size_t>(align);
+#ifdef _WIN32
+    void* const pointer = ::_aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    // aligned_alloc wants a multiple of the alignment.
+    const std::size_t rounded =
+        (size + alignment - 1) / alignment * alignment;
+    void* const pointer =
+        std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+#endif
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void FreeAligned(void* const pointer) noexcept
+{
+#ifdef _WIN32
+    ::_aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+}  // namespace
+
+void* operator new(const std::size_t size) { return Allocate(size); }
+
+void* operator new[](const std::size_t size) { return Allocate(size); }
+
+void* operator new(const std::size_t size, const std::align_val_t align)
+{
+    return AllocateAligned(size, align);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t align)
+{
+    return AllocateAligned(size, align);
+}
+
+void operator delete(void* const pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void* const pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* const pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* const pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* const pointer, std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
+
+void operator delete[](void* const pointer, std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
+
+void operator delete(void* const pointer, std::size_t,
+                     std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
+
+void operator delete[](void* const pointer, std::size_t,
+                       std::align_val_t) noexcept
+{
+    FreeAligned(pointer);
+}
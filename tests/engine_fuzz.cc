@@ -0,0 +1,687 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BenchSupport.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+struct Operation
+{
+    enum class Kind
+    {
+        Order,
+        Cancel,
+        Amend
+    };
+
+    Kind kind;
+    TradeOrder order;
+    // For Cancel and Amend, the engine id of the order to change.
+    OrderId target;
+};
+
+std::string Describe(const Operation& operation)
+{
+    std::ostringstream out;
+    switch (operation.kind)
+    {
+        case Operation::Kind::Order:
+            out << operation.order.identifier << ' ' << operation.order.side
+                << ' ' << operation.order.quantity << ' '
+                << operation.order.price
+                << OrderTypeSuffix(operation.order.type);
+            break;
+        case Operation::Kind::Cancel:
+            out << "cancel " << operation.target;
+            break;
+        case Operation::Kind::Amend:
+            out << "amend " << operation.target << " to "
+                << operation.order.quantity << '@' << operation.order.price;
+            break;
+    }
+    return out.str();
+}
+
+// Shape of one generated stream. Every run draws its own, so that a long
+// fuzz session covers thin and deep books, many and few traders, calm and
+// cancel-heavy flow, and every self-trade prevention mode.
+struct Profile
+{
+    std::uint64_t traders;
+    std::uint64_t priceSpread;
+    std::uint64_t maxQuantity;
+    std::uint64_t cancelPercent;
+    std::uint64_t amendPercent;
+    std::uint64_t typedPercent;
+    SelfTradePrevention selfTrade;
+};
+
+Profile DrawProfile(SplitMix64& rng)
+{
+    Profile profile{};
+    profile.traders = rng.Between(1, 64);
+    profile.priceSpread = rng.Between(1, 40);
+    profile.maxQuantity = rng.Between(1, 200);
+    profile.cancelPercent = rng.Between(0, 40);
+    profile.amendPercent = rng.Between(0, 20);
+    profile.typedPercent = rng.Between(0, 30);
+    profile.selfTrade = static_cast<SelfTradePrevention>(rng.Between(0, 3));
+    return profile;
+}
+
+std::vector<Operation> Generate(SplitMix64& rng, const Profile& profile,
+                                const std::size_t count)
+{
+    constexpr std::uint64_t kMid = 1000;
+    const OrderType types[] = {OrderType::Market, OrderType::ImmediateOrCancel,
+                               OrderType::FillOrKill, OrderType::PostOnly};
+
+    std::vector<Operation> operations;
+    operations.reserve(count);
+    OrderId orders = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Operation operation{};
+        const std::uint64_t roll = rng.Between(0, 99);
+        if (orders > 0 && roll < profile.cancelPercent)
+        {
+            operation.kind = Operation::Kind::Cancel;
+            operation.target = rng.Between(1, orders);
+        }
+        else if (orders > 0 &&
+                 roll < profile.cancelPercent + profile.amendPercent)
+        {
+            operation.kind = Operation::Kind::Amend;
+            operation.target = rng.Between(1, orders);
+            operation.order.quantity = rng.Between(0, profile.maxQuantity);
+            operation.order.price = kMid - profile.priceSpread +
+                                    rng.Between(0, 2 * profile.priceSpread);
+        }
+        else
+        {
+            operation.kind = Operation::Kind::Order;
+            // Names longer than eight bytes share a sort key prefix, which
+            // exercises the full name comparison of the trade output.
+            const std::uint64_t trader = rng.Between(1, profile.traders);
+            operation.order.identifier =
+                (rng.Percent(20) ? "TraderNumber" : "T") +
+                std::to_string(trader);
+            operation.order.side = rng.Percent(50) ? 'B' : 'S';
+            operation.order.quantity = rng.Between(1, profile.maxQuantity);
+            operation.order.price = kMid - profile.priceSpread +
+                                    rng.Between(0, 2 * profile.priceSpread);
+            if (rng.Percent(profile.typedPercent))
+            {
+                operation.order.type = types[rng.Between(0, 3)];
+            }
+            // Ids are only handed to accepted orders, but any id up to the
+            // number of orders so far is a fair target.
+            ++orders;
+        }
+        operations.push_back(std::move(operation));
+    }
+    return operations;
+}
+
+// Deliberately simple matcher that the engine is checked against. It keeps
+// every resting order of both sides in one vector, searches it for the best
+// counter order before every fill, and formats trades exactly as the
+// original engine did: fills summed per trader, side and price, spelled
+// out, sorted as strings and joined by spaces. Self-trade prevention is
+// applied to each resting order of the incoming order's trader as the
+// order reaches it.
+class ReferenceMatcher
+{
+   public:
+    explicit ReferenceMatcher(const SelfTradePrevention selfTrade)
+        : m_selfTrade(selfTrade)
+    {
+    }
+
+    // Returns the id of the accepted order, or 0 if it was rejected.
+    OrderId Submit(const TradeOrder& order, std::string& trades)
+    {
+        if (order.side != 'B' && order.side != 'S')
+        {
+            return 0;
+        }
+        const bool buy = order.side == 'B';
+        std::uint64_t limit = order.price;
+        bool rest = true;
+        switch (order.type)
+        {
+            case OrderType::Limit:
+                break;
+            case OrderType::Market:
+                limit = buy ? std::numeric_limits<std::uint64_t>::max() : 0;
+                rest = false;
+                break;
+            case OrderType::ImmediateOrCancel:
+            case OrderType::FillOrKill:
+                rest = false;
+                break;
+            case OrderType::PostOnly:
+                if (Available(order.side, limit) > 0)
+                {
+                    return 0;
+                }
+                break;
+        }
+
+        const OrderId id = ++m_lastId;
+        if (order.type == OrderType::FillOrKill &&
+            !CanFill(order.identifier, order.side, order.quantity, limit))
+        {
+            trades.clear();
+            return id;
+        }
+        Enter(id, order.identifier, order.side, order.quantity, limit, rest,
+              trades);
+        return id;
+    }
+
+    bool Cancel(const OrderId id)
+    {
+        const auto resting = Find(id);
+        if (resting == m_resting.end())
+        {
+            return false;
+        }
+        m_resting.erase(resting);
+        return true;
+    }
+
+    bool Amend(const OrderId id, const std::uint64_t quantity,
+               const std::uint64_t price, std::string& trades)
+    {
+        trades.clear();
+        const auto resting = Find(id);
+        if (resting == m_resting.end())
+        {
+            return false;
+        }
+        if (quantity != 0 && quantity <= resting->quantity &&
+            price == resting->price)
+        {
+            resting->quantity = quantity;
+            return true;
+        }
+
+        const Resting order = *resting;
+        m_resting.erase(resting);
+        if (quantity != 0)
+        {
+            Enter(id, order.trader, order.side, quantity, price, true,
+                  trades);
+        }
+        return true;
+    }
+
+    [[nodiscard]] ordersMap Book(const char side) const
+    {
+        std::vector<Resting> orders;
+        for (const Resting& order : m_resting)
+        {
+            if (order.side == side)
+            {
+                orders.push_back(order);
+            }
+        }
+        std::stable_sort(orders.begin(), orders.end(),
+                         [](const Resting& lhs, const Resting& rhs)
+                         { return lhs.time < rhs.time; });
+        ordersMap levels;
+        for (const Resting& order : orders)
+        {
+            levels[order.price].push_back(
+                {order.trader, side, order.quantity, order.price});
+        }
+        return levels;
+    }
+
+   private:
+    struct Resting
+    {
+        OrderId id;
+        std::string trader;
+        char side;
+        std::uint64_t quantity;
+        std::uint64_t price;
+        std::uint64_t time;
+    };
+
+    static bool Crosses(const char side, const std::uint64_t limit,
+                        const std::uint64_t price)
+    {
+        return side == 'B' ? price <= limit : price >= limit;
+    }
+
+    std::vector<Resting>::iterator Find(const OrderId id)
+    {
+        return std::find_if(m_resting.begin(), m_resting.end(),
+                            [id](const Resting& order)
+                            { return order.id == id; });
+    }
+
+    // Whether the order could trade in full before reaching an order of its
+    // own trader that self-trade prevention would act on.
+    bool CanFill(const std::string& trader, const char side,
+                 const std::uint64_t quantity, const std::uint64_t limit) const
+    {
+        std::vector<const Resting*> crossing;
+        for (const Resting& order : m_resting)
+        {
+            if (order.side != side && Crosses(side, limit, order.price))
+            {
+                crossing.push_back(&order);
+            }
+        }
+        std::sort(crossing.begin(), crossing.end(),
+                  [side](const Resting* lhs, const Resting* rhs)
+                  {
+                      if (lhs->price != rhs->price)
+                      {
+                          return Crosses(side, rhs->price, lhs->price);
+                      }
+                      return lhs->time < rhs->time;
+                  });
+        std::uint64_t available = 0;
+        for (const Resting* order : crossing)
+        {
+            if (available >= quantity)
+            {
+                break;
+            }
+            if (m_selfTrade != SelfTradePrevention::None &&
+                order->trader == trader)
+            {
+                return false;
+            }
+            available += order->quantity;
+        }
+        return available >= quantity;
+    }
+
+    std::uint64_t Available(const char side, const std::uint64_t limit) const
+    {
+        std::uint64_t available = 0;
+        for (const Resting& order : m_resting)
+        {
+            if (order.side != side && Crosses(side, limit, order.price))
+            {
+                available += order.quantity;
+            }
+        }
+        return available;
+    }
+
+    void Enter(const OrderId id, const std::string& trader, const char side,
+               std::uint64_t quantity, const std::uint64_t limit,
+               const bool rest, std::string& trades)
+    {
+        std::map<std::pair<std::string, char>,
+                 std::map<std::uint64_t, std::uint64_t>>
+            fills;
+        while (quantity > 0)
+        {
+            auto best = m_resting.end();
+            for (auto order = m_resting.begin(); order != m_resting.end();
+                 ++order)
+            {
+                if (order->side == side ||
+                    !Crosses(side, limit, order->price))
+                {
+                    continue;
+                }
+                if (best == m_resting.end() ||
+                    (order->price == best->price
+                         ? order->time < best->time
+                         : Crosses(side, best->price, order->price)))
+                {
+                    best = order;
+                }
+            }
+            if (best == m_resting.end())
+            {
+                break;
+            }
+
+            const std::uint64_t traded = std::min(best->quantity, quantity);
+            if (m_selfTrade != SelfTradePrevention::None &&
+                best->trader == trader)
+            {
+                if (m_selfTrade == SelfTradePrevention::CancelAggressor)
+                {
+                    quantity = 0;
+                    break;
+                }
+                if (m_selfTrade == SelfTradePrevention::CancelResting)
+                {
+                    m_resting.erase(best);
+                    continue;
+                }
+                quantity -= traded;
+                best->quantity -= traded;
+                if (best->quantity == 0)
+                {
+                    m_resting.erase(best);
+                }
+                continue;
+            }
+            fills[{trader, side == 'B' ? '+' : '-'}][best->price] += traded;
+            fills[{best->trader, side == 'B' ? '-' : '+'}][best->price] +=
+                traded;
+            quantity -= traded;
+            best->quantity -= traded;
+            if (best->quantity == 0)
+            {
+                m_resting.erase(best);
+            }
+        }
+        if (quantity > 0 && rest)
+        {
+            m_resting.push_back({id, trader, side, quantity, limit, ++m_time});
+        }
+
+        std::vector<std::string> spelled;
+        for (const auto& [key, prices] : fills)
+        {
+            for (const auto& [price, traded] : prices)
+            {
+                spelled.push_back(key.first + key.second +
+                                  std::to_string(traded) + '@' +
+                                  std::to_string(price));
+            }
+        }
+        std::sort(spelled.begin(), spelled.end());
+        trades.clear();
+        for (const std::string& trade : spelled)
+        {
+            if (!trades.empty())
+            {
+                trades.push_back(' ');
+            }
+            trades += trade;
+        }
+    }
+
+   private:
+    const SelfTradePrevention m_selfTrade;
+    std::vector<Resting> m_resting;
+    OrderId m_lastId = 0;
+    std::uint64_t m_time = 0;
+};
+
+// What the engine did with one operation.
+struct Outcome
+{
+    // Order id, 0 if rejected; for Cancel and Amend, 1 if it succeeded.
+    std::uint64_t result;
+    std::string trades;
+};
+
+// Runs operations through engine, recording each outcome unless outcomes
+// is null. Returns the seconds spent.
+double RunEngine(TradeEngine& engine, const std::vector<Operation>& operations,
+                 std::vector<Outcome>* const outcomes)
+{
+    std::string trades;
+    engine.SetTradeHistory(false);
+    engine.SetTradeSink([&trades](const std::string_view text)
+                        { trades.assign(text); });
+    if (outcomes != nullptr)
+    {
+        outcomes->clear();
+        outcomes->reserve(operations.size());
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const Operation& operation : operations)
+    {
+        trades.clear();
+        std::uint64_t result = 0;
+        switch (operation.kind)
+        {
+            case Operation::Kind::Order:
+                try
+                {
+                    result = engine.ProcessOrder(operation.order);
+                }
+                catch (const std::invalid_argument&)
+                {
+                    result = 0;
+                }
+                break;
+            case Operation::Kind::Cancel:
+                result = engine.Cancel(operation.target);
+                break;
+            case Operation::Kind::Amend:
+                result = engine.Amend(operation.target,
+                                      operation.order.quantity,
+                                      operation.order.price);
+                break;
+        }
+        if (outcomes != nullptr)
+        {
+            outcomes->push_back({result, trades});
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+std::string DescribeBook(const ordersMap& levels)
+{
+    std::ostringstream out;
+    for (const auto& [price, orders] : levels)
+    {
+        for (const TradeOrder& order : orders)
+        {
+            out << "  " << order.identifier << ' ' << order.side << ' '
+                << order.quantity << '@' << price << '\n';
+        }
+    }
+    return out.str();
+}
+
+// Replays operations on the reference matcher and reports the first
+// operation whose outcome differs, then any difference in the final books.
+bool Verify(const SelfTradePrevention selfTrade,
+            const std::vector<Operation>& operations,
+            const std::vector<Outcome>& outcomes, const TradeEngine& engine)
+{
+    ReferenceMatcher reference(selfTrade);
+    std::string trades;
+    for (std::size_t i = 0; i < operations.size(); ++i)
+    {
+        const Operation& operation = operations[i];
+        std::uint64_t result = 0;
+        trades.clear();
+        switch (operation.kind)
+        {
+            case Operation::Kind::Order:
+                result = reference.Submit(operation.order, trades);
+                break;
+            case Operation::Kind::Cancel:
+                result = reference.Cancel(operation.target);
+                break;
+            case Operation::Kind::Amend:
+                result = reference.Amend(operation.target,
+                                         operation.order.quantity,
+                                         operation.order.price, trades);
+                break;
+        }
+        if (result != outcomes[i].result || trades != outcomes[i].trades)
+        {
+            std::cerr << "Operation " << i << " (" << Describe(operation)
+                      << "): expected result " << result << " and trades '"
+                      << trades << "', engine gave " << outcomes[i].result
+                      << " and '" << outcomes[i].trades << "'\n";
+            return false;
+        }
+    }
+
+    for (const char side : {'B', 'S'})
+    {
+        const std::string expected = DescribeBook(reference.Book(side));
+        const std::string actual = DescribeBook(
+            side == 'B' ? engine.GetBuyOrders() : engine.GetSellOrders());
+        if (expected != actual)
+        {
+            std::cerr << "Final " << (side == 'B' ? "bids" : "asks")
+                      << " differ. Expected:\n"
+                      << expected << "Engine:\n"
+                      << actual;
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Options
+{
+    std::uint64_t runs = 100;
+    std::size_t orders = 10000;
+    std::uint64_t seed = 1;
+    bool throughput = false;
+    bool verbose = false;
+    std::vector<BookType> books{BookType::Tree, BookType::Ladder};
+    std::string record;
+};
+
+const char* Name(const BookType book)
+{
+    return book == BookType::Tree ? "tree" : "ladder";
+}
+}  // namespace
+
+// Usage: EngineFuzz [--runs N] [--orders N] [--seed S] [--book tree|ladder]
+//                   [--throughput] [--verbose] [--record <csv file>]
+// Run i uses stream seed S + i on every book type, so a failure is
+// reproduced with --seed <reported seed> --runs 1. With --throughput the
+// reference check is skipped and only the engine is timed.
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--runs") == 0 && hasValue)
+        {
+            options.runs = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--orders") == 0 && hasValue)
+        {
+            options.orders = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            options.seed = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--book") == 0 && hasValue)
+        {
+            const std::string book = argv[++i];
+            options.books = {book == "ladder" ? BookType::Ladder
+                                              : BookType::Tree};
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && hasValue)
+        {
+            options.record = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--throughput") == 0)
+        {
+            options.throughput = true;
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            options.verbose = true;
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--runs N] [--orders N] [--seed S]"
+                         " [--book tree|ladder] [--throughput] [--verbose]"
+                         " [--record <csv file>]\n";
+            return 2;
+        }
+    }
+
+    std::ofstream record;
+    if (!options.record.empty())
+    {
+        record.open(options.record, std::ios::app);
+        if (!record)
+        {
+            std::cerr << "Cannot open " << options.record << '\n';
+            return 2;
+        }
+    }
+
+    std::map<BookType, std::pair<std::uint64_t, double>> totals;
+    std::vector<Outcome> outcomes;
+    for (std::uint64_t run = 0; run < options.runs; ++run)
+    {
+        const std::uint64_t seed = options.seed + run;
+        SplitMix64 rng(seed);
+        const Profile profile = DrawProfile(rng);
+        const std::vector<Operation> operations =
+            Generate(rng, profile, options.orders);
+        for (const BookType book : options.books)
+        {
+            TradeEngine engine(book, ConcurrencyMode::SingleWriter);
+            engine.SetSelfTradePrevention(profile.selfTrade);
+            const double seconds = RunEngine(
+                engine, operations, options.throughput ? nullptr : &outcomes);
+            if (!options.throughput &&
+                !Verify(profile.selfTrade, operations, outcomes, engine))
+            {
+                std::cerr << "Mismatch on the " << Name(book)
+                          << " book, reproduce with --seed " << seed
+                          << " --runs 1 --orders " << options.orders
+                          << std::endl;
+                return 1;
+            }
+
+            const double rate = operations.size() / seconds;
+            totals[book].first += operations.size();
+            totals[book].second += seconds;
+            if (options.verbose)
+            {
+                std::cout << "seed " << seed << ' ' << Name(book) << ": "
+                          << rate / 1e6 << " M ops/s\n";
+            }
+            if (record)
+            {
+                record << seed << ',' << Name(book) << ','
+                       << operations.size() << ',' << rate << ','
+                       << (options.throughput ? "unchecked" : "verified")
+                       << '\n';
+            }
+        }
+    }
+
+    for (const auto& [book, total] : totals)
+    {
+        std::cout << options.runs << " runs of " << options.orders
+                  << " operations on the " << Name(book) << " book "
+                  << (options.throughput ? "timed" : "match the reference")
+                  << ", " << total.first / total.second / 1e6
+                  << " M ops/s overall\n";
+    }
+    return 0;
+}
@@ -1,11 +1,48 @@
 #include "TradeEngine.hpp"
+#include "EngineStats.hpp"
+#include "Gateway.hpp"
+#include "MarketData.hpp"
+#include "MappedFile.hpp"
+#include "MatchingKernel.hpp"
+#include "OccupancyBitmap.hpp"
+#include "OrderIndex.hpp"
+#include "OrderPool.hpp"
+#include "Replay.hpp"
+#include "ShardedEngine.hpp"
+#include "SpscQueue.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace Trading;
 
+// Calls to the global allocator, counted by counting_allocator.cc so that
+// tests can assert that a code path does not allocate.
+extern std::atomic<std::uint64_t> globalAllocations;
+
 enum class TestResult
 {
     PASSED,
@@ -317,6 +354,2185 @@ TestResult testTransactions3()
     return validateTransactions(engine, transactions, expected, "Transactions_3");
 }
 
+TestResult testTransactionsLadder()
+{
+    TradeEngine engine1(BookType::Ladder);
+    std::array<std::string, 12> transactions1 = {
+        "T1 B 5 30", "T2 S 5 70",  "T3 B 1 40", "T4 S 2 60",
+        "T5 S 3 70", "T6 S 20 80", "T7 S 1 50", "T2 S 5 70",
+        "T1 B 1 50", "T1 B 3 60",  "T7 S 2 50", "T8 B 10 90"};
+    std::array<std::string, 4> expected1 = {
+        "T1+1@50 T7-1@50", "T1+2@60 T4-2@60", "T1+1@60 T7-1@60",
+        "T2-6@70 T5-3@70 T7-1@50 T8+1@50 T8+9@70"};
+    if (validateTransactions(engine1, transactions1, expected1,
+                             "Ladder_Transactions_1") != TestResult::PASSED)
+    {
+        return TestResult::FAILED;
+    }
+
+    TradeEngine engine2(BookType::Ladder);
+    std::array<std::string, 10> transactions2 = {
+        "T1 B 5 100", "T2 S 3 90",  "T3 S 4 95",  "T4 B 6 105",
+        "T5 S 5 100", "T6 B 2 100", "T7 S 3 105", "T8 B 4 110",
+        "T9 S 2 115", "T10 B 3 120"};
+    std::array<std::string, 7> expected2 = {
+        "T1+3@100 T2-3@100", "T1+2@100 T3-2@100", "T3-2@95 T4+2@95",
+        "T4+4@105 T5-4@105", "T5-1@100 T6+1@100", "T7-3@105 T8+3@105",
+        "T10+2@115 T9-2@115"};
+    return validateTransactions(engine2, transactions2, expected2,
+                                "Ladder_Transactions_2");
+}
+
+TestResult testLadderBookDepth()
+{
+    TradeEngine engine(BookType::Ladder);
+    engine.ProcessOrder(engine.ParseInput("T2 B 3 5000"));
+    engine.ProcessOrder(engine.ParseInput("T1 B 5 100"));
+    engine.ProcessOrder(engine.ParseInput("T3 B 2 3"));
+    engine.ProcessOrder(engine.ParseInput("T4 B 1 100"));
+    engine.ProcessOrder(engine.ParseInput("T5 S 4 100"));
+    decltype(auto) buyOrders = engine.GetBuyOrders();
+
+    if (buyOrders.size() != 2)
+    {
+        std::cerr << "Ladder: Depth failed - Expected 2 price levels, got "
+                  << buyOrders.size() << std::endl;
+        return TestResult::FAILED;
+    }
+    if (buyOrders.count(5000) != 0 || buyOrders.at(100).size() != 2)
+    {
+        std::cerr << "Ladder: Depth failed - Unexpected levels after sweep\n";
+        return TestResult::FAILED;
+    }
+    if (buyOrders.at(100).front().identifier != "T1" ||
+        buyOrders.at(100).front().quantity != 4 ||
+        buyOrders.at(100).back().identifier != "T4")
+    {
+        std::cerr << "Ladder: Depth failed - Time priority not preserved\n";
+        return TestResult::FAILED;
+    }
+    if (buyOrders.at(3).front().quantity != 2)
+    {
+        std::cerr << "Ladder: Depth failed - Expected quantity 2 at price 3\n";
+        return TestResult::FAILED;
+    }
+    decltype(auto) trades = engine.GetTrades();
+    if (trades.size() != 1 || trades[0] != "T1+1@100 T2+3@5000 T5-1@100 T5-3@5000")
+    {
+        std::cerr << "Ladder: Depth failed - Unexpected trades\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "Ladder: Depth - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testTradeSinkStreaming()
+{
+    TradeEngine engine;
+    std::vector<std::string> streamed;
+    engine.SetTradeSink([&streamed](std::string_view trade)
+                        { streamed.emplace_back(trade); });
+    engine.SetTradeHistory(false);
+
+    std::array<std::string, 5> transactions = {
+        "T1 B 5 30", "T2 S 2 30", "T3 B 1 20", "T4 S 4 20", "T5 B 1 40"};
+    std::array<std::string, 2> expected = {"T1+2@30 T2-2@30",
+                                           "T1+3@30 T3+1@20 T4-1@20 T4-3@30"};
+    for (const auto& s : transactions)
+    {
+        engine.ProcessOrder(engine.ParseInput(s));
+    }
+
+    if (!engine.GetTrades().empty())
+    {
+        std::cerr << "TradeSink: Streaming failed - History retained\n";
+        return TestResult::FAILED;
+    }
+    if (streamed.size() != expected.size())
+    {
+        std::cerr << "TradeSink: Streaming failed - Expected "
+                  << expected.size() << " trades, got " << streamed.size()
+                  << std::endl;
+        return TestResult::FAILED;
+    }
+    for (std::size_t i = 0; i < streamed.size(); ++i)
+    {
+        if (streamed[i] != expected[i])
+        {
+            std::cerr << "TradeSink: Streaming mismatch. Expected: "
+                      << expected[i] << ", Got: " << streamed[i] << std::endl;
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "TradeSink: Streaming - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testFastParser()
+{
+    OrderView order{};
+    if (ParseOrder(" T12\tS  12345678901234567 9\r", order) != ParseStatus::Ok ||
+        order.identifier != "T12" || order.side != 'S' ||
+        order.quantity != 12345678901234567ULL || order.price != 9)
+    {
+        std::cerr << "FastParser: Valid input failed\n";
+        return TestResult::FAILED;
+    }
+    if (ParseOrder("T1 B 18446744073709551615 1", order) != ParseStatus::Ok ||
+        order.quantity != 18446744073709551615ULL)
+    {
+        std::cerr << "FastParser: Max quantity failed\n";
+        return TestResult::FAILED;
+    }
+
+    const std::array<std::pair<std::string, ParseStatus>, 9> invalid = {{
+        {"   ", ParseStatus::Empty},
+        {"T-1 B 5 30", ParseStatus::BadIdentifier},
+        {"T1 X 5 30", ParseStatus::BadSide},
+        {"T1 BUY 5 30", ParseStatus::BadSide},
+        {"T1 B 5x 30", ParseStatus::BadQuantity},
+        {"T1 B 18446744073709551616 30", ParseStatus::BadQuantity},
+        {"T1 B 5", ParseStatus::BadPrice},
+        {"T1 B 5 123456789012345678901", ParseStatus::BadPrice},
+        {"T1 B 5 30 40", ParseStatus::TrailingInput},
+    }};
+    for (const auto& [input, status] : invalid)
+    {
+        if (ParseOrder(input, order) != status)
+        {
+            std::cerr << "FastParser: Expected '" << ToString(status)
+                      << "' for input '" << input << "'\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "FastParser: Valid and invalid input - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testStartSkipsBadLines()
+{
+    TradeEngine engine;
+    std::vector<std::string> streamed;
+    engine.SetTradeSink([&streamed](std::string_view trade)
+                        { streamed.emplace_back(trade); });
+
+    std::istringstream input("T1 B 5 30\nT2 S x 30\n\nT3 Q 1 1\nT2 S 5 30\n");
+    std::streambuf* const previous = std::cin.rdbuf(input.rdbuf());
+    engine.Start();
+    std::cin.rdbuf(previous);
+
+    if (engine.GetRejectedLines() != 2)
+    {
+        std::cerr << "Start: Bad lines failed - Expected 2 rejected lines, got "
+                  << engine.GetRejectedLines() << std::endl;
+        return TestResult::FAILED;
+    }
+    if (streamed.size() != 1 || streamed[0] != "T1+5@30 T2-5@30")
+    {
+        std::cerr << "Start: Bad lines failed - Trade after bad lines missing\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "Start: Bad lines - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testTraderInterning()
+{
+    TraderRegistry traders;
+    const TraderId first = traders.Intern("T1");
+    const TraderId second = traders.Intern("T10");
+    std::string again = "T1";
+    if (first != 0 || second != 1 || traders.Intern(again) != first)
+    {
+        std::cerr << "TraderRegistry: Interning failed - Ids not dense\n";
+        return TestResult::FAILED;
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        (void)traders.Intern("X" + std::to_string(i));
+    }
+    if (traders.Size() != 1002 || traders.Name(first) != "T1" ||
+        traders.Name(second) != "T10" || traders.Intern("X999") != 1001)
+    {
+        std::cerr << "TraderRegistry: Interning failed - Names not stable\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "TraderRegistry: Interning - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testCollectTradesOrdering()
+{
+    TradeEngine engine;
+    std::array<std::string, 8> transactions = {
+        "A S 1 7",  "A S 2 7",  "A S 10 70",
+        "A S 100 700", "B S 5 8", "B S 5 80",
+        "T1 S 3000000000 9000000000", "T10 B 3000000123 9000000000"};
+    std::array<std::string, 1> expected = {
+        "A-100@700 A-10@70 A-3@7 B-5@8 B-5@80 T1-3000000000@9000000000 "
+        "T10+100@700 T10+10@70 T10+3000000000@9000000000 T10+3@7 T10+5@8 "
+        "T10+5@80"};
+    return validateTransactions(engine, transactions, expected,
+                                "CollectTrades_Ordering");
+}
+
+TestResult testSpscQueue()
+{
+    constexpr int count = 100000;
+    SpscQueue<int> queue(64);
+    std::thread producer(
+        [&queue]
+        {
+            for (int value = 0; value < count; ++value)
+            {
+                while (!queue.TryPush(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+    int expected = 0;
+    int value = 0;
+    while (expected < count)
+    {
+        if (!queue.TryPop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (value != expected)
+        {
+            std::cerr << "SpscQueue: Order failed - Expected " << expected
+                      << ", got " << value << std::endl;
+            producer.join();
+            return TestResult::FAILED;
+        }
+        ++expected;
+    }
+    producer.join();
+    if (!queue.Empty() || queue.Capacity() != 64)
+    {
+        std::cerr << "SpscQueue: Order failed - Queue not drained\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "SpscQueue: Order - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testShardedEngine()
+{
+    std::array<std::string, 12> transactions = {
+        "T1 B 5 30", "T2 S 5 70",  "T3 B 1 40", "T4 S 2 60",
+        "T5 S 3 70", "T6 S 20 80", "T7 S 1 50", "T2 S 5 70",
+        "T1 B 1 50", "T1 B 3 60",  "T7 S 2 50", "T8 B 10 90"};
+    std::array<std::string, 4> expected = {
+        "T1+1@50 T7-1@50", "T1+2@60 T4-2@60", "T1+1@60 T7-1@60",
+        "T2-6@70 T5-3@70 T7-1@50 T8+1@50 T8+9@70"};
+
+    std::mutex mutex;
+    std::map<std::string, std::vector<std::string>> trades;
+    {
+        ShardedEngine engine(
+            3,
+            [&](std::string_view instrument, std::string_view trade)
+            {
+                std::lock_guard lock(mutex);
+                trades[std::string(instrument)].emplace_back(trade);
+            },
+            BookType::Ladder, 4);
+
+        TradeEngine parser;
+        for (const auto& s : transactions)
+        {
+            const TradeOrder order = parser.ParseInput(s);
+            for (int instrument = 0; instrument < 10; ++instrument)
+            {
+                engine.Submit("SYM" + std::to_string(instrument), order);
+            }
+        }
+        engine.Submit("SYM0", TradeOrder{"T9", 'X', 1, 1});
+        engine.Flush();
+
+        if (engine.InstrumentCount() != 10 || engine.GetRejectedOrders() != 1)
+        {
+            std::cerr << "ShardedEngine: Failed - Unexpected counters\n";
+            return TestResult::FAILED;
+        }
+
+#ifndef _WIN32
+        // Idle shards back off to sleeping instead of holding their cores;
+        // spinning, the three of them would use about 600 ms here. clock()
+        // is process CPU time except on Windows.
+        const std::clock_t before = std::clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const double cpuSeconds =
+            static_cast<double>(std::clock() - before) / CLOCKS_PER_SEC;
+        if (cpuSeconds > 0.1)
+        {
+            std::cerr << "ShardedEngine: Failed - Idle shards used "
+                      << cpuSeconds << " s of CPU\n";
+            return TestResult::FAILED;
+        }
+#endif
+    }
+
+    if (trades.size() != 10)
+    {
+        std::cerr << "ShardedEngine: Failed - Expected 10 instruments, got "
+                  << trades.size() << std::endl;
+        return TestResult::FAILED;
+    }
+    for (const auto& [instrument, instrumentTrades] : trades)
+    {
+        if (!std::equal(instrumentTrades.begin(), instrumentTrades.end(),
+                        expected.begin(), expected.end()))
+        {
+            std::cerr << "ShardedEngine: Failed - Trades of " << instrument
+                      << " differ from a single engine\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "ShardedEngine: Per-instrument ordering - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testBookSnapshots()
+{
+    TradeEngine engine(BookType::Ladder, ConcurrencyMode::SingleWriter);
+    engine.SetSnapshotDepth(2);
+    std::array<std::string, 6> transactions = {
+        "T1 B 5 100", "T2 B 3 100", "T3 B 4 99",
+        "T4 B 1 98",  "T5 S 7 105", "T6 S 2 100"};
+    for (const auto& s : transactions)
+    {
+        engine.ProcessOrder(engine.ParseInput(s));
+    }
+
+    const TopOfBook top = engine.GetTopOfBook();
+    if (top.sequence != 6 || top.bid.price != 100 || top.bid.quantity != 6 ||
+        top.bid.orders != 2 || top.ask.price != 105 || top.ask.quantity != 7)
+    {
+        std::cerr << "Snapshots: Top of book failed - Got bid "
+                  << top.bid.quantity << "@" << top.bid.price << ", ask "
+                  << top.ask.quantity << "@" << top.ask.price << std::endl;
+        return TestResult::FAILED;
+    }
+
+    const BookSnapshot snapshot = engine.GetBookSnapshot();
+    if (snapshot.bidLevels != 2 || snapshot.askLevels != 1 ||
+        snapshot.bids[1].price != 99 || snapshot.bids[1].quantity != 4)
+    {
+        std::cerr << "Snapshots: Depth failed - Got " << snapshot.bidLevels
+                  << " bid and " << snapshot.askLevels << " ask levels\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "Snapshots: Top of book and depth - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testSnapshotConcurrentReader()
+{
+    constexpr std::uint64_t count = 20000;
+    TradeEngine engine(BookType::Tree, ConcurrencyMode::SingleWriter);
+    engine.SetSnapshotDepth(1);
+
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> torn{0};
+    std::thread reader(
+        [&]
+        {
+            while (!done.load(std::memory_order_acquire))
+            {
+                // Every order rests a new best bid of quantity and price k.
+                const TopOfBook top = engine.GetTopOfBook();
+                if (top.bid.price != top.sequence ||
+                    top.bid.quantity != top.sequence)
+                {
+                    torn.fetch_add(1);
+                }
+            }
+        });
+
+    for (std::uint64_t k = 1; k <= count; ++k)
+    {
+        engine.ProcessOrder(TradeOrder{"T1", 'B', k, k});
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    if (torn.load() != 0 || engine.GetTopOfBook().sequence != count)
+    {
+        std::cerr << "Snapshots: Concurrent reader failed - " << torn.load()
+                  << " inconsistent reads\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "Snapshots: Concurrent reader - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testOrderIndex()
+{
+    OrderIndex<std::uint64_t> index(16);
+    std::unordered_map<OrderId, std::uint64_t> reference;
+    std::uint64_t state = 7;
+    for (int step = 0; step < 200000; ++step)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const OrderId id = (state >> 33) % 5000 + 1;
+        if ((state >> 20) % 3 == 0)
+        {
+            if (index.Erase(id) != (reference.erase(id) == 1))
+            {
+                std::cerr << "OrderIndex: Erase mismatch for " << id << "\n";
+                return TestResult::FAILED;
+            }
+        }
+        else if (index.Find(id) == nullptr)
+        {
+            index.Insert(id, state);
+            reference[id] = state;
+        }
+    }
+
+    if (index.Size() != reference.size())
+    {
+        std::cerr << "OrderIndex: Expected " << reference.size()
+                  << " entries, got " << index.Size() << std::endl;
+        return TestResult::FAILED;
+    }
+    for (const auto& [id, value] : reference)
+    {
+        const std::uint64_t* found = index.Find(id);
+        if (found == nullptr || *found != value)
+        {
+            std::cerr << "OrderIndex: Lookup mismatch for " << id << "\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "OrderIndex: Random operations - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testCancelOrder()
+{
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        const OrderId first = engine.ProcessOrder(engine.ParseInput("T1 B 5 100"));
+        const OrderId second = engine.ProcessOrder(engine.ParseInput("T2 B 3 100"));
+        const OrderId third = engine.ProcessOrder(engine.ParseInput("T3 B 4 99"));
+
+        if (!engine.Cancel(first) || engine.Cancel(first) || !engine.Cancel(third))
+        {
+            std::cerr << "Cancel: Failed - Unexpected cancel result\n";
+            return TestResult::FAILED;
+        }
+        decltype(auto) buyOrders = engine.GetBuyOrders();
+        if (buyOrders.size() != 1 || buyOrders.at(100).size() != 1 ||
+            buyOrders.at(100).front().identifier != "T2")
+        {
+            std::cerr << "Cancel: Failed - Unexpected book after cancel\n";
+            return TestResult::FAILED;
+        }
+
+        engine.ProcessOrder(engine.ParseInput("T4 S 10 90"));
+        if (engine.Cancel(second) || engine.GetTrades().back() != "T2+3@100 T4-3@100")
+        {
+            std::cerr << "Cancel: Failed - Filled order still cancellable\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "Cancel: Resting orders - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testAmendOrder()
+{
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        const OrderId first = engine.ProcessOrder(engine.ParseInput("T1 S 5 100"));
+        engine.ProcessOrder(engine.ParseInput("T2 S 5 100"));
+        const OrderId third = engine.ProcessOrder(engine.ParseInput("T3 S 5 101"));
+
+        // Reducing keeps T1 ahead of T2; repricing T3 sends it to the back.
+        if (!engine.Amend(first, 2, 100) || !engine.Amend(third, 5, 100))
+        {
+            std::cerr << "Amend: Failed - Resting order not amended\n";
+            return TestResult::FAILED;
+        }
+        engine.ProcessOrder(engine.ParseInput("T4 B 8 100"));
+        decltype(auto) trades = engine.GetTrades();
+        if (trades.size() != 1 || trades[0] != "T1-2@100 T2-5@100 T3-1@100 T4+8@100")
+        {
+            std::cerr << "Amend: Failed - Priority not respected\n";
+            return TestResult::FAILED;
+        }
+
+        // Repricing through the opposite side trades immediately.
+        const OrderId bid = engine.ProcessOrder(engine.ParseInput("T5 B 2 90"));
+        if (!engine.Amend(bid, 6, 100) || engine.GetTrades().back() != "T3-4@100 T5+4@100")
+        {
+            std::cerr << "Amend: Failed - Crossing amend did not trade\n";
+            return TestResult::FAILED;
+        }
+        decltype(auto) buyOrders = engine.GetBuyOrders();
+        if (buyOrders.size() != 1 || buyOrders.at(100).front().quantity != 2 ||
+            !engine.Amend(bid, 0, 100) || !engine.GetBuyOrders().empty())
+        {
+            std::cerr << "Amend: Failed - Unexpected book after amend\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "Amend: Priority rules - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testBinaryProtocol()
+{
+    // Text scenario converted the way OrderConverter does, through a
+    // binary order file held in memory.
+    const std::array<std::string, 12> transactions = {
+        "T1 B 5 30", "T2 S 5 70",  "T3 B 1 40", "T4 S 2 60",
+        "T5 S 3 70", "T6 S 20 80", "T7 S 1 50", "T2 S 5 70",
+        "T1 B 1 50", "T1 B 3 60",  "T7 S 2 50", "T8 B 10 90"};
+    TraderRegistry names;
+    std::string messages;
+    for (const std::string& line : transactions)
+    {
+        OrderView order{};
+        static_cast<void>(ParseOrder(line, order));
+        char buffer[kOrderMessageSize];
+        EncodeOrder({0, order.price, order.quantity,
+                     names.Intern(order.identifier), order.side,
+                     OrderType::Limit, {}},
+                    buffer);
+        messages.append(buffer, sizeof(buffer));
+    }
+    std::vector<std::string> traderTable;
+    for (TraderId id = 0; id < names.Size(); ++id)
+    {
+        traderTable.emplace_back(names.Name(id));
+    }
+    std::stringstream file;
+    WriteOrderFileHeader(file, traderTable);
+    file << messages;
+
+    TradeEngine engine(BookType::Ladder);
+    std::vector<ExecutionReport> reports;
+    engine.SetReportSink(
+        [&reports](const ExecutionReport* data, const std::size_t count)
+        { reports.insert(reports.end(), data, data + count); });
+    for (const std::string& name : ReadOrderFileHeader(file))
+    {
+        static_cast<void>(engine.RegisterTrader(name));
+    }
+    const std::string body(std::istreambuf_iterator<char>(file), {});
+    if (engine.ProcessMessages(body.data(), body.size() + 5) != body.size())
+    {
+        std::cerr << "BinaryProtocol: Failed - Messages not consumed\n";
+        return TestResult::FAILED;
+    }
+
+    const std::vector<std::string> expected = {
+        "T1+1@50 T7-1@50", "T1+2@60 T4-2@60", "T1+1@60 T7-1@60",
+        "T2-6@70 T5-3@70 T7-1@50 T8+1@50 T8+9@70"};
+    if (engine.GetTrades() != expected)
+    {
+        std::cerr << "BinaryProtocol: Failed - Trades differ from text replay\n";
+        return TestResult::FAILED;
+    }
+
+    // T1 B 1 50 (order 9) takes 1 from T7 (order 7).
+    const ExecutionReport& taker = reports.at(0);
+    const ExecutionReport& maker = reports.at(1);
+    if (reports.size() != 14 || taker.orderId != 9 || taker.side != 'B' ||
+        taker.liquidity != 'A' || taker.price != 50 || taker.quantity != 1 ||
+        maker.orderId != 7 || maker.side != 'S' || maker.liquidity != 'P' ||
+        engine.ProcessMessages(messages.data(), 31) != 0)
+    {
+        std::cerr << "BinaryProtocol: Failed - Unexpected execution reports\n";
+        return TestResult::FAILED;
+    }
+
+    OrderMessage unknown{0, 10, 10, 100, 'B', OrderType::Limit, {}};
+    char buffer[kOrderMessageSize];
+    EncodeOrder(unknown, buffer);
+    engine.ProcessMessages(buffer, sizeof(buffer));
+    if (engine.GetRejectedLines() != 1)
+    {
+        std::cerr << "BinaryProtocol: Failed - Unknown trader accepted\n";
+        return TestResult::FAILED;
+    }
+
+    // A corrupt trader count must not be allocated.
+    std::stringstream corrupt;
+    WriteOrderFileHeader(corrupt, {});
+    std::string header = corrupt.str();
+    std::memset(header.data() + header.size() - 4, 0xff, 4);
+    try
+    {
+        std::istringstream in(header);
+        static_cast<void>(ReadOrderFileHeader(in));
+        std::cerr << "BinaryProtocol: Failed - Corrupt header accepted\n";
+        return TestResult::FAILED;
+    }
+    catch (const std::invalid_argument&)
+    {
+    }
+    std::cout << "BinaryProtocol: Text scenario replay - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testReplayOrders()
+{
+    const char* const path = "replay_orders_test.txt";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "T1 B 5 30\r\n\nT2 S 5 70\nbad line\nT3 S 2 30\n"
+                "T4 B 9 70";
+    }
+
+    std::ostringstream output;
+    ReplayStats stats{};
+    {
+        const MappedFile input(path);
+        TradeEngine engine(BookType::Tree, ConcurrencyMode::SingleWriter);
+        engine.SetTradeHistory(false);
+        stats = ReplayOrders(engine, input.Data(), output);
+    }
+    std::remove(path);
+
+    if (stats.orders != 4 || stats.rejected != 1)
+    {
+        std::cerr << "ReplayOrders: Expected 4 orders and 1 rejected, got "
+                  << stats.orders << " and " << stats.rejected << std::endl;
+        return TestResult::FAILED;
+    }
+    if (output.str() != "T1+2@30 T3-2@30\nT2-5@70 T4+5@70\n")
+    {
+        std::cerr << "ReplayOrders: Unexpected output " << output.str()
+                  << std::endl;
+        return TestResult::FAILED;
+    }
+    std::cout << "ReplayOrders: Mapped file replay - Passed\n";
+    return TestResult::PASSED;
+}
+
+std::string describeBook(const ordersMap& levels)
+{
+    std::ostringstream out;
+    for (const auto& [price, orders] : levels)
+    {
+        for (const TradeOrder& order : orders)
+        {
+            out << order.identifier << ' ' << order.side << ' '
+                << order.quantity << ' ' << price << '\n';
+        }
+    }
+    return out.str();
+}
+
+TestResult testJournalRestore()
+{
+    const std::string journalPath = "journal_restore_test.log";
+    const std::string snapshotPath = "journal_restore_test.snap";
+    std::filesystem::remove(journalPath);
+
+    std::string buyBook;
+    std::string sellBook;
+    std::uintmax_t journalSize = 0;
+    std::uint64_t lastFill = 0;
+    {
+        TradeEngine engine(BookType::Ladder);
+        engine.SetFillSink(
+            [&lastFill](const Fill* fills, const std::size_t count)
+            { lastFill = fills[count - 1].sequence; });
+        engine.OpenJournal(journalPath, JournalOptions{4, false});
+        engine.ProcessOrder(engine.ParseInput("T1 B 5 100"));
+        const OrderId second = engine.ProcessOrder(engine.ParseInput("T2 B 7 99"));
+        engine.ProcessOrder(engine.ParseInput("T3 S 4 103"));
+        engine.ProcessOrder(engine.ParseInput("T1 S 2 100"));
+        engine.Cancel(second);
+        engine.WriteSnapshot(snapshotPath);
+
+        const OrderId fifth = engine.ProcessOrder(engine.ParseInput("T4 B 6 98"));
+        engine.ProcessOrder(engine.ParseInput("T5 S 3 102"));
+        engine.Amend(fifth, 6, 102);
+        engine.ProcessOrder(engine.ParseInput("T2 S 1 97"));
+        buyBook = describeBook(engine.GetBuyOrders());
+        sellBook = describeBook(engine.GetSellOrders());
+    }
+    journalSize = std::filesystem::file_size(journalPath);
+    {
+        // A record torn by a crash.
+        std::ofstream journal(journalPath, std::ios::binary | std::ios::app);
+        journal << "torn";
+    }
+
+    for (const std::string& snapshot : {snapshotPath, std::string()})
+    {
+        std::vector<std::string> published;
+        std::vector<Fill> fills;
+        TradeEngine engine(BookType::Tree);
+        engine.SetTradeSink([&published](const std::string_view trades)
+                            { published.emplace_back(trades); });
+        engine.SetFillSink([&fills](const Fill* data, const std::size_t count)
+                           { fills.insert(fills.end(), data, data + count); });
+        engine.Restore(snapshot, journalPath);
+
+        if (describeBook(engine.GetBuyOrders()) != buyBook ||
+            describeBook(engine.GetSellOrders()) != sellBook ||
+            !published.empty())
+        {
+            std::cerr << "JournalRestore: Failed - Restored book differs\n";
+            return TestResult::FAILED;
+        }
+        if (std::filesystem::file_size(journalPath) != journalSize)
+        {
+            std::cerr << "JournalRestore: Failed - Torn record not removed\n";
+            return TestResult::FAILED;
+        }
+        if (engine.ProcessOrder(engine.ParseInput("T6 S 1 90")) != 8 ||
+            published.size() != 1 || published[0] != "T4+1@102 T6-1@102" ||
+            fills.size() != 1 || fills[0].sequence != lastFill + 1)
+        {
+            std::cerr << "JournalRestore: Failed - Engine did not resume\n";
+            return TestResult::FAILED;
+        }
+    }
+
+    // A batch is on disk by the time its results are returned.
+    std::filesystem::remove(journalPath);
+    {
+        TradeEngine engine(BookType::Ladder);
+        engine.OpenJournal(journalPath, JournalOptions{64, false});
+        const std::array<TradeEngine::TradeOrder, 2> batch = {
+            engine.ParseInput("T1 B 5 100"), engine.ParseInput("T2 S 2 100")};
+        std::array<OrderResult, 2> results{};
+        engine.ProcessOrders(Span<const TradeEngine::TradeOrder>(batch),
+                             Span<OrderResult>(results));
+        // The settings, two traders and two orders.
+        if (std::filesystem::file_size(journalPath) !=
+            5 * sizeof(JournalRecord) + 4)
+        {
+            std::cerr << "JournalRestore: Failed - Batch not flushed\n";
+            return TestResult::FAILED;
+        }
+    }
+
+    // Settings are journaled, so a restored engine matches like the
+    // original did.
+    std::filesystem::remove(journalPath);
+    {
+        TradeEngine engine(BookType::Ladder);
+        engine.OpenJournal(journalPath, JournalOptions{4, false});
+        engine.SetSelfTradePrevention(SelfTradePrevention::CancelResting);
+        engine.SetRiskLimits("T1", RiskLimits{10, 0, 0});
+        engine.ProcessOrder(engine.ParseInput("T1 S 5 100"));
+        engine.ProcessOrder(engine.ParseInput("T2 B 3 100"));
+        engine.WriteSnapshot(snapshotPath);
+        engine.ProcessOrder(engine.ParseInput("T3 B 1 90"));
+    }
+    for (const std::string& snapshot : {snapshotPath, std::string()})
+    {
+        TradeEngine engine(BookType::Ladder);
+        engine.Restore(snapshot, journalPath);
+        bool limited = false;
+        try
+        {
+            engine.ProcessOrder(engine.ParseInput("T1 B 11 90"));
+        }
+        catch (const std::invalid_argument&)
+        {
+            limited = true;
+        }
+        engine.ProcessOrder(engine.ParseInput("T1 B 2 100"));
+        if (!limited || engine.GetPosition("T1") != -3 ||
+            !engine.GetSellOrders().empty())
+        {
+            std::cerr << "JournalRestore: Failed - Settings not restored\n";
+            return TestResult::FAILED;
+        }
+    }
+
+    std::filesystem::remove(journalPath);
+    std::filesystem::remove(snapshotPath);
+    std::cout << "JournalRestore: Snapshot and journal tail - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testNoAllocationAfterWarmUp()
+{
+    std::vector<std::string> lines;
+    std::uint64_t state = 11;
+    for (int i = 0; i < 2000; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        lines.push_back("T" + std::to_string((state >> 33) % 50) +
+                        ((state >> 20) & 1 ? " B " : " S ") +
+                        std::to_string((state >> 40) % 20 + 1) + " " +
+                        std::to_string(990 + (state >> 24) % 21));
+    }
+    std::vector<OrderView> orders(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i)
+    {
+        static_cast<void>(ParseOrder(lines[i], orders[i]));
+    }
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        engine.SetTradeHistory(false);
+        std::size_t output = 0;
+        engine.SetTradeSink([&output](const std::string_view trades)
+                            { output += trades.size(); });
+        engine.SetFillSink([&output](const Fill*, const std::size_t count)
+                           { output += count; });
+        engine.Preallocate(4096, 1024);
+
+        std::vector<OrderId> ids(orders.size());
+        const auto run = [&]()
+        {
+            for (std::size_t i = 0; i < orders.size(); ++i)
+            {
+                ids[i] = engine.ProcessOrder(orders[i]);
+                if (i % 5 == 4)
+                {
+                    engine.Cancel(ids[i - 3]);
+                }
+                if (i % 7 == 6)
+                {
+                    engine.Amend(ids[i - 2], 3, orders[i - 2].price + 1);
+                }
+            }
+        };
+
+        run();
+        const std::uint64_t before = globalAllocations.load();
+        run();
+        const std::uint64_t allocations = globalAllocations.load() - before;
+        if (allocations != 0 || output == 0)
+        {
+            std::cerr << "NoAllocation: Failed - " << allocations
+                      << " allocations after warm-up\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "NoAllocation: Warmed-up order path - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testLatencyHistogram()
+{
+    // Every value lands in a bucket whose upper bound is within 1/16.
+    for (std::uint64_t value = 0; value < 100000; value += 7)
+    {
+        const std::uint64_t high =
+            LatencyHistogram::HighestInBucket(LatencyHistogram::BucketOf(value));
+        if (high < value || high - value > value / 16)
+        {
+            std::cerr << "LatencyHistogram: Failed - " << value
+                      << " reported as " << high << "\n";
+            return TestResult::FAILED;
+        }
+    }
+    if (LatencyHistogram::BucketOf(~std::uint64_t{0}) !=
+        LatencyHistogram::kBuckets - 1)
+    {
+        std::cerr << "LatencyHistogram: Failed - top bucket\n";
+        return TestResult::FAILED;
+    }
+
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.Record(value * 100);
+    }
+    LatencyHistogram::Counts counts{};
+    histogram.AddTo(counts);
+    const LatencySummary summary = LatencyHistogram::Summarize(counts, 2.0);
+    const auto near = [](const std::uint64_t actual,
+                         const std::uint64_t expected)
+    { return actual >= expected && actual - expected <= expected / 16; };
+    if (summary.count != 1000 || !near(summary.p50, 25000) ||
+        !near(summary.p90, 45000) || !near(summary.p99, 49500) ||
+        !near(summary.max, 50000))
+    {
+        std::cerr << "LatencyHistogram: Failed - p50 " << summary.p50
+                  << ", p90 " << summary.p90 << ", p99 " << summary.p99
+                  << ", max " << summary.max << "\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "LatencyHistogram: Buckets and percentiles - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testEngineStats()
+{
+    TradeEngine engine(BookType::Ladder);
+    engine.ProcessOrder(TradeOrder{"T1", 'S', 2, 101});
+    engine.ProcessOrder(TradeOrder{"T2", 'S', 2, 102});
+    engine.ProcessOrder(TradeOrder{"T3", 'S', 2, 102});
+    engine.ProcessOrder(TradeOrder{"T4", 'B', 1, 99});
+    engine.ProcessOrder(TradeOrder{"T5", 'B', 5, 102});
+    try
+    {
+        static_cast<void>(engine.ParseInput("T6 X 1 100"));
+    }
+    catch (const std::invalid_argument&)
+    {
+    }
+    // Filled from another thread to check that stats are merged.
+    std::thread([&engine]()
+                { engine.ProcessOrder(TradeOrder{"T6", 'S', 1, 110}); })
+        .join();
+
+    const EngineStats stats = engine.GetStats();
+    if constexpr (!kStatsEnabled)
+    {
+        std::cout << "EngineStats: Compiled out - Passed\n";
+        return TestResult::PASSED;
+    }
+
+    // T5 takes T1, T2 and 1 of T3 over two levels.
+    const auto stage = [&stats](const Stage which)
+    { return stats.stages[static_cast<std::size_t>(which)]; };
+    if (stats.orders != 6 || stats.fills != 3 || stats.levelsSwept != 2 ||
+        stats.rejects != 1 || stats.restingOrders != 3 ||
+        stats.bidLevels != 1 || stats.askLevels != 2 ||
+        stage(Stage::Parse).count != 1 ||
+        stage(Stage::ProcessOrder).count != 6 ||
+        stage(Stage::Match).count != 6 ||
+        stage(Stage::CollectTrades).count != 6 ||
+        stage(Stage::ProcessOrder).max == 0)
+    {
+        std::ostringstream text;
+        PrintStats(text, stats);
+        std::cerr << "EngineStats: Failed -\n" << text.str();
+        return TestResult::FAILED;
+    }
+
+    // A thread alternating between engines, like a shard serving several
+    // books, counts every order in its own engine.
+    TradeEngine bookA(BookType::Ladder);
+    TradeEngine bookB(BookType::Ladder);
+    for (std::uint64_t i = 0; i < 10; ++i)
+    {
+        bookA.ProcessOrder(TradeOrder{"T1", 'B', 1, 100 + i});
+        if (i % 2 == 0)
+        {
+            bookB.ProcessOrder(TradeOrder{"T2", 'S', 1, 200 + i});
+        }
+    }
+    if (bookA.GetStats().orders != 10 || bookB.GetStats().orders != 5)
+    {
+        std::cerr << "EngineStats: Failed - Interleaved engines mixed up\n";
+        return TestResult::FAILED;
+    }
+
+    const std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "engine_stats_test.txt";
+    std::filesystem::remove(path);
+    engine.DumpStatsEvery(std::chrono::milliseconds(5), path.string());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    engine.DumpStatsEvery(std::chrono::milliseconds(0));
+    std::ifstream dump(path);
+    std::string first;
+    std::getline(dump, first);
+    std::filesystem::remove(path);
+    if (first.rfind("orders 6, fills 3", 0) != 0)
+    {
+        std::cerr << "EngineStats: Failed - dump \"" << first << "\"\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "EngineStats: Counters, probes and dump - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testProcessOrdersBatch()
+{
+    std::vector<TradeOrder> orders;
+    std::uint64_t state = 5;
+    for (int i = 0; i < 500; ++i)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Every 50th order has an unknown side and is rejected.
+        const char side = i % 50 == 49 ? 'X' : ((state >> 20) & 1 ? 'B' : 'S');
+        orders.push_back(TradeOrder{"T" + std::to_string((state >> 33) % 20),
+                                    side, (state >> 40) % 20 + 1,
+                                    990 + (state >> 24) % 21});
+    }
+
+    const auto describe = [](const ordersMap& book)
+    {
+        std::string text;
+        for (const auto& [price, level] : book)
+        {
+            for (const TradeOrder& order : level)
+            {
+                text += order.identifier + " " + std::to_string(order.quantity) +
+                        "@" + std::to_string(price) + " ";
+            }
+        }
+        return text;
+    };
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine single(bookType);
+        std::vector<OrderId> ids;
+        for (const TradeOrder& order : orders)
+        {
+            try
+            {
+                ids.push_back(single.ProcessOrder(order));
+            }
+            catch (const std::invalid_argument&)
+            {
+                ids.push_back(0);
+            }
+        }
+
+        TradeEngine batched(bookType);
+        std::vector<OrderResult> results(orders.size());
+        std::size_t accepted = 0;
+        for (std::size_t offset = 0; offset < orders.size(); offset += 64)
+        {
+            const std::size_t count = std::min<std::size_t>(
+                64, orders.size() - offset);
+            accepted += batched.ProcessOrders(
+                Span<const TradeOrder>(orders).subspan(offset, count),
+                Span<OrderResult>(results).subspan(offset, count));
+        }
+
+        bool sameIds = accepted == orders.size() - 10;
+        for (std::size_t i = 0; i < orders.size(); ++i)
+        {
+            sameIds = sameIds && results[i].orderId == ids[i] &&
+                      results[i].rejected == (ids[i] == 0) &&
+                      results[i].reason == (ids[i] == 0
+                                                ? RejectReason::UnknownSide
+                                                : RejectReason::None);
+        }
+        if (!sameIds || batched.GetTrades() != single.GetTrades() ||
+            describe(batched.GetBuyOrders()) !=
+                describe(single.GetBuyOrders()) ||
+            describe(batched.GetSellOrders()) !=
+                describe(single.GetSellOrders()))
+        {
+            std::cerr << "ProcessOrdersBatch: Failed - batch differs from "
+                         "single orders\n";
+            return TestResult::FAILED;
+        }
+    }
+
+    // A buy for 5 sweeps both resting sells and rests the remaining 2.
+    TradeEngine engine;
+    const std::vector<TradeOrder> sweep = {{"T1", 'S', 2, 100},
+                                           {"T2", 'S', 1, 101},
+                                           {"T3", 'B', 5, 101}};
+    std::array<OrderResult, 3> results{};
+    if (engine.ProcessOrders(sweep, results) != 3 ||
+        results[2].filledQuantity != 3 || results[2].fills != 2 ||
+        results[0].fills != 0 || results[2].orderId != 3)
+    {
+        std::cerr << "ProcessOrdersBatch: Failed - fill results\n";
+        return TestResult::FAILED;
+    }
+    try
+    {
+        engine.ProcessOrders(sweep, Span<OrderResult>(results).subspan(0, 2));
+        std::cerr << "ProcessOrdersBatch: Failed - short results accepted\n";
+        return TestResult::FAILED;
+    }
+    catch (const std::invalid_argument&)
+    {
+    }
+    std::cout << "ProcessOrdersBatch: Batch matches single orders - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testOrderTypes()
+{
+    const auto fail = [](const std::string& what)
+    {
+        std::cerr << "OrderTypes: Failed - " << what << "\n";
+        return TestResult::FAILED;
+    };
+
+    const std::pair<std::string, OrderType> lines[] = {
+        {"T1 B 5 MKT", OrderType::Market},
+        {"T1 S 5 100 IOC", OrderType::ImmediateOrCancel},
+        {"T1 B 5 100 FOK", OrderType::FillOrKill},
+        {"T1 B 5 100 POST", OrderType::PostOnly},
+        {"T1 B 5 100", OrderType::Limit}};
+    for (const auto& [line, type] : lines)
+    {
+        OrderView order{};
+        if (ParseOrder(line, order) != ParseStatus::Ok || order.type != type)
+        {
+            return fail("parsing '" + line + "'");
+        }
+    }
+    OrderView ignored{};
+    if (ParseOrder("T1 B 5 100 GTC", ignored) != ParseStatus::TrailingInput ||
+        ParseOrder("T1 B 5 MKT 100", ignored) != ParseStatus::TrailingInput)
+    {
+        return fail("unknown order type accepted");
+    }
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        engine.SetSnapshotDepth(4);
+        engine.ProcessOrder(TradeOrder{"T1", 'S', 3, 101});
+        engine.ProcessOrder(TradeOrder{"T2", 'S', 4, 102});
+
+        // Takes all of 101 and drops the rest instead of resting at 101.
+        engine.ProcessOrder(
+            TradeOrder{"T3", 'B', 5, 101, OrderType::ImmediateOrCancel});
+        // Only 4 are offered up to 102, so nothing trades.
+        engine.ProcessOrder(
+            TradeOrder{"T4", 'B', 10, 102, OrderType::FillOrKill});
+        if (!engine.GetBuyOrders().empty() ||
+            engine.GetBookSnapshot().asks[0].quantity != 4)
+        {
+            return fail("immediate-or-cancel or fill-or-kill rested");
+        }
+        engine.ProcessOrder(
+            TradeOrder{"T4", 'B', 4, 102, OrderType::FillOrKill});
+
+        engine.ProcessOrder(TradeOrder{"T5", 'S', 5, 105});
+        try
+        {
+            engine.ProcessOrder(
+                TradeOrder{"T6", 'B', 3, 105, OrderType::PostOnly});
+            return fail("crossing post-only order accepted");
+        }
+        catch (const std::invalid_argument&)
+        {
+        }
+        engine.ProcessOrder(TradeOrder{"T6", 'B', 3, 104, OrderType::PostOnly});
+        engine.ProcessOrder(TradeOrder{"T7", 'B', 2, 99});
+        engine.ProcessOrder(TradeOrder{"T8", 'S', 4, 0, OrderType::Market});
+        engine.ProcessOrder(TradeOrder{"T9", 'B', 10, 0, OrderType::Market});
+
+        const std::vector<std::string> expected = {
+            "T1-3@101 T3+3@101", "T2-4@102 T4+4@102",
+            "T6+3@104 T7+1@99 T8-1@99 T8-3@104", "T5-5@105 T9+5@105"};
+        const BookSnapshot depth = engine.GetBookSnapshot();
+        if (engine.GetTrades() != expected || depth.askLevels != 0 ||
+            depth.bidLevels != 1 || depth.bids[0].price != 99 ||
+            depth.bids[0].quantity != 1 || depth.bids[0].orders != 1)
+        {
+            return fail("trades or resting depth");
+        }
+    }
+    std::cout << "OrderTypes: Market, IOC, FOK and post-only - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testLevelTotals()
+{
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        engine.SetSnapshotDepth(2);
+        const OrderId first = engine.ProcessOrder(TradeOrder{"T1", 'B', 5, 100});
+        const OrderId second =
+            engine.ProcessOrder(TradeOrder{"T2", 'B', 7, 100});
+        engine.ProcessOrder(TradeOrder{"T3", 'B', 1, 99});
+        engine.ProcessOrder(TradeOrder{"T4", 'S', 2, 100});
+        engine.Amend(second, 4, 100);
+        engine.Cancel(first);
+
+        // 3 of T1 were left after the sell, then it was cancelled.
+        const BookSnapshot depth = engine.GetBookSnapshot();
+        if (depth.bidLevels != 2 || depth.bids[0].quantity != 4 ||
+            depth.bids[0].orders != 1 || depth.bids[1].quantity != 1)
+        {
+            std::cerr << "LevelTotals: Failed - " << depth.bids[0].quantity
+                      << " at the best bid\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "LevelTotals: Fill, amend and cancel - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testMarketDataFeed()
+{
+    // Aggregates the engine's own view of one side for comparison.
+    const auto levelsOf = [](const ordersMap& book)
+    {
+        DepthBook::Levels levels;
+        for (const auto& [price, orders] : book)
+        {
+            DepthLevel& level = levels[price];
+            level.price = price;
+            level.orders = orders.size();
+            for (const TradeOrder& order : orders)
+            {
+                level.quantity += order.quantity;
+            }
+        }
+        return levels;
+    };
+    const auto same = [](const DepthBook::Levels& lhs,
+                         const DepthBook::Levels& rhs)
+    {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                          [](const auto& a, const auto& b)
+                          {
+                              return a.second.price == b.second.price &&
+                                     a.second.quantity == b.second.quantity &&
+                                     a.second.orders == b.second.orders;
+                          });
+    };
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        const std::string feed = "trade_engine_test_feed";
+        TradeEngine engine(bookType);
+        engine.ProcessOrder(TradeOrder{"T0", 'B', 5, 995});
+        engine.OpenMarketData(feed, MarketDataOptions{256, 1024, 64});
+
+        try
+        {
+            MarketDataPublisher second(feed, MarketDataOptions{});
+            std::cerr << "MarketDataFeed: Failed - live feed replaced\n";
+            return TestResult::FAILED;
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+
+        MarketDataReader live(feed);
+        DepthBook liveBook;
+        live.Sync(liveBook);
+        MarketDataReader late(feed);
+        DepthBook lateBook;
+
+        std::vector<OrderId> ids;
+        std::uint64_t state = 3;
+        for (int i = 0; i < 3000; ++i)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            if (i % 4 == 3 && !ids.empty())
+            {
+                engine.Cancel(ids[(state >> 33) % ids.size()]);
+            }
+            else if (i % 9 == 8 && !ids.empty())
+            {
+                engine.Amend(ids[(state >> 33) % ids.size()],
+                             (state >> 45) % 10 + 1,
+                             990 + (state >> 24) % 21);
+            }
+            else
+            {
+                ids.push_back(engine.ProcessOrder(TradeOrder{
+                    "T" + std::to_string((state >> 33) % 20),
+                    (state >> 20) & 1 ? 'B' : 'S', (state >> 40) % 20 + 1,
+                    990 + (state >> 24) % 21}));
+            }
+            if (live.Poll(liveBook) != ReadStatus::Empty)
+            {
+                std::cerr << "MarketDataFeed: Failed - live reader lapped\n";
+                return TestResult::FAILED;
+            }
+        }
+
+        // The late reader has missed far more than the ring holds.
+        MarketDataUpdate update{};
+        if (late.Next(update) != ReadStatus::Lapped)
+        {
+            std::cerr << "MarketDataFeed: Failed - lapping not detected\n";
+            return TestResult::FAILED;
+        }
+        late.Sync(lateBook);
+        if (late.Poll(lateBook) != ReadStatus::Empty)
+        {
+            std::cerr << "MarketDataFeed: Failed - snapshot too old\n";
+            return TestResult::FAILED;
+        }
+
+        const DepthBook::Levels bids = levelsOf(engine.GetBuyOrders());
+        const DepthBook::Levels asks = levelsOf(engine.GetSellOrders());
+        for (const DepthBook* book : {&liveBook, &lateBook})
+        {
+            if (!same(book->Bids(), bids) || !same(book->Asks(), asks) ||
+                book->BestBid().price != bids.rbegin()->first ||
+                book->BestBid().quantity != bids.rbegin()->second.quantity ||
+                book->BestAsk().price != asks.begin()->first)
+            {
+                std::cerr << "MarketDataFeed: Failed - rebuilt depth differs "
+                             "from the book\n";
+                return TestResult::FAILED;
+            }
+        }
+        if (liveBook.Sequence() != lateBook.Sequence())
+        {
+            std::cerr << "MarketDataFeed: Failed - readers disagree\n";
+            return TestResult::FAILED;
+        }
+    }
+
+    try
+    {
+        MarketDataReader gone("trade_engine_test_feed");
+        std::cerr << "MarketDataFeed: Failed - feed outlived engine\n";
+        return TestResult::FAILED;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    std::cout << "MarketDataFeed: Live and late readers rebuild depth - "
+                 "Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testMarketDataSweep()
+{
+    // One buy clears more ask levels than the ring holds.
+    const std::string feed = "trade_engine_test_sweep";
+    TradeEngine engine;
+    engine.OpenMarketData(feed, MarketDataOptions{256, 1024, 64});
+    MarketDataReader reader(feed);
+    DepthBook book;
+    reader.Sync(book);
+    for (std::uint64_t price = 1001; price < 1300; ++price)
+    {
+        engine.ProcessOrder(TradeOrder{"T1", 'S', 1, price});
+        if (reader.Poll(book) != ReadStatus::Empty)
+        {
+            std::cerr << "MarketDataSweep: Failed - reader lapped while "
+                         "the book was built\n";
+            return TestResult::FAILED;
+        }
+    }
+    // The reader is behind by this order when the sweep comes.
+    engine.ProcessOrder(TradeOrder{"T1", 'S', 1, 1300});
+
+    engine.ProcessOrder(TradeOrder{"T2", 'B', 305, 1300});
+    if (reader.Poll(book) != ReadStatus::Lapped)
+    {
+        std::cerr << "MarketDataSweep: Failed - sweep not reported\n";
+        return TestResult::FAILED;
+    }
+    // The sweep did not overwrite the updates before it.
+    if (book.Asks().size() != 300)
+    {
+        std::cerr << "MarketDataSweep: Failed - " << book.Asks().size()
+                  << " ask levels read before the sweep\n";
+        return TestResult::FAILED;
+    }
+    // The snapshot is already there, so one Sync catches up.
+    reader.Sync(book);
+    if (reader.Poll(book) != ReadStatus::Empty || !book.Asks().empty() ||
+        book.Bids().size() != 1 || book.BestBid().price != 1300 ||
+        book.BestBid().quantity != 5)
+    {
+        std::cerr << "MarketDataSweep: Failed - snapshot after the sweep "
+                     "differs from the book\n";
+        return TestResult::FAILED;
+    }
+
+    // Updates follow the snapshot again.
+    engine.ProcessOrder(TradeOrder{"T1", 'S', 2, 1302});
+    if (reader.Poll(book) != ReadStatus::Empty || book.Asks().size() != 1 ||
+        book.BestAsk().price != 1302 || book.BestAsk().quantity != 2)
+    {
+        std::cerr << "MarketDataSweep: Failed - updates after the snapshot "
+                     "lost\n";
+        return TestResult::FAILED;
+    }
+    std::cout << "MarketDataSweep: Snapshot replaces an overrunning sweep - "
+                 "Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testStartPipeline()
+{
+    // Deterministic mix of crossing, resting, typed and malformed orders.
+    std::string input;
+    std::uint64_t state = 12345;
+    const auto next = [&state](const std::uint64_t bound)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % bound;
+    };
+    const char* const suffixes[] = {"", "", "", " IOC", " FOK", " POST"};
+    for (int i = 0; i < 3000; ++i)
+    {
+        if (i % 97 == 0)
+        {
+            input += "T1 B x 10\n\n";
+        }
+        input += "T" + std::to_string(next(20)) + (next(2) ? " B " : " S ") +
+                 std::to_string(1 + next(9)) + ' ' +
+                 std::to_string(95 + next(10)) + suffixes[next(6)] + '\n';
+    }
+
+    std::string expected;
+    std::uint64_t expectedRejects = 0;
+    {
+        TradeEngine engine;
+        engine.SetTradeHistory(false);
+        engine.SetTradeSink([&expected](std::string_view trades)
+                            { expected.append(trades).push_back('\n'); });
+        std::istringstream lines(input);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            OrderView order{};
+            const ParseStatus status = ParseOrder(line, order);
+            if (status == ParseStatus::Empty)
+            {
+                continue;
+            }
+            try
+            {
+                if (status != ParseStatus::Ok)
+                {
+                    throw std::invalid_argument("unparsable");
+                }
+                engine.ProcessOrder(order);
+            }
+            catch (const std::invalid_argument&)
+            {
+                ++expectedRejects;
+            }
+        }
+    }
+
+    const PipelineOptions configurations[] = {
+        {1, 1, WaitPolicy::Yield},
+        {7, 3, WaitPolicy::Sleep},
+        {64, 4, WaitPolicy::Spin},
+        {256, 64, WaitPolicy::Sleep}};
+    for (const PipelineOptions& options : configurations)
+    {
+        for (const bool withSink : {false, true})
+        {
+            TradeEngine engine;
+            engine.SetTradeHistory(false);
+            std::string streamed;
+            if (withSink)
+            {
+                engine.SetTradeSink([&streamed](std::string_view trades)
+                                    { streamed.append(trades).push_back('\n'); });
+            }
+            std::istringstream in(input);
+            std::ostringstream out;
+            std::ostringstream diagnostics;
+            std::streambuf* const previousIn = std::cin.rdbuf(in.rdbuf());
+            std::streambuf* const previousOut = std::cout.rdbuf(out.rdbuf());
+            std::streambuf* const previousErr =
+                std::cerr.rdbuf(diagnostics.rdbuf());
+            engine.Start(options);
+            std::cin.rdbuf(previousIn);
+            std::cout.rdbuf(previousOut);
+            std::cerr.rdbuf(previousErr);
+
+            const std::string& output = withSink ? streamed : out.str();
+            if (expected.empty() || output != expected ||
+                engine.GetRejectedLines() != expectedRejects)
+            {
+                std::cerr << "Start: Pipeline failed - Output differs for "
+                          << options.blockLines << " lines per block, "
+                          << options.blocks << " blocks" << std::endl;
+                return TestResult::FAILED;
+            }
+        }
+    }
+    std::cout << "Start: Pipelined output matches direct matching - Passed\n";
+    return TestResult::PASSED;
+}
+
+// Runs the kernel directly on one book layout: a buy for 12 up to 101
+// against asks 3@100 (id 1), 4@100 (id 2), 5@101 (id 3) and 9@102 (id 4).
+template <typename Book>
+bool kernelMatchesBuy(Book& asks)
+{
+    asks.Push(101, 0, 5, 3);
+    asks.Push(100, 0, 3, 1);
+    asks.Push(102, 0, 9, 4);
+    asks.Push(100, 0, 4, 2);
+
+    std::vector<std::array<std::uint64_t, 4>> fills;
+    const std::uint64_t open = MatchAgainst<BuySide>(
+        asks, 14, 101,
+        [&fills](const std::uint64_t price, const std::uint64_t quantity,
+                 const auto& resting)
+        {
+            fills.push_back(
+                {price, quantity, resting.orderId, resting.quantity});
+        });
+
+    const std::vector<std::array<std::uint64_t, 4>> expected = {
+        {100, 3, 1, 0}, {100, 4, 2, 0}, {101, 5, 3, 0}};
+    if (open != 2 || fills != expected || asks.BestPrice() != 102)
+    {
+        return false;
+    }
+
+    // A sell limited at 102 takes part of the remaining level and stops.
+    fills.clear();
+    Book bids('B');
+    bids.Push(102, 0, 9, 5);
+    bids.Push(99, 0, 1, 6);
+    return MatchAgainst<SellSide>(bids, 4, 100,
+                                  [&fills](const std::uint64_t price,
+                                           const std::uint64_t quantity,
+                                           const auto& resting)
+                                  {
+                                      fills.push_back({price, quantity,
+                                                       resting.orderId,
+                                                       resting.quantity});
+                                  }) == 0 &&
+           fills == std::vector<std::array<std::uint64_t, 4>>{{102, 4, 5, 5}} &&
+           bids.LevelAt(102).quantity == 5 && bids.LevelAt(99).orders == 1;
+}
+
+TestResult testMatchingKernel()
+{
+    TreeBook tree('S');
+    PriceLadder ladder('S');
+    if (!kernelMatchesBuy(tree) || !kernelMatchesBuy(ladder))
+    {
+        std::cerr << "MatchingKernel: Unexpected fills on a book layout\n";
+        return TestResult::FAILED;
+    }
+    static_assert(BuySide::Crosses(101, 100) && !BuySide::Crosses(100, 101) &&
+                      SellSide::Crosses(100, 101) &&
+                      !SellSide::Crosses(101, 100),
+                  "Side traits compare in opposite directions");
+    std::cout << "MatchingKernel: Tree and ladder instantiations - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testSelfTradePrevention()
+{
+    const auto fail = [](const std::string& what)
+    {
+        std::cerr << "SelfTradePrevention: Failed - " << what << "\n";
+        return TestResult::FAILED;
+    };
+
+    // T1 rests 3@100 ahead of T2's 4@100, then buys 5 at 100.
+    struct Case
+    {
+        SelfTradePrevention mode;
+        const char* trades;
+        std::uint64_t restingAsk;
+        std::uint64_t restingBid;
+    };
+    const Case cases[] = {
+        {SelfTradePrevention::None, "T1+5@100 T1-3@100 T2-2@100", 2, 0},
+        {SelfTradePrevention::CancelResting, "T1+4@100 T2-4@100", 0, 1},
+        {SelfTradePrevention::CancelAggressor, "", 7, 0},
+        {SelfTradePrevention::DecrementBoth, "T1+2@100 T2-2@100", 2, 0}};
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        for (const Case& test : cases)
+        {
+            TradeEngine engine(bookType);
+            engine.SetSelfTradePrevention(test.mode);
+            engine.ProcessOrder(TradeOrder{"T1", 'S', 3, 100});
+            engine.ProcessOrder(TradeOrder{"T2", 'S', 4, 100});
+            engine.ProcessOrder(TradeOrder{"T1", 'B', 5, 100});
+
+            const std::vector<std::string> trades = engine.GetTrades();
+            const std::string traded = trades.empty() ? "" : trades.back();
+            auto sellOrders = engine.GetSellOrders();
+            auto buyOrders = engine.GetBuyOrders();
+            std::uint64_t asks = 0;
+            for (const TradeOrder& order : sellOrders[100])
+            {
+                asks += order.quantity;
+            }
+            std::uint64_t bids = 0;
+            for (const TradeOrder& order : buyOrders[100])
+            {
+                bids += order.quantity;
+            }
+            if (traded != test.trades || asks != test.restingAsk ||
+                bids != test.restingBid)
+            {
+                return fail("mode " +
+                            std::to_string(static_cast<int>(test.mode)) +
+                            " traded '" + traded + "', left " +
+                            std::to_string(asks) + " asked and " +
+                            std::to_string(bids) + " bid");
+            }
+        }
+
+        // A fill-or-kill order that would reach its own trader is killed
+        // even though the book holds enough.
+        TradeEngine engine(bookType);
+        engine.SetSelfTradePrevention(SelfTradePrevention::CancelResting);
+        engine.ProcessOrder(TradeOrder{"T2", 'S', 2, 100});
+        engine.ProcessOrder(TradeOrder{"T1", 'S', 3, 100});
+        engine.ProcessOrder(TradeOrder{"T2", 'S', 9, 101});
+        engine.ProcessOrder(
+            TradeOrder{"T1", 'B', 4, 101, OrderType::FillOrKill});
+        engine.ProcessOrder(
+            TradeOrder{"T1", 'B', 2, 101, OrderType::FillOrKill});
+        if (engine.GetTrades() !=
+            std::vector<std::string>{"T1+2@100 T2-2@100"})
+        {
+            return fail("fill-or-kill reaching its own order");
+        }
+    }
+    std::cout << "SelfTradePrevention: All modes - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testRiskLimits()
+{
+    const auto fail = [](const std::string& what)
+    {
+        std::cerr << "RiskLimits: Failed - " << what << "\n";
+        return TestResult::FAILED;
+    };
+    const auto rejected = [](TradeEngine& engine, const TradeOrder& order)
+    {
+        try
+        {
+            engine.ProcessOrder(order);
+        }
+        catch (const std::invalid_argument&)
+        {
+            return true;
+        }
+        return false;
+    };
+
+    for (const BookType bookType : {BookType::Tree, BookType::Ladder})
+    {
+        TradeEngine engine(bookType);
+        // Resting before the checks start still counts as open notional.
+        const OrderId early = engine.ProcessOrder(TradeOrder{"T1", 'B', 5, 10});
+        engine.SetRiskLimits(RiskLimits{100, 0, 0});
+        engine.SetRiskLimits("T1", RiskLimits{20, 30, 150});
+
+        if (!rejected(engine, TradeOrder{"T2", 'B', 101, 10}) ||
+            rejected(engine, TradeOrder{"T2", 'B', 100, 1}))
+        {
+            return fail("default order quantity limit");
+        }
+        if (!rejected(engine, TradeOrder{"T1", 'B', 21, 1}))
+        {
+            return fail("trader order quantity limit");
+        }
+        // 50 open, so 11@10 would make 160.
+        if (!rejected(engine, TradeOrder{"T1", 'B', 11, 10}) ||
+            rejected(engine, TradeOrder{"T1", 'B', 10, 10}))
+        {
+            return fail("open notional limit");
+        }
+        // Immediate-or-cancel orders never rest, so only position counts.
+        if (rejected(engine, TradeOrder{"T1", 'B', 15, 10,
+                                        OrderType::ImmediateOrCancel}))
+        {
+            return fail("open notional applied to an IOC order");
+        }
+        // Cancelling frees notional.
+        engine.Cancel(early);
+        if (rejected(engine, TradeOrder{"T1", 'B', 5, 10}))
+        {
+            return fail("cancel did not free open notional");
+        }
+
+        // Position: T3 takes T1's 15 resting at 10, then T1 may only buy 15
+        // more but may sell again.
+        engine.ProcessOrder(TradeOrder{"T3", 'S', 15, 9});
+        if (engine.GetPosition("T1") != 15 || engine.GetPosition("T3") != -15)
+        {
+            return fail("positions after fills, T1 at " +
+                        std::to_string(engine.GetPosition("T1")));
+        }
+        if (!rejected(engine, TradeOrder{"T1", 'B', 16, 1}) ||
+            rejected(engine, TradeOrder{"T1", 'B', 15, 1,
+                                        OrderType::ImmediateOrCancel}) ||
+            rejected(engine, TradeOrder{"T1", 'S', 20, 1000,
+                                        OrderType::ImmediateOrCancel}))
+        {
+            return fail("position limit");
+        }
+
+        // Amending up is checked like a new order.
+        const OrderId resting = engine.ProcessOrder(TradeOrder{"T1", 'S', 1, 50});
+        bool amendRejected = false;
+        try
+        {
+            engine.Amend(resting, 4, 50);
+        }
+        catch (const std::invalid_argument&)
+        {
+            amendRejected = true;
+        }
+        if (!amendRejected || !engine.Amend(resting, 2, 50))
+        {
+            return fail("amend past the open notional limit");
+        }
+    }
+    std::cout << "RiskLimits: Quantity, position and notional - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testOccupancyBitmap()
+{
+    // Sizes around word and level boundaries, including a four-level one.
+    for (const std::size_t size : {std::size_t{1}, std::size_t{63},
+                                   std::size_t{64}, std::size_t{65},
+                                   std::size_t{4096}, std::size_t{4097},
+                                   std::size_t{262145}})
+    {
+        OccupancyBitmap bitmap(size);
+        std::set<std::size_t> reference;
+        std::uint64_t state = size;
+        const auto check = [&](const std::size_t position)
+        {
+            const auto next = reference.lower_bound(position);
+            const std::size_t expectedNext =
+                next == reference.end() ? OccupancyBitmap::kNone : *next;
+            const auto after = reference.upper_bound(position);
+            const std::size_t expectedPrev =
+                after == reference.begin() ? OccupancyBitmap::kNone
+                                           : *std::prev(after);
+            if (bitmap.NextFrom(position) != expectedNext ||
+                bitmap.PrevFrom(position) != expectedPrev ||
+                bitmap.Empty() != reference.empty())
+            {
+                std::cerr << "OccupancyBitmap: Mismatch at " << position
+                          << " of " << size << "\n";
+                return false;
+            }
+            return true;
+        };
+
+        for (int step = 0; step < 20000; ++step)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            // Clustered positions leave long empty runs for the search.
+            std::size_t position = (state >> 33) % size;
+            if ((state >> 12) % 4 == 0)
+            {
+                position = position / 1024 * 1024;
+            }
+            if ((state >> 20) % 3 == 0)
+            {
+                bitmap.Clear(position);
+                reference.erase(position);
+            }
+            else
+            {
+                bitmap.Set(position);
+                reference.insert(position);
+            }
+            if (bitmap.Test(position) != (reference.count(position) == 1) ||
+                !check((state >> 40) % size))
+            {
+                return TestResult::FAILED;
+            }
+        }
+
+        // Drain from both ends, as the best bid and ask cursors do.
+        while (!reference.empty())
+        {
+            if (bitmap.First() != *reference.begin() ||
+                bitmap.Last() != *reference.rbegin())
+            {
+                std::cerr << "OccupancyBitmap: Drain mismatch at " << size
+                          << "\n";
+                return TestResult::FAILED;
+            }
+            bitmap.Clear(*reference.begin());
+            reference.erase(reference.begin());
+            if (!check(0) || !check(size - 1))
+            {
+                return TestResult::FAILED;
+            }
+        }
+        if (bitmap.First() != OccupancyBitmap::kNone ||
+            bitmap.NextFrom(size) != OccupancyBitmap::kNone)
+        {
+            std::cerr << "OccupancyBitmap: Not empty after drain\n";
+            return TestResult::FAILED;
+        }
+    }
+    std::cout << "OccupancyBitmap: Random operations - Passed\n";
+    return TestResult::PASSED;
+}
+
+#ifdef __linux__
+// Blocking client end of a gateway session, with a read timeout so that a
+// missing response fails the test instead of hanging it.
+class GatewayClient final
+{
+   public:
+    explicit GatewayClient(const std::string& path)
+        : m_fd(::socket(AF_UNIX, SOCK_STREAM, 0))
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(),
+                     sizeof(address.sun_path) - 1);
+        const timeval timeout{2, 0};
+        ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        m_connected = ::connect(m_fd, reinterpret_cast<sockaddr*>(&address),
+                                sizeof(address)) == 0;
+    }
+
+    GatewayClient(const GatewayClient&) = delete;
+    GatewayClient& operator=(const GatewayClient&) = delete;
+
+    ~GatewayClient() { ::close(m_fd); }
+
+    [[nodiscard]] bool Connected() const noexcept { return m_connected; }
+
+    void Send(const std::string& data)
+    {
+        static_cast<void>(::send(m_fd, data.data(), data.size(), 0));
+    }
+
+    // Reads exactly size bytes, fewer on timeout.
+    std::string Receive(const std::size_t size)
+    {
+        std::string data(size, '\0');
+        std::size_t received = 0;
+        while (received < size)
+        {
+            const ssize_t count =
+                ::recv(m_fd, &data[received], size - received, 0);
+            if (count <= 0)
+            {
+                break;
+            }
+            received += static_cast<std::size_t>(count);
+        }
+        data.resize(received);
+        return data;
+    }
+
+   private:
+    int m_fd;
+    bool m_connected = false;
+};
+
+TestResult testOrderGateway()
+{
+    const auto fail = [](const std::string& what)
+    {
+        std::cerr << "OrderGateway: Failed - " << what << "\n";
+        return TestResult::FAILED;
+    };
+
+    // Unique per process and run, so parallel or leftover runs never meet.
+    const std::string path =
+        (std::filesystem::temp_directory_path() /
+         ("order_gateway_test." + std::to_string(::getpid()) + "." +
+          std::to_string(std::chrono::steady_clock::now()
+                             .time_since_epoch()
+                             .count()) +
+          ".sock"))
+            .string();
+    TradeEngine engine;
+    GatewayOptions options;
+    options.unixPath = path;
+    OrderGateway gateway(engine, options);
+    std::thread loop([&gateway] { gateway.Run(); });
+    const auto stop = [&]
+    {
+        gateway.Stop();
+        loop.join();
+    };
+
+    GatewayClient text(path);
+    GatewayClient binary(path);
+    if (!text.Connected() || !binary.Connected())
+    {
+        stop();
+        return fail("cannot connect");
+    }
+
+    // A text order that rests.
+    text.Send("T1 S 5 100\n");
+    const std::string first = "OK 1 0\n";
+    if (text.Receive(first.size()) != first)
+    {
+        stop();
+        return fail("text acknowledgement");
+    }
+
+    // A binary session trades with it: its fill, then its acknowledgement,
+    // while the resting fill goes to the text session.
+    std::string login(kGatewayBinaryMagic, sizeof(kGatewayBinaryMagic));
+    const std::uint32_t length = 2;
+    login.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    login += "T2";
+    char message[kOrderMessageSize];
+    EncodeOrder(OrderMessage{0, 100, 3, 0, 'B', OrderType::Limit, {}},
+                message);
+    binary.Send(login + std::string(message, sizeof(message)));
+    const std::string reports = binary.Receive(2 * kExecutionReportSize);
+    if (reports.size() != 2 * kExecutionReportSize)
+    {
+        stop();
+        return fail("binary reports missing");
+    }
+    const ExecutionReport fill = DecodeReport(reports.data());
+    const ExecutionReport done =
+        DecodeReport(reports.data() + kExecutionReportSize);
+    if (fill.orderId != 2 || fill.quantity != 3 || fill.price != 100 ||
+        fill.liquidity != 'A' || done.liquidity != kReportAccepted ||
+        done.orderId != 2 || done.quantity != 3)
+    {
+        stop();
+        return fail("binary fill and acknowledgement");
+    }
+    const std::string restingFill = "FILL 1 S 3@100 P\n";
+    if (text.Receive(restingFill.size()) != restingFill)
+    {
+        stop();
+        return fail("resting fill routed to its session");
+    }
+
+    // Bad lines and rejected orders are answered in order.
+    text.Send("T1 X 1 1\nT1 B 1 200 POST\r\nT1 S 1 101\n");
+    const std::string answers =
+        "REJ invalid side\nREJ post-only order would trade\nOK 3 0\n";
+    if (text.Receive(answers.size()) != answers)
+    {
+        stop();
+        return fail("rejections");
+    }
+
+    // A batch the journal cannot record fails on its own and the gateway
+    // keeps serving.
+    engine.OpenJournal("/dev/full", JournalOptions{2, false});
+    text.Send("T3 S 1 150\n");
+    const std::string failure = "REJ engine failure\n";
+    if (text.Receive(failure.size()) != failure)
+    {
+        stop();
+        return fail("journal failure");
+    }
+    text.Send("T1 Q 1 1\n");
+    const std::string after = "REJ invalid side\n";
+    if (text.Receive(after.size()) != after)
+    {
+        stop();
+        return fail("batch after a journal failure");
+    }
+    stop();
+
+    std::cout << "OrderGateway: Text and binary sessions - Passed\n";
+    return TestResult::PASSED;
+}
+#endif
+
+TestResult testFillStream()
+{
+    const auto fail = [](const char* reason)
+    {
+        std::cerr << "FillStream: Failed - " << reason << "\n";
+        return TestResult::FAILED;
+    };
+
+    TradeEngine engine(BookType::Ladder);
+    std::vector<Fill> fills;
+    std::vector<ExecutionReport> reports;
+    std::vector<std::string> order;
+    engine.SetFillSink(
+        [&](const Fill* data, const std::size_t count)
+        {
+            fills.insert(fills.end(), data, data + count);
+            order.push_back("fills");
+        });
+    engine.SetReportSink(
+        [&](const ExecutionReport* data, const std::size_t count)
+        {
+            reports.insert(reports.end(), data, data + count);
+            order.push_back("reports");
+        });
+    engine.SetTradeSink([&order](const std::string_view)
+                        { order.push_back("trades"); });
+
+    const OrderId first = engine.ProcessOrder(engine.ParseInput("T1 S 3 100"));
+    const OrderId second = engine.ProcessOrder(engine.ParseInput("T2 S 4 101"));
+    const OrderId third = engine.ProcessOrder(engine.ParseInput("T3 B 5 101"));
+    if (fills.size() != 2 || order.size() != 3 || order[0] != "fills" ||
+        order[1] != "reports" || order[2] != "trades")
+    {
+        return fail("One order should reach every sink once, fills first");
+    }
+    const Fill& sweep = fills[0];
+    const Fill& partial = fills[1];
+    if (sweep.sequence != 1 || sweep.aggressorOrderId != third ||
+        sweep.restingOrderId != first || sweep.price != 100 ||
+        sweep.quantity != 3 || sweep.restingRemaining != 0 ||
+        sweep.aggressorSide != 'B' ||
+        sweep.aggressorTrader != engine.RegisterTrader("T3") ||
+        sweep.restingTrader != engine.RegisterTrader("T1"))
+    {
+        return fail("First fill does not pair T3 with T1's order");
+    }
+    if (partial.sequence != 2 || partial.restingOrderId != second ||
+        partial.price != 101 || partial.quantity != 2 ||
+        partial.restingRemaining != 2)
+    {
+        return fail("Second fill does not leave 2 of T2's order");
+    }
+
+    // An amend that crosses trades like an order and continues the count.
+    const OrderId fourth = engine.ProcessOrder(engine.ParseInput("T4 B 1 99"));
+    engine.Amend(fourth, 1, 101);
+    if (fills.size() != 3 || fills[2].sequence != 3 ||
+        fills[2].aggressorOrderId != fourth ||
+        fills[2].restingOrderId != second || fills[2].restingRemaining != 1)
+    {
+        return fail("Amend fill missing or out of sequence");
+    }
+
+    // Reports and trade lines are views of the same fills.
+    if (reports.size() != 6 || reports[2].orderId != third ||
+        reports[2].liquidity != 'A' || reports[3].orderId != second ||
+        reports[3].side != 'S' || reports[3].liquidity != 'P')
+    {
+        return fail("Reports do not follow the fills");
+    }
+    TraderRegistry traders;
+    for (const char* name : {"T1", "T2", "T3", "T4"})
+    {
+        static_cast<void>(traders.Intern(name));
+    }
+    TradeFormatter formatter(traders);
+    const std::vector<std::string> trades = engine.GetTrades();
+    if (trades.size() != 2 ||
+        formatter.Format(Span<const Fill>(fills.data(), 2)) != trades[0] ||
+        trades[0] != "T1-3@100 T2-2@101 T3+2@101 T3+3@100" ||
+        formatter.Format(Span<const Fill>(fills.data() + 2, 1)) != trades[1])
+    {
+        return fail("Formatted fills differ from the trade history");
+    }
+    std::cout << "FillStream: Sequenced fills and their views - Passed\n";
+    return TestResult::PASSED;
+}
+
+TestResult testOrderPool()
+{
+    const auto fail = [](const char* reason)
+    {
+        std::cerr << "OrderPool: Failed - " << reason << "\n";
+        return TestResult::FAILED;
+    };
+    static_assert(sizeof(RestingOrder) <= 32 && alignof(RestingOrder) == 32,
+                  "Resting orders must not straddle cache lines");
+
+    OrderPool pool;
+    OrderQueue queue;
+    const auto contents = [&]()
+    {
+        std::vector<OrderId> ids;
+        for (std::uint32_t slot = queue.head; slot != OrderPool::kNil;
+             slot = pool[slot].next)
+        {
+            ids.push_back(pool[slot].orderId);
+        }
+        return ids;
+    };
+
+    const std::uint32_t first = pool.PushBack(queue, 1, 10, 101);
+    const std::uint32_t second = pool.PushBack(queue, 2, 20, 102);
+    const std::uint32_t third = pool.PushBack(queue, 3, 30, 103);
+    if (contents() != std::vector<OrderId>{101, 102, 103} ||
+        reinterpret_cast<std::uintptr_t>(&pool[second]) % 32 != 0)
+    {
+        return fail("Orders not queued in arrival order");
+    }
+
+    pool.Remove(queue, second);
+    if (contents() != std::vector<OrderId>{101, 103} ||
+        pool[third].prev != first || pool[first].next != third)
+    {
+        return fail("Removing from the middle broke the links");
+    }
+
+    // A freed slot is handed out again before the pool grows.
+    if (pool.PushBack(queue, 4, 40, 104) != second ||
+        contents() != std::vector<OrderId>{101, 103, 104})
+    {
+        return fail("Freed slot not reused at the back of the queue");
+    }
+    pool.Remove(queue, first);
+    pool.Remove(queue, third);
+    pool.Remove(queue, second);
+    if (queue.head != OrderPool::kNil || queue.tail != OrderPool::kNil)
+    {
+        return fail("Emptied queue still has a head or tail");
+    }
+    std::cout << "OrderPool: Slot queues and reuse - Passed\n";
+    return TestResult::PASSED;
+}
+
+#ifdef __linux__
+TestResult testJournalFailure()
+{
+    const auto fail = [](const char* reason)
+    {
+        std::cerr << "JournalFailure: Failed - " << reason << "\n";
+        return TestResult::FAILED;
+    };
+
+    TradeEngine engine(BookType::Ladder);
+    std::vector<Fill> fills;
+    engine.SetFillSink([&fills](const Fill* data, const std::size_t count)
+                       { fills.insert(fills.end(), data, data + count); });
+    engine.ProcessOrder(engine.ParseInput("T1 S 5 100"));
+    engine.ProcessOrder(engine.ParseInput("T2 B 1 90"));
+
+    // Every write to /dev/full fails with ENOSPC. The group holds the
+    // settings the journal starts with and the order.
+    engine.OpenJournal("/dev/full", JournalOptions{2, false});
+    try
+    {
+        engine.ProcessOrder(engine.ParseInput("T2 B 3 100"));
+        return fail("Failed journal write did not throw");
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    if (fills.size() != 1 || fills[0].quantity != 3)
+    {
+        return fail("Fills of the order were not published");
+    }
+
+    const std::filesystem::path journalPath =
+        std::filesystem::temp_directory_path() /
+        ("journal_failure_test." + std::to_string(::getpid()) + ".log");
+    engine.OpenJournal(journalPath.string(), JournalOptions{1, false});
+    fills.clear();
+    engine.ProcessOrder(engine.ParseInput("T2 B 1 100"));
+    std::filesystem::remove(journalPath);
+    if (fills.size() != 1 || fills[0].sequence != 2 ||
+        fills[0].quantity != 1)
+    {
+        return fail("Fills of the failed order leaked into the next one");
+    }
+    if (describeBook(engine.GetSellOrders()) != "T1 S 1 100\n")
+    {
+        return fail("Book does not hold the failed order's trade");
+    }
+    std::cout << "JournalFailure: Fills published on a failed write - "
+                 "Passed\n";
+    return TestResult::PASSED;
+}
+#endif
+
 void runTest(TestResult (*testFunc)(), const std::string& testName, int& passedCount, int& notCompletedCount, int& failedCount, int& totalCount)
 {
     totalCount++;
@@ -375,6 +2591,78 @@ int main(int argc, char* argv[])
         runTest(testTransactions2, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
     else if (testName == "testTransactions3")
         runTest(testTransactions3, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testTransactionsLadder")
+        runTest(testTransactionsLadder, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testLadderBookDepth")
+        runTest(testLadderBookDepth, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testTradeSinkStreaming")
+        runTest(testTradeSinkStreaming, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testFastParser")
+        runTest(testFastParser, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testStartSkipsBadLines")
+        runTest(testStartSkipsBadLines, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testTraderInterning")
+        runTest(testTraderInterning, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testCollectTradesOrdering")
+        runTest(testCollectTradesOrdering, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testSpscQueue")
+        runTest(testSpscQueue, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testShardedEngine")
+        runTest(testShardedEngine, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testBookSnapshots")
+        runTest(testBookSnapshots, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testSnapshotConcurrentReader")
+        runTest(testSnapshotConcurrentReader, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testOrderIndex")
+        runTest(testOrderIndex, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testCancelOrder")
+        runTest(testCancelOrder, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testAmendOrder")
+        runTest(testAmendOrder, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testBinaryProtocol")
+        runTest(testBinaryProtocol, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testReplayOrders")
+        runTest(testReplayOrders, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testJournalRestore")
+        runTest(testJournalRestore, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testNoAllocationAfterWarmUp")
+        runTest(testNoAllocationAfterWarmUp, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testLatencyHistogram")
+        runTest(testLatencyHistogram, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testEngineStats")
+        runTest(testEngineStats, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testProcessOrdersBatch")
+        runTest(testProcessOrdersBatch, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testOrderTypes")
+        runTest(testOrderTypes, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testLevelTotals")
+        runTest(testLevelTotals, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testMarketDataFeed")
+        runTest(testMarketDataFeed, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testMarketDataSweep")
+        runTest(testMarketDataSweep, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testStartPipeline")
+        runTest(testStartPipeline, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testMatchingKernel")
+        runTest(testMatchingKernel, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testSelfTradePrevention")
+        runTest(testSelfTradePrevention, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testRiskLimits")
+        runTest(testRiskLimits, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testOccupancyBitmap")
+        runTest(testOccupancyBitmap, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+#ifdef __linux__
+    else if (testName == "testOrderGateway")
+        runTest(testOrderGateway, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+#endif
+    else if (testName == "testFillStream")
+        runTest(testFillStream, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+    else if (testName == "testOrderPool")
+        runTest(testOrderPool, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+#ifdef __linux__
+    else if (testName == "testJournalFailure")
+        runTest(testJournalFailure, testName, passed_tests, not_completed_tests, failed_tests, total_tests);
+#endif
     else
     {
         std::cerr << "Unknown test: " << testName << "\n";
@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "BenchSupport.hpp"
+#include "Gateway.hpp"
+
+using namespace Trading;
+
+namespace
+{
+constexpr std::uint64_t kMidPrice = 1000;
+
+struct Options
+{
+    int tcpPort = 9100;
+    std::string unixPath;
+    std::size_t connections = 64;
+    std::size_t orders = 10000;
+    // Orders a connection keeps in flight; 1 measures pure round trips.
+    std::size_t window = 1;
+    bool binary = false;
+    std::uint64_t seed = 1;
+};
+
+struct Connection
+{
+    int fd = -1;
+    std::string trader;
+    std::size_t sent = 0;
+    std::size_t done = 0;
+    // Send times of the orders still waiting for their OK or REJ.
+    std::deque<LatencyStats::Clock::time_point> inFlight;
+    std::string input;
+    std::string output;
+    std::size_t written = 0;
+};
+
+int Connect(const Options& options)
+{
+    int fd = -1;
+    int result = -1;
+    if (!options.unixPath.empty())
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.unixPath.c_str(),
+                     sizeof(address.sun_path) - 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                           sizeof(address));
+    }
+    else
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(options.tcpPort));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        result = ::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                           sizeof(address));
+        const int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+    if (fd < 0 || result != 0)
+    {
+        throw std::runtime_error(std::string("Cannot connect: ") +
+                                 std::strerror(errno));
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Writes what the socket takes; false if the gateway went away.
+bool Flush(Connection& connection)
+{
+    while (connection.written < connection.output.size())
+    {
+        const ssize_t sent = ::send(
+            connection.fd, connection.output.data() + connection.written,
+            connection.output.size() - connection.written, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        connection.written += static_cast<std::size_t>(sent);
+    }
+    connection.output.clear();
+    connection.written = 0;
+    return true;
+}
+
+// Queues orders until the window is full or all have been sent.
+void Refill(Connection& connection, const Options& options,
+            SplitMix64& rng)
+{
+    while (connection.inFlight.size() < options.window &&
+           connection.sent < options.orders)
+    {
+        const char side = rng.Next() & 1 ? 'B' : 'S';
+        const std::uint64_t quantity = rng.Between(1, 100);
+        const std::uint64_t price = rng.Between(kMidPrice - 10, kMidPrice + 10);
+        if (options.binary)
+        {
+            char data[kOrderMessageSize];
+            EncodeOrder(OrderMessage{0, price, quantity, 0, side,
+                                     OrderType::Limit, {}},
+                        data);
+            connection.output.append(data, sizeof(data));
+        }
+        else
+        {
+            connection.output += connection.trader + ' ' + side + ' ' +
+                                 std::to_string(quantity) + ' ' +
+                                 std::to_string(price) + '\n';
+        }
+        connection.inFlight.push_back(LatencyStats::Clock::now());
+        ++connection.sent;
+    }
+}
+
+// Consumes the complete responses in the connection's input. Returns the
+// number of fills seen; completed orders are added to stats.
+std::size_t Consume(Connection& connection, const Options& options,
+                    LatencyStats& stats, std::size_t& rejected)
+{
+    std::size_t fills = 0;
+    std::size_t used = 0;
+    const auto complete = [&](const bool rejectedOrder)
+    {
+        stats.Add(connection.inFlight.front(), LatencyStats::Clock::now());
+        connection.inFlight.pop_front();
+        ++connection.done;
+        rejected += rejectedOrder ? 1 : 0;
+    };
+
+    if (options.binary)
+    {
+        for (; connection.input.size() - used >= kExecutionReportSize;
+             used += kExecutionReportSize)
+        {
+            const ExecutionReport report =
+                DecodeReport(connection.input.data() + used);
+            if (report.liquidity == kReportAccepted ||
+                report.liquidity == kReportRejected)
+            {
+                complete(report.liquidity == kReportRejected);
+            }
+            else
+            {
+                ++fills;
+            }
+        }
+    }
+    else
+    {
+        for (;;)
+        {
+            const std::size_t end = connection.input.find('\n', used);
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            const char* const line = connection.input.data() + used;
+            if (std::strncmp(line, "OK ", 3) == 0)
+            {
+                complete(false);
+            }
+            else if (std::strncmp(line, "REJ", 3) == 0)
+            {
+                complete(true);
+            }
+            else
+            {
+                ++fills;
+            }
+            used = end + 1;
+        }
+    }
+    connection.input.erase(0, used);
+    return fills;
+}
+}  // namespace
+
+// Opens many sessions to a running OrderGateway, sends random limit orders
+// around a fixed price from all of them, and reports the round trip from
+// writing an order to reading its OK or REJ.
+// Usage: GatewayLoadGenerator [--tcp <port> | --unix <socket path>]
+//            [--connections N] [--orders N per connection] [--window N]
+//            [--binary] [--seed S]
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--tcp") == 0 && hasValue)
+        {
+            options.tcpPort = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--unix") == 0 && hasValue)
+        {
+            options.unixPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--connections") == 0 && hasValue)
+        {
+            options.connections = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--orders") == 0 && hasValue)
+        {
+            options.orders = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--window") == 0 && hasValue)
+        {
+            options.window = std::max<std::size_t>(std::stoull(argv[++i]), 1);
+        }
+        else if (std::strcmp(argv[i], "--binary") == 0)
+        {
+            options.binary = true;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            options.seed = std::stoull(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--tcp <port> | --unix <socket path>]"
+                         " [--connections N] [--orders N] [--window N]"
+                         " [--binary] [--seed S]"
+                      << std::endl;
+            return 2;
+        }
+    }
+
+    try
+    {
+        const int epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        std::vector<Connection> connections(options.connections);
+        for (std::size_t i = 0; i < connections.size(); ++i)
+        {
+            Connection& connection = connections[i];
+            connection.fd = Connect(options);
+            connection.trader = "L" + std::to_string(i);
+            if (options.binary)
+            {
+                const auto length =
+                    static_cast<std::uint32_t>(connection.trader.size());
+                connection.output.append(kGatewayBinaryMagic,
+                                         sizeof(kGatewayBinaryMagic));
+                connection.output.append(reinterpret_cast<const char*>(&length),
+                                         sizeof(length));
+                connection.output += connection.trader;
+            }
+            epoll_event event{};
+            event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+            event.data.u64 = i;
+            ::epoll_ctl(epoll, EPOLL_CTL_ADD, connection.fd, &event);
+        }
+
+        SplitMix64 rng(options.seed);
+        LatencyStats stats(options.connections * options.orders);
+        std::size_t fills = 0;
+        std::size_t rejected = 0;
+        std::size_t finished = 0;
+        const auto start = LatencyStats::Clock::now();
+        for (Connection& connection : connections)
+        {
+            Refill(connection, options, rng);
+            Flush(connection);
+        }
+
+        std::vector<epoll_event> events(connections.size());
+        char buffer[64 * 1024];
+        while (finished < connections.size())
+        {
+            const int ready = ::epoll_wait(
+                epoll, events.data(), static_cast<int>(events.size()), -1);
+            for (int i = 0; i < ready; ++i)
+            {
+                Connection& connection = connections[events[i].data.u64];
+                for (;;)
+                {
+                    const ssize_t received =
+                        ::recv(connection.fd, buffer, sizeof(buffer), 0);
+                    if (received > 0)
+                    {
+                        connection.input.append(
+                            buffer, static_cast<std::size_t>(received));
+                        continue;
+                    }
+                    if (received == 0 ||
+                        (errno != EAGAIN && errno != EWOULDBLOCK &&
+                         errno != EINTR))
+                    {
+                        throw std::runtime_error(
+                            "The gateway closed a session");
+                    }
+                    if (errno != EINTR)
+                    {
+                        break;
+                    }
+                }
+
+                const std::size_t before = connection.done;
+                fills += Consume(connection, options, stats, rejected);
+                if (before < options.orders &&
+                    connection.done == options.orders)
+                {
+                    ++finished;
+                }
+                Refill(connection, options, rng);
+                if (!Flush(connection))
+                {
+                    throw std::runtime_error("The gateway closed a session");
+                }
+            }
+        }
+        const std::chrono::duration<double> elapsed =
+            LatencyStats::Clock::now() - start;
+
+        std::cout << options.connections << " "
+                  << (options.binary ? "binary" : "text") << " connections, "
+                  << options.orders << " orders each, window "
+                  << options.window << ": " << fills << " fills, " << rejected
+                  << " rejected\n";
+        stats.Report("round trip", stats.Count(), elapsed.count());
+        for (const Connection& connection : connections)
+        {
+            ::close(connection.fd);
+        }
+        ::close(epoll);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "MarketData.hpp"
+
+using namespace Trading;
+
+namespace
+{
+void PrintLevel(const char* name, const DepthLevel& level)
+{
+    std::cout << name << ' ';
+    if (level.orders == 0)
+    {
+        std::cout << '-';
+    }
+    else
+    {
+        std::cout << level.quantity << '@' << level.price << " ("
+                  << level.orders << " orders)";
+    }
+}
+}  // namespace
+
+// Follows a feed published with TradeMatchingEngine --market-data and
+// prints the best bid and ask whenever they change.
+// Usage: MarketDataMonitor <feed name> [depth levels to print]
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <feed name> [depth]\n";
+        return 2;
+    }
+    const std::size_t depth = argc > 2 ? std::stoull(argv[2]) : 0;
+
+    try
+    {
+        MarketDataReader reader(argv[1]);
+        DepthBook book;
+        reader.Sync(book);
+        DepthLevel bid{};
+        DepthLevel ask{};
+        for (;;)
+        {
+            const ReadStatus status = reader.Poll(book);
+            if (status == ReadStatus::Lapped)
+            {
+                std::cerr << "Fell behind at update " << book.Sequence()
+                          << ", resynchronising\n";
+                reader.Sync(book);
+                continue;
+            }
+
+            const DepthLevel& newBid = book.BestBid();
+            const DepthLevel& newAsk = book.BestAsk();
+            if (newBid.price != bid.price || newBid.quantity != bid.quantity ||
+                newAsk.price != ask.price || newAsk.quantity != ask.quantity)
+            {
+                bid = newBid;
+                ask = newAsk;
+                std::cout << '#' << book.Sequence() << ' ';
+                PrintLevel("bid", bid);
+                std::cout << "  ";
+                PrintLevel("ask", ask);
+                std::cout << '\n';
+
+                std::size_t printed = 0;
+                for (auto level = book.Bids().rbegin();
+                     level != book.Bids().rend() && printed < depth;
+                     ++level, ++printed)
+                {
+                    std::cout << "    ";
+                    PrintLevel("bid", level->second);
+                    std::cout << '\n';
+                }
+                printed = 0;
+                for (auto level = book.Asks().begin();
+                     level != book.Asks().end() && printed < depth;
+                     ++level, ++printed)
+                {
+                    std::cout << "    ";
+                    PrintLevel("ask", level->second);
+                    std::cout << '\n';
+                }
+                std::cout.flush();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
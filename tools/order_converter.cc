@@ -0,0 +1,129 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BinaryProtocol.hpp"
+#include "OrderParser.hpp"
+#include "TraderRegistry.hpp"
+
+using namespace Trading;
+
+namespace
+{
+// Converts order lines, as ParseOrder reads them, to a binary order file.
+// Lines the engine would skip are skipped here too, so orderId is the id
+// the engine will assign to each message unless it rejects the order.
+int TextToBinary(std::istream& in, std::ostream& out)
+{
+    TraderRegistry traders;
+    std::vector<OrderMessage> messages;
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        OrderView order{};
+        const ParseStatus status = ParseOrder(line, order);
+        if (status == ParseStatus::Empty)
+        {
+            continue;
+        }
+        if (status != ParseStatus::Ok)
+        {
+            std::cerr << "Skipping line " << lineNumber << ": "
+                      << ToString(status) << '\n';
+            continue;
+        }
+        messages.push_back({messages.size() + 1,
+                            order.price,
+                            order.quantity,
+                            traders.Intern(order.identifier),
+                            order.side,
+                            order.type,
+                            {}});
+    }
+
+    std::vector<std::string> names;
+    names.reserve(traders.Size());
+    for (TraderId id = 0; id < traders.Size(); ++id)
+    {
+        names.emplace_back(traders.Name(id));
+    }
+    WriteOrderFileHeader(out, names);
+
+    char buffer[kOrderMessageSize];
+    for (const OrderMessage& message : messages)
+    {
+        EncodeOrder(message, buffer);
+        out.write(buffer, sizeof(buffer));
+    }
+    return 0;
+}
+
+int BinaryToText(std::istream& in, std::ostream& out)
+{
+    const std::vector<std::string> traders = ReadOrderFileHeader(in);
+    char buffer[kOrderMessageSize];
+    while (in.read(buffer, sizeof(buffer)))
+    {
+        const OrderMessage message = DecodeOrder(buffer);
+        if (message.trader >= traders.size())
+        {
+            std::cerr << "Unknown trader id " << message.trader << '\n';
+            return 1;
+        }
+        out << traders[message.trader] << ' ' << message.side << ' '
+            << message.quantity << ' ';
+        if (message.type == OrderType::Market)
+        {
+            out << OrderTypeSuffix(message.type) << '\n';
+            continue;
+        }
+        out << message.price;
+        if (message.type != OrderType::Limit)
+        {
+            out << ' ' << OrderTypeSuffix(message.type);
+        }
+        out << '\n';
+    }
+    if (in.gcount() != 0)
+    {
+        std::cerr << "Ignoring truncated message at end of file\n";
+    }
+    return 0;
+}
+}  // namespace
+
+// Usage: OrderConverter to-binary|to-text <input> <output>
+int main(int argc, char* argv[])
+{
+    if (argc != 4 || (std::strcmp(argv[1], "to-binary") != 0 &&
+                      std::strcmp(argv[1], "to-text") != 0))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " to-binary|to-text <input> <output>\n";
+        return 2;
+    }
+
+    const bool toBinary = std::strcmp(argv[1], "to-binary") == 0;
+    std::ifstream in(argv[2], toBinary ? std::ios::in : std::ios::binary);
+    std::ofstream out(argv[3], toBinary ? std::ios::binary : std::ios::out);
+    if (!in || !out)
+    {
+        std::cerr << "Error: Cannot open " << (in ? argv[3] : argv[2]) << '\n';
+        return 1;
+    }
+
+    try
+    {
+        return toBinary ? TextToBinary(in, out) : BinaryToText(in, out);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+}
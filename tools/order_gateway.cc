@@ -0,0 +1,98 @@
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Gateway.hpp"
+#include "TradeEngine.hpp"
+
+using namespace Trading;
+
+namespace
+{
+OrderGateway* g_gateway = nullptr;
+
+extern "C" void HandleSignal(int)
+{
+    if (g_gateway != nullptr)
+    {
+        g_gateway->Stop();
+    }
+}
+}  // namespace
+
+// Accepts order sessions until interrupted, see OrderGateway for the
+// protocol. Listens on loopback TCP port 9100 unless told otherwise.
+// Usage: OrderGateway [--tcp <port>] [--unix <socket path>]
+//                     [--book tree|ladder] [--market-data <feed name>]
+int main(int argc, char* argv[])
+{
+    GatewayOptions options;
+    BookType bookType = BookType::Tree;
+    const char* feedName = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--tcp") == 0 && i + 1 < argc)
+        {
+            options.tcpPort = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--unix") == 0 && i + 1 < argc)
+        {
+            options.unixPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--book") == 0 && i + 1 < argc)
+        {
+            bookType = std::strcmp(argv[++i], "ladder") == 0 ? BookType::Ladder
+                                                             : BookType::Tree;
+        }
+        else if (std::strcmp(argv[i], "--market-data") == 0 && i + 1 < argc)
+        {
+            feedName = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--tcp <port>] [--unix <socket path>]"
+                         " [--book tree|ladder] [--market-data <feed name>]"
+                      << std::endl;
+            return 2;
+        }
+    }
+    if (options.tcpPort < 0 && options.unixPath.empty())
+    {
+        options.tcpPort = 9100;
+    }
+
+    try
+    {
+        // Only the event loop thread touches the engine.
+        TradeEngine engine(bookType, ConcurrencyMode::SingleWriter);
+        engine.SetTradeHistory(false);
+        if (feedName != nullptr)
+        {
+            engine.OpenMarketData(feedName);
+        }
+
+        OrderGateway gateway(engine, options);
+        g_gateway = &gateway;
+        std::signal(SIGINT, HandleSignal);
+        std::signal(SIGTERM, HandleSignal);
+        if (gateway.TcpPort() != 0)
+        {
+            std::cerr << "Listening on 127.0.0.1:" << gateway.TcpPort()
+                      << std::endl;
+        }
+        if (!options.unixPath.empty())
+        {
+            std::cerr << "Listening on " << options.unixPath << std::endl;
+        }
+        gateway.Run();
+        g_gateway = nullptr;
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}